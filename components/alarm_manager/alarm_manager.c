@@ -6,13 +6,25 @@
 #include "freertos/task.h"
 #include "freertos/timers.h"
 #include "time_manager.h"
+#include "event_dispatcher.h"
+#include "alarm_schedule.h"
+#include "trace.h"
+#include "esp_timer.h"
+#include <stdio.h>
 #include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "alarm_manager";
 
 #define MAX_ALARMS 8
-#define STORAGE_KEY "alarms_blob"
+#define LEGACY_STORAGE_KEY "alarms_blob"
 
 #define MAX_DURATION_TIMERS 8
 
+#define ALARM_MAX_SLEEP_S       900   // re-evaluate at least this often (clock steps)
+#define ALARM_UNSYNCED_POLL_MS  5000  // until the clock is trustworthy
+#define ALARM_WAKE_MARGIN_MS    20    // land just inside the due second
+
 typedef struct {
     bool in_use;
     TimerHandle_t h;
@@ -24,11 +36,18 @@ typedef struct {
 
 static duration_timer_t s_timers[MAX_DURATION_TIMERS];
 
-typedef struct {
+/* Persisted format: one compact record per alarm slot, stored under its own
+ * key ("alarm0".."alarm7") so a change rewrites only that slot. */
+#define ALARM_RECORD_VERSION 1
+#define ALARM_RECORD_ACTIVE  0x01
+#define ALARM_FLUSH_DELAY_MS 2000   // coalesce bursts of edits into one flush
+
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t flags;
+    uint8_t day, hour, minute, second;   // day 0xFF = every day
     char id[16];
-    int day, hour, minute, second;
-    bool active;
-} alarm_persist_t;
+} alarm_record_t;
 
 typedef struct {
     char id[16];
@@ -36,102 +55,349 @@ typedef struct {
     alarm_callback_t cb;
     void *user_data;
     bool active;
+    time_t next_fire;   // absolute instant of the next firing; 0 = recompute
+    time_t last_fired;  // guards against double-firing of one instant
 } alarm_entry_t;
 
+_Static_assert(sizeof(((alarm_record_t *)0)->id) == sizeof(((alarm_entry_t *)0)->id),
+               "record and entry ids are copied as whole fields");
+
 static alarm_entry_t s_alarms[MAX_ALARMS];
+static alarm_record_t s_persisted[MAX_ALARMS]; // what flash currently holds
+static uint32_t s_dirty = 0;                    // bitmask of slots to flush
+static uint32_t s_edited = 0;                   // slots changed since alarm_tick's snapshot
+static TimerHandle_t s_flush_timer = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;   // s_alarms, s_dirty, s_edited
+static dispatch_timer_t s_tick = DISPATCH_TIMER_INVALID;
+static alarm_stats_t s_stats = {0};
+static volatile int64_t s_next_wake_us = -1;
+static volatile bool s_recompute = false;      // clock/TZ changed: rebuild next_fire
+static alarm_callback_t s_default_cb = NULL;
+static void *s_default_user = NULL;
+
+static void slot_key(int slot, char *key, size_t len) {
+    snprintf(key, len, "alarm%d", slot);
+}
+
+static void record_from_entry(const alarm_entry_t *e, alarm_record_t *rec) {
+    memset(rec, 0, sizeof(*rec));
+    if (!e->active) return;   // inactive slots are represented by an absent key
+    rec->version = ALARM_RECORD_VERSION;
+    rec->flags = ALARM_RECORD_ACTIVE;
+    rec->day = (uint8_t)e->time.day;
+    rec->hour = (uint8_t)e->time.hour;
+    rec->minute = (uint8_t)e->time.minute;
+    rec->second = (uint8_t)e->time.second;
+    memcpy(rec->id, e->id, sizeof(rec->id));   // NUL-padded by alarm_manager_set_alarm
+}
 
 static void alarm_save_nvs(void) {
-    alarm_persist_t persist[MAX_ALARMS] = {0};
+    alarm_record_t pending[MAX_ALARMS];
+    uint32_t dirty;
+
+    taskENTER_CRITICAL(&s_lock);
+    dirty = s_dirty;
+    s_dirty = 0;
     for (int i = 0; i < MAX_ALARMS; i++) {
-        strncpy(persist[i].id, s_alarms[i].id, sizeof(persist[i].id)-1);
-        persist[i].day = s_alarms[i].time.day;
-        persist[i].hour = s_alarms[i].time.hour;
-        persist[i].minute = s_alarms[i].time.minute;
-        persist[i].second = s_alarms[i].time.second;
-        persist[i].active = s_alarms[i].active;
+        if (dirty & (1U << i)) record_from_entry(&s_alarms[i], &pending[i]);
     }
-    storage_manager_set_blob(STORAGE_KEY, persist, sizeof(persist));
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!dirty) return;
+    storage_manager_begin();   // all changed slots land in a single commit
+    for (int i = 0; i < MAX_ALARMS; i++) {
+        if (!(dirty & (1U << i))) continue;
+        if (memcmp(&pending[i], &s_persisted[i], sizeof(alarm_record_t)) == 0) continue;
+
+        char key[12];
+        slot_key(i, key, sizeof(key));
+        bool ok = (pending[i].flags & ALARM_RECORD_ACTIVE)
+                  ? storage_manager_set_blob(key, &pending[i], sizeof(pending[i]))
+                  : storage_manager_erase(key);
+        if (ok) {
+            s_persisted[i] = pending[i];
+        } else {
+            ESP_LOGW(TAG, "Failed to persist alarm slot %d", i);
+        }
+    }
+    storage_manager_commit();
+}
+
+static void flush_job(void *arg) {
+    (void)arg;
+    alarm_save_nvs();
+}
+
+static void flush_timer_cb(TimerHandle_t xTimer) {
+    (void)xTimer;
+    // Flash writes can take tens of ms; keep them off the timer service task
+    if (!event_dispatcher_post(flush_job, NULL, DISPATCH_PRIO_LOW, "alarm_flush")) {
+        xTimerReset(s_flush_timer, 0);  // queue full, retry after another window
+    }
+}
+
+/* Called with s_lock held right after editing a slot */
+static void alarm_mark_dirty_locked(int slot) {
+    s_dirty |= (1U << slot);
+    s_edited |= (1U << slot);
+}
+
+static void alarm_schedule_flush(void) {
+    // (Re)arm the coalescing window; flush happens once edits go quiet
+    if (s_flush_timer) xTimerReset(s_flush_timer, 0);
+    else alarm_save_nvs();
 }
 
 static void alarm_load_nvs(void) {
-    alarm_persist_t persist[MAX_ALARMS] = {0};
-    size_t len = 0;
-    if (storage_manager_get_blob(STORAGE_KEY, persist, sizeof(persist), &len)) {
-        int count = (int)(len / sizeof(alarm_persist_t));
-        if (count > MAX_ALARMS) count = MAX_ALARMS;
-        for (int i = 0; i < count; i++) {
-            strncpy(s_alarms[i].id, persist[i].id, sizeof(s_alarms[i].id)-1);
-            s_alarms[i].time.day = persist[i].day;
-            s_alarms[i].time.hour = persist[i].hour;
-            s_alarms[i].time.minute = persist[i].minute;
-            s_alarms[i].time.second = persist[i].second;
-            s_alarms[i].active = persist[i].active;
-            s_alarms[i].cb = NULL;
-            s_alarms[i].user_data = NULL;
+    for (int i = 0; i < MAX_ALARMS; i++) {
+        char key[12];
+        alarm_record_t rec = {0};
+        size_t len = 0;
+        slot_key(i, key, sizeof(key));
+        if (!storage_manager_get_blob(key, &rec, sizeof(rec), &len)) continue;
+        if (len != sizeof(rec) || rec.version != ALARM_RECORD_VERSION) {
+            ESP_LOGW(TAG, "Dropping alarm slot %d (len=%u ver=%u)", i, (unsigned)len, rec.version);
+            storage_manager_erase(key);
+            continue;
         }
+        if (!(rec.flags & ALARM_RECORD_ACTIVE)) continue;
+
+        rec.id[sizeof(rec.id)-1] = '\0';
+        memcpy(s_alarms[i].id, rec.id, sizeof(s_alarms[i].id));
+        s_alarms[i].time.day = (rec.day == 0xFF) ? -1 : rec.day;
+        s_alarms[i].time.hour = rec.hour;
+        s_alarms[i].time.minute = rec.minute;
+        s_alarms[i].time.second = rec.second;
+        s_alarms[i].active = true;
+        s_alarms[i].cb = NULL;          // resolved to the default callback at fire time
+        s_alarms[i].user_data = NULL;
+        s_persisted[i] = rec;
     }
 }
 
-static void alarm_task(void *arg) {
-    while (1) {
-        struct tm now;
-        if (time_manager_get_local_time(&now)) {
-            for (int i = 0; i < MAX_ALARMS; i++) {
-                // if (s_alarms[i].active)
-                // {
-                //     ESP_LOGI("alarm", "checking alarm D=%d H=%d M=%d S=%d", s_alarms[i].time.day, s_alarms[i].time.hour, s_alarms[i].time.minute, s_alarms[i].time.second);
-                // }
-                if (s_alarms[i].active &&
-                    s_alarms[i].time.day == now.tm_wday &&
-                    s_alarms[i].time.hour == now.tm_hour &&
-                    s_alarms[i].time.minute == now.tm_min &&
-                    s_alarms[i].time.second == now.tm_sec) {
-                    if (s_alarms[i].cb) s_alarms[i].cb(s_alarms[i].user_data);
-                }
+static void fire_alarm(int slot, const alarm_entry_t *e) {
+    TRACE_INSTANT("alarm_due", slot);
+    alarm_callback_t cb = e->cb ? e->cb : s_default_cb;
+    void *ud = e->cb ? e->user_data : s_default_user;
+    // The name must outlive the post, so it points at the slot, not the snapshot
+    if (cb) event_dispatcher_post(cb, ud, DISPATCH_PRIO_HIGH, s_alarms[slot].id);
+    s_stats.fired++;
+}
+
+static time_t next_occurrence(const alarm_entry_t *e, time_t after) {
+    return time_manager_next_occurrence(after, e->time.day, e->time.hour,
+                                        e->time.minute, e->time.second);
+}
+
+/* Dispatcher timer: one scheduling pass, then re-arm for the next due alarm.
+ * The control API edits alarms from the httpd task, so the pass works on a
+ * snapshot taken under s_lock and only writes back slots nobody edited since;
+ * an edit wakes the tick again anyway. */
+static void alarm_tick(void *arg) {
+    (void)arg;
+    TRACE_BEGIN("alarm_tick", s_recompute);
+    s_stats.passes++;
+    uint32_t wait_ms = ALARM_UNSYNCED_POLL_MS;
+    struct tm now_tm;
+    // A clock restored from NVS after power loss can be hours behind; don't
+    // fire (or mark missed) anything on it until RTC-carried or SNTP time.
+    if (time_manager_get_quality() >= TIME_QUALITY_RTC &&
+        time_manager_get_local_time(&now_tm)) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        const time_t now = tv.tv_sec;
+        const bool recompute = s_recompute;
+        s_recompute = false;
+
+        alarm_entry_t snap[MAX_ALARMS];
+        taskENTER_CRITICAL(&s_lock);
+        memcpy(snap, s_alarms, sizeof(snap));
+        s_edited = 0;
+        taskEXIT_CRITICAL(&s_lock);
+
+        time_t next[MAX_ALARMS];
+        bool active[MAX_ALARMS];
+        for (int i = 0; i < MAX_ALARMS; i++) {
+            alarm_entry_t *e = &snap[i];
+            active[i] = e->active;
+            if (!e->active) continue;
+            // "now - 1" so an alarm scheduled for this very second is not skipped
+            if (recompute || e->next_fire == 0) e->next_fire = next_occurrence(e, now - 1);
+
+            switch (alarm_schedule_check(now, e->next_fire)) {
+                case ALARM_DUE:
+                    if (e->last_fired != e->next_fire) {
+                        e->last_fired = e->next_fire;
+                        fire_alarm(i, e);
+                    }
+                    e->next_fire = next_occurrence(e, e->next_fire);
+                    break;
+                case ALARM_MISSED:
+                    ESP_LOGW(TAG, "Alarm '%s' missed by %lld s (clock step?)",
+                             e->id, (long long)(now - e->next_fire));
+                    s_stats.missed++;
+                    e->next_fire = next_occurrence(e, now);
+                    break;
+                default:
+                    break;
             }
+            next[i] = e->next_fire;
+        }
+
+        taskENTER_CRITICAL(&s_lock);
+        for (int i = 0; i < MAX_ALARMS; i++) {
+            if (!active[i]) continue;
+            s_alarms[i].last_fired = snap[i].last_fired;   // still guards a re-added instant
+            if (!(s_edited & (1U << i))) s_alarms[i].next_fire = snap[i].next_fire;
         }
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        taskEXIT_CRITICAL(&s_lock);
+
+        // Sleep until the next due alarm instead of polling at 1 Hz,
+        // so the CPU can stay in light sleep between alarms.
+        uint32_t wait_s = alarm_schedule_next_wait_s(now, next, active, MAX_ALARMS);
+        if (wait_s > ALARM_MAX_SLEEP_S) wait_s = ALARM_MAX_SLEEP_S;
+        uint32_t into_second_ms = (uint32_t)(tv.tv_usec / 1000);
+        wait_ms = (wait_s * 1000U > into_second_ms ? wait_s * 1000U - into_second_ms : 0)
+                  + ALARM_WAKE_MARGIN_MS;
     }
+    s_next_wake_us = esp_timer_get_time() + (int64_t)wait_ms * 1000;
+    event_dispatcher_timer_start_at(s_tick, s_next_wake_us);
+    TRACE_INSTANT("alarm_rearm", wait_ms);
+    TRACE_END("alarm_tick", 0);
 }
 
 void alarm_manager_init(void) {
     memset(s_alarms, 0, sizeof(s_alarms));
-    //alarm_load_nvs(); // dont need to load from nvs as alarms are set on boot
+    memset(s_persisted, 0, sizeof(s_persisted));
+    s_dirty = 0;
+    storage_manager_erase(LEGACY_STORAGE_KEY); // pre-v1 whole-table blob
+    alarm_load_nvs();
+
+    s_flush_timer = xTimerCreate("am_flush", pdMS_TO_TICKS(ALARM_FLUSH_DELAY_MS),
+                                 pdFALSE, NULL, flush_timer_cb);
 
     /* init duration timers table */
     memset(s_timers, 0, sizeof(s_timers));
 
-    xTaskCreate(alarm_task, "alarm_task", 4096, NULL, 5, NULL);
+    event_dispatcher_init();
+
+    s_tick = event_dispatcher_timer_create(alarm_tick, NULL, "alarm_tick");
+    event_dispatcher_timer_start(s_tick, 0, 0);
+}
+
+static void wake_alarm_tick(void) {
+    event_dispatcher_timer_start(s_tick, 0, 0);
+}
+
+/* Called with s_lock held */
+static int find_alarm(const char *id) {
+    for (int i = 0; i < MAX_ALARMS; i++) {
+        if (s_alarms[i].active && strcmp(s_alarms[i].id, id) == 0) return i;
+    }
+    return -1;
 }
 
 bool alarm_manager_set_alarm(const char *id, alarm_time_t time,
                              alarm_callback_t cb, void *user_data) {
-    for (int i = 0; i < MAX_ALARMS; i++) {
-        if (!s_alarms[i].active || strcmp(s_alarms[i].id, id) == 0) {
-            strncpy(s_alarms[i].id, id, sizeof(s_alarms[i].id)-1);
-            s_alarms[i].time = time;
-            s_alarms[i].cb = cb;
-            s_alarms[i].user_data = user_data;
-            s_alarms[i].active = true;
-            //alarm_save_nvs(); //no need to store as alarms are set on boot up
-            return true;
+    taskENTER_CRITICAL(&s_lock);
+    int slot = find_alarm(id);
+    if (slot < 0) {
+        for (int i = 0; i < MAX_ALARMS; i++) {
+            if (!s_alarms[i].active) { slot = i; break; }
         }
     }
-    return false;
+    if (slot < 0) {
+        taskEXIT_CRITICAL(&s_lock);
+        return false;
+    }
+
+    alarm_entry_t *e = &s_alarms[slot];
+    bool changed = !e->active ||
+                   strcmp(e->id, id) != 0 ||
+                   memcmp(&e->time, &time, sizeof(time)) != 0;
+    memset(e->id, 0, sizeof(e->id));
+    strncpy(e->id, id, sizeof(e->id)-1);
+    e->time = time;
+    e->cb = cb;
+    e->user_data = user_data;
+    e->active = true;
+    if (changed) {
+        e->next_fire = 0;
+        alarm_mark_dirty_locked(slot);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (changed) {
+        alarm_schedule_flush();
+        wake_alarm_tick();
+    }
+    return true;
 }
 
 bool alarm_manager_clear_alarm(const char *id) {
+    taskENTER_CRITICAL(&s_lock);
+    int slot = find_alarm(id);
+    if (slot >= 0) {
+        s_alarms[slot].active = false;
+        alarm_mark_dirty_locked(slot);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (slot < 0) return false;
+    alarm_schedule_flush();
+    wake_alarm_tick();
+    return true;
+}
+
+void alarm_manager_set_default_callback(alarm_callback_t cb, void *user_data) {
+    s_default_cb = cb;
+    s_default_user = user_data;
+}
+
+int alarm_manager_count(void) {
+    int n = 0;
+    taskENTER_CRITICAL(&s_lock);
     for (int i = 0; i < MAX_ALARMS; i++) {
-        if (s_alarms[i].active && strcmp(s_alarms[i].id, id) == 0) {
-            s_alarms[i].active = false;
-            alarm_save_nvs();
-            return true;
-        }
+        if (s_alarms[i].active) n++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return n;
+}
+
+int alarm_manager_list(alarm_info_t *out, int max) {
+    int n = 0;
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < MAX_ALARMS && n < max; i++) {
+        const alarm_entry_t *e = &s_alarms[i];
+        if (!e->active) continue;
+        memcpy(out[n].id, e->id, sizeof(out[n].id));
+        out[n].time = e->time;
+        out[n].next_fire = e->next_fire;
+        n++;
     }
-    return false;
+    taskEXIT_CRITICAL(&s_lock);
+    return n;
+}
+
+void alarm_manager_reschedule(void) {
+    TRACE_INSTANT("alarm_reschedule", 0);
+    s_recompute = true;
+    wake_alarm_tick();
+}
+
+void alarm_manager_get_stats(alarm_stats_t *out) {
+    if (out) *out = s_stats;
+}
+
+int64_t alarm_manager_next_wake_us(void) {
+    return s_next_wake_us;
+}
+
+void alarm_manager_flush(void) {
+    if (s_flush_timer) xTimerStop(s_flush_timer, 0);
+    alarm_save_nvs();
 }
 
-/* FreeRTOS timer callback */
+/* FreeRTOS timer callback: runs in the timer service task, so it only hands
+ * the user callback to the dispatcher and never runs it inline. */
 static void duration_timer_cb(TimerHandle_t xTimer) {
     // The timer_id is stored as the timer's ID (pvTimerID)
     intptr_t id = (intptr_t) pvTimerGetTimerID(xTimer);
@@ -151,8 +417,9 @@ static void duration_timer_cb(TimerHandle_t xTimer) {
     dt->user_data = NULL;
     dt->duration_ms = 0;
     dt->start_tick = 0;
+    xTimerDelete(xTimer, 0);
 
-    if (cb) cb(ud);
+    if (cb) event_dispatcher_post(cb, ud, DISPATCH_PRIO_NORMAL, "timer");
 }
 
 /* Find a free duration timer slot */
@@ -2,20 +2,77 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/** Alarm/timer callbacks run in the event_dispatcher worker task, which also
+ *  runs the alarm scheduler itself (no dedicated alarm task). */
 typedef void (*alarm_callback_t)(void *user_data);
 
+/* Local wall-clock time; DST gaps fire shifted forward by the gap, overlaps fire once */
 typedef struct {
-    int day; // 0 = Sunday
+    int day; // 0 = Sunday, -1 = every day
     int hour;
     int minute;
     int second;
 } alarm_time_t;
 
+/**
+ * @brief Init the alarm table and restore alarms persisted in NVS.
+ *
+ * Restored alarms have no callback of their own; they fire the default
+ * callback (see alarm_manager_set_default_callback()) until set_alarm()
+ * is called again with the same id.
+ */
 void alarm_manager_init(void);
+
+/**
+ * @brief Add or update an alarm by id.
+ *
+ * Only slots whose id/time actually changed are written to NVS, and writes are
+ * coalesced over a short window, so re-registering an identical schedule at
+ * boot costs no flash writes.
+ */
 bool alarm_manager_set_alarm(const char *id, alarm_time_t time,
                              alarm_callback_t cb, void *user_data);
 bool alarm_manager_clear_alarm(const char *id);
 
+/* Snapshot of one alarm for listing (e.g. over the control API) */
+typedef struct {
+    char id[16];
+    alarm_time_t time;
+    int64_t next_fire;   // epoch seconds of the next firing; 0 = not yet scheduled
+} alarm_info_t;
+
+/**
+ * Copy the active alarms.
+ * @return number of entries written (<= max)
+ */
+int alarm_manager_list(alarm_info_t *out, int max);
+
+/** Callback used by alarms that have none (e.g. restored from NVS) */
+void alarm_manager_set_default_callback(alarm_callback_t cb, void *user_data);
+
+/** Number of active alarms (including ones restored at init) */
+int alarm_manager_count(void);
+
+/**
+ * @brief Recompute every alarm's next firing instant (after a clock step or
+ * timezone change). The scheduler otherwise sleeps until the next due alarm.
+ */
+void alarm_manager_reschedule(void);
+
+typedef struct {
+    uint32_t fired;         // alarms handed to the dispatcher
+    uint32_t missed;        // skipped after a clock step
+    uint32_t passes;        // scheduler wakeups
+} alarm_stats_t;
+
+void alarm_manager_get_stats(alarm_stats_t *out);
+
+/** esp_timer time (us) of the next scheduler pass, or -1 */
+int64_t alarm_manager_next_wake_us(void);
+
+/** Write any pending alarm changes to NVS now (e.g. before restart) */
+void alarm_manager_flush(void);
+
 /**
  * @brief Start a one-shot timer that expires after duration_ms and fires cb(user_data).
  * @return >=0 timer id on success, -1 on failure.
@@ -0,0 +1,17 @@
+#include "alarm_schedule.h"
+
+alarm_due_t alarm_schedule_check(time_t now, time_t next_fire) {
+    if (next_fire <= 0 || now < next_fire) return ALARM_NOT_DUE;
+    return (now - next_fire) <= ALARM_SCHEDULE_GRACE_S ? ALARM_DUE : ALARM_MISSED;
+}
+
+uint32_t alarm_schedule_next_wait_s(time_t now, const time_t *next_fire,
+                                    const bool *active, int count) {
+    uint32_t best = ALARM_SCHEDULE_NONE;
+    for (int i = 0; i < count; i++) {
+        if (!active[i] || next_fire[i] <= 0) continue;
+        uint32_t s = next_fire[i] > now ? (uint32_t)(next_fire[i] - now) : 0;
+        if (s < best) best = s;
+    }
+    return best;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pure scheduling decisions (no RTOS/IDF dependencies) so they can be exercised on the host.
+ * Alarms carry an absolute next_fire instant computed with
+ * time_manager_next_occurrence(), which already resolves DST gaps/overlaps. */
+
+#define ALARM_SCHEDULE_GRACE_S  120           // fire late by at most this much (e.g. after a clock step)
+#define ALARM_SCHEDULE_NONE     UINT32_MAX
+
+typedef enum {
+    ALARM_NOT_DUE,
+    ALARM_DUE,      // fire now, then advance next_fire
+    ALARM_MISSED    // too late (clock jumped forward); advance without firing
+} alarm_due_t;
+
+alarm_due_t alarm_schedule_check(time_t now, time_t next_fire);
+
+/**
+ * Seconds from `now` until the earliest next_fire among active alarms
+ * (0 if one is already due).
+ * @return ALARM_SCHEDULE_NONE if no alarm is pending
+ */
+uint32_t alarm_schedule_next_wait_s(time_t now, const time_t *next_fire,
+                                    const bool *active, int count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,264 @@
+#include "benchmark.h"
+#include "neopixel_driver.h"
+#include "neopixel_apa102.h"
+#include "anim_kernels.h"
+#include "anim_clip.h"
+#include "alarm_schedule.h"
+#include "time_manager.h"
+#include "trace.h"
+#include "storage_manager.h"
+#include "storage_settings.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "benchmark";
+
+#define BENCH_LEDS      32          // the lamp's strip: 32 x GRBW
+#define BENCH_BPP       4
+#define BENCH_ALARMS    16
+#define BENCH_KEY       "bench"
+#define BENCH_CLIP_FRAMES 16
+
+typedef struct {
+    const char *name;
+    uint32_t iters;                 // per batch, sized for ~1-5 ms on the ESP32
+    bool (*setup)(void);            // NULL or true = run; false = skip
+    void (*op)(uint32_t i);
+} bench_case_t;
+
+static uint8_t s_frame[BENCH_LEDS * BENCH_BPP];
+static uint8_t s_start[BENCH_LEDS * BENCH_BPP];
+static uint8_t s_rgb[BENCH_LEDS * 3];
+static uint8_t s_apa102[4 + BENCH_LEDS * 4 + 4 + (BENCH_LEDS + 15) / 16];
+static neopixel_t s_strip = {
+    .pin = -1, .count = BENCH_LEDS, .pixels = s_frame,
+    .order = NEOPIXEL_ORDER_GRBW, .use_rgbw = true,
+};
+static uint8_t s_clip_image[ANIM_CLIP_HEADER_LEN + BENCH_CLIP_FRAMES * (2 + 5 + BENCH_LEDS * 3)];
+static anim_clip_t s_clip;
+static anim_geometry_t s_ring;
+static time_t s_next_fire[BENCH_ALARMS];
+static bool s_active[BENCH_ALARMS];
+static volatile uint32_t s_sink;    // keeps results observable
+
+static bool setup_frames(void) {
+    for (size_t i = 0; i < sizeof(s_frame); i++) {
+        s_frame[i] = (uint8_t)(i * 37);
+        s_start[i] = (uint8_t)(255 - i * 11);
+    }
+    for (size_t i = 0; i < sizeof(s_rgb); i++) s_rgb[i] = (uint8_t)(i * 53);
+    s_strip.fmt = neopixel_format(s_strip.order);
+    return true;
+}
+
+static void op_encode(uint32_t i) {
+    s_frame[i % sizeof(s_frame)] ^= 0x55;     // a different frame each time
+    s_sink += (uint32_t)neopixel_encode(&s_strip);
+}
+
+/* APA102 frame from the RGB buffer, cap stepping so the global field varies */
+static void op_apa102_encode(uint32_t i) {
+    s_sink += (uint32_t)apa102_encode(s_apa102, sizeof(s_apa102), s_rgb, BENCH_LEDS,
+                                      neopixel_format(NEOPIXEL_ORDER_RGB), (uint8_t)(i | 1));
+}
+
+static void op_hsv(uint32_t i) {
+    uint8_t r, g, b;
+    anim_hsv_to_rgb((float)(i % 3600) * 0.1f, 255, 200, &r, &g, &b);
+    s_sink += r + g + b;
+}
+
+/* The lamp's unit: a ring, so effects index its precomputed angle table */
+static bool setup_ring(void) {
+    const anim_layout_t ring = { .kind = ANIM_LAYOUT_RING };
+    setup_frames();
+    return s_ring.pts || anim_geometry_build(&s_ring, &ring, BENCH_LEDS);
+}
+
+static void op_rainbow(uint32_t i) {
+    anim_rainbow_frame(s_frame, s_strip.fmt, &s_ring, BENCH_LEDS, (float)(i % 360), true, 255, 255);
+    s_sink += s_frame[0];
+}
+
+/* The sweep mode's frame: one colour around the ring, fading to black */
+static void op_sweep(uint32_t i) {
+    static const uint8_t from[4] = { 255, 80, 0, 0 }, to[4] = { 0, 0, 0, 0 };
+    anim_gradient_frame(s_frame, s_strip.fmt, &s_ring, ANIM_AXIS_ANGLE, (uint16_t)(i * 655),
+                        from, to);
+    s_sink += s_frame[0];
+}
+
+static void op_fade(uint32_t i) {
+    static const uint8_t target[4] = { 0, 0, 0, 255 };
+    anim_fade_frame(s_frame, s_start, s_strip.fmt, BENCH_LEDS, target, (float)(i % 100) / 100.0f);
+    s_sink += s_frame[0];
+}
+
+/* The per-LED path the span API replaces, kept for comparison */
+static void op_set_pixel_loop(uint32_t i) {
+    for (int p = 0; p < BENCH_LEDS; p++) neopixel_set_pixel(&s_strip, p, (uint8_t)i, 0, 0, 255);
+    s_sink += s_frame[0];
+}
+
+static void op_fill_range(uint32_t i) {
+    neopixel_fill_range(&s_strip, 0, BENCH_LEDS, (uint8_t)i, 0, 0, 255);
+    s_sink += s_frame[0];
+}
+
+static void op_blit_rgb(uint32_t i) {
+    (void)i;
+    neopixel_blit_rgb(&s_strip, 0, s_rgb, BENCH_LEDS);
+    s_sink += s_frame[0];
+}
+
+/* A gradient rainbow clip: every frame is one full COPY op */
+static bool setup_clip(void) {
+    setup_frames();
+    const neopixel_format_t *rgb = neopixel_format(NEOPIXEL_ORDER_RGB);
+    size_t o = ANIM_CLIP_HEADER_LEN;
+    for (int k = 0; k < BENCH_CLIP_FRAMES; k++) {
+        anim_rainbow_frame(s_rgb, rgb, NULL, BENCH_LEDS, (float)k * 22.5f, true, 255, 255);
+        o += anim_clip_encode_frame(s_clip_image + o, sizeof(s_clip_image) - o, NULL, s_rgb,
+                                    BENCH_LEDS, 3);
+    }
+    anim_clip_info_t info = {
+        .name = "bench", .channels = 3, .leds = BENCH_LEDS, .frame_ms = 20,
+        .flags = ANIM_CLIP_FLAG_LOOP, .frames = BENCH_CLIP_FRAMES,
+        .data_len = (uint32_t)(o - ANIM_CLIP_HEADER_LEN),
+    };
+    anim_clip_write_header(s_clip_image, &info);
+    return anim_clip_parse(s_clip_image, o, &s_clip) != 0;
+}
+
+static void op_clip_frame(uint32_t i) {
+    (void)i;
+    if (!anim_clip_next(&s_clip, s_frame, s_strip.fmt, BENCH_LEDS)) anim_clip_rewind(&s_clip);
+    s_sink += s_frame[0];
+}
+
+/* Ends up in the live ring; it is cleared before a measurement anyway */
+static void op_trace(uint32_t i) {
+    trace_record("bench", TRACE_PH_INSTANT, i);
+}
+
+static bool setup_alarms(void) {
+    const time_t now = 1704714240;          // 2024-01-08 11:44:00 UTC
+    for (int i = 0; i < BENCH_ALARMS; i++) {
+        s_next_fire[i] = now + (i - 2) * 3600;
+        s_active[i] = (i % 3) != 0;
+    }
+    return true;
+}
+
+/* One alarm_tick pass: classify every alarm, then find the next wait */
+static void op_alarm_due(uint32_t i) {
+    const time_t now = 1704714240 + (time_t)(i % 7200);
+    uint32_t due = 0;
+    for (int a = 0; a < BENCH_ALARMS; a++) {
+        if (s_active[a] && alarm_schedule_check(now, s_next_fire[a]) != ALARM_NOT_DUE) due++;
+    }
+    s_sink += due + alarm_schedule_next_wait_s(now, s_next_fire, s_active, BENCH_ALARMS);
+}
+
+static bool setup_local_time(void) {
+    struct tm tm;
+    return time_manager_get_local_time(&tm);    // skipped until the clock is set
+}
+
+static void op_local_time(uint32_t i) {
+    (void)i;
+    struct tm tm;
+    time_manager_get_local_time(&tm);
+    s_sink += (uint32_t)tm.tm_sec;
+}
+
+static bool setup_settings(void) {
+    return storage_settings_set(BENCH_KEY, 0);
+}
+
+static void op_settings_get(uint32_t i) {
+    (void)i;
+    s_sink += (uint32_t)storage_settings_get(BENCH_KEY, 0);
+}
+
+static void op_settings_set(uint32_t i) {
+    storage_settings_set(BENCH_KEY, (int32_t)(i & 1));   // changes every call
+}
+
+static bool setup_storage(void) {
+    return storage_manager_set_u32(BENCH_KEY, 42);
+}
+
+static void op_storage_get(uint32_t i) {
+    (void)i;
+    uint32_t v = 0;
+    storage_manager_get_u32(BENCH_KEY, &v);
+    s_sink += v;
+}
+
+static const bench_case_t s_cases[] = {
+    { "neopixel_encode_32rgbw", 100, setup_frames, op_encode },
+    { "apa102_encode_32", 200, setup_frames, op_apa102_encode },
+    { "hsv_to_rgb", 1000, NULL, op_hsv },
+    { "rainbow_frame_32", 100, setup_ring, op_rainbow },
+    { "sweep_frame_32", 200, setup_ring, op_sweep },
+    { "fade_frame_32", 200, setup_frames, op_fade },
+    { "clip_frame_32", 200, setup_clip, op_clip_frame },
+    { "set_pixel_loop_32", 200, setup_frames, op_set_pixel_loop },
+    { "fill_range_32", 200, setup_frames, op_fill_range },
+    { "blit_rgb_32", 200, setup_frames, op_blit_rgb },
+    { "trace_record", 1000, NULL, op_trace },
+    { "alarm_due_check_16", 1000, setup_alarms, op_alarm_due },
+    { "local_time", 1000, setup_local_time, op_local_time },
+    { "settings_get", 1000, setup_settings, op_settings_get },
+    { "settings_set", 1000, setup_settings, op_settings_set },
+    { "storage_get_u32", 50, setup_storage, op_storage_get },
+};
+
+static int64_t default_clock_ns(void) {
+    return esp_timer_get_time() * 1000;
+}
+
+int benchmark_run(const benchmark_config_t *cfg, benchmark_result_t *out, int max) {
+    const benchmark_config_t defaults = {0};
+    if (!cfg) cfg = &defaults;
+    benchmark_clock_fn_t clock = cfg->clock ? cfg->clock : default_clock_ns;
+    const uint32_t scale = cfg->scale ? cfg->scale : 1;
+    const int batches = cfg->batches > 0 ? cfg->batches : BENCHMARK_DEFAULT_BATCHES;
+
+    int n = 0;
+    for (size_t c = 0; c < sizeof(s_cases) / sizeof(s_cases[0]) && n < max; c++) {
+        const bench_case_t *bc = &s_cases[c];
+        if (cfg->filter && !strstr(bc->name, cfg->filter)) continue;
+        if (bc->setup && !bc->setup()) {
+            ESP_LOGW(TAG, "%s: skipped (precondition not met)", bc->name);
+            continue;
+        }
+        const uint32_t iters = bc->iters * scale;
+        for (uint32_t i = 0; i < iters / 10 + 1; i++) bc->op(i);     // warm caches
+        int64_t best = INT64_MAX;
+        for (int b = 0; b < batches; b++) {
+            const int64_t t0 = clock();
+            for (uint32_t i = 0; i < iters; i++) bc->op(i);
+            const int64_t dt = clock() - t0;
+            if (dt < best) best = dt;
+        }
+        benchmark_result_t *r = &out[n++];
+        strncpy(r->name, bc->name, sizeof(r->name) - 1);
+        r->name[sizeof(r->name) - 1] = '\0';
+        r->iters = iters;
+        r->ns_per_op = (double)best / iters;
+    }
+    return n;
+}
+
+void benchmark_run_and_log(void) {
+    benchmark_result_t results[BENCHMARK_MAX_CASES];
+    const int n = benchmark_run(NULL, results, BENCHMARK_MAX_CASES);
+    char line[BENCHMARK_JSON_LEN];
+    for (int i = 0; i < n; i++) {
+        if (benchmark_format_json(&results[i], line, sizeof(line)) > 0) ESP_LOGI(TAG, "%s", line);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Micro-benchmarks for the hot paths: LED encode, HSV conversion, the fade
+ * and rainbow frame kernels, the alarm due-check, local time and the
+ * settings/storage get/set. Each case runs a fixed number of iterations per
+ * batch; the best batch is reported as ns/op. Results are printed as one JSON
+ * object per line so the host runner (host/bench_main.c) can check a device
+ * log against a baseline as well as its own run. */
+
+#define BENCHMARK_MAX_CASES       16
+#define BENCHMARK_NAME_LEN        24
+#define BENCHMARK_DEFAULT_BATCHES 5
+#define BENCHMARK_JSON_LEN        96
+
+typedef struct {
+    char name[BENCHMARK_NAME_LEN];
+    uint32_t iters;             // per batch
+    double ns_per_op;           // best batch
+} benchmark_result_t;
+
+/** Monotonic clock in ns */
+typedef int64_t (*benchmark_clock_fn_t)(void);
+
+typedef struct {
+    benchmark_clock_fn_t clock; // NULL = esp_timer_get_time()
+    uint32_t scale;             // multiplies every case's iteration count (0 = 1)
+    int batches;                // best of; 0 = BENCHMARK_DEFAULT_BATCHES
+    const char *filter;         // run only cases whose name contains this; NULL = all
+} benchmark_config_t;
+
+/**
+ * Run the cases. Call before the render task starts: the encode case uses the
+ * LED driver's symbol buffer. Cases whose precondition is missing (e.g. no
+ * valid clock for local time) are skipped.
+ * @param cfg  NULL for defaults
+ * @return number of results written
+ */
+int benchmark_run(const benchmark_config_t *cfg, benchmark_result_t *out, int max);
+
+/** Run with defaults and log every result as a JSON line (CONFIG_BENCHMARK_ON_BOOT) */
+void benchmark_run_and_log(void);
+
+/** {"bench":"name","iters":N,"ns_per_op":X}; returns length or -1 if it does not fit */
+int benchmark_format_json(const benchmark_result_t *r, char *buf, size_t len);
+
+/** Parse a result line produced by benchmark_format_json (anywhere in `line`, e.g. after a log prefix) */
+bool benchmark_parse_json(const char *line, benchmark_result_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,27 @@
+#include "benchmark.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int benchmark_format_json(const benchmark_result_t *r, char *buf, size_t len) {
+    int n = snprintf(buf, len, "{\"bench\":\"%s\",\"iters\":%u,\"ns_per_op\":%.1f}",
+                     r->name, (unsigned)r->iters, r->ns_per_op);
+    return (n < 0 || (size_t)n >= len) ? -1 : n;
+}
+
+bool benchmark_parse_json(const char *line, benchmark_result_t *out) {
+    const char *p = strstr(line, "{\"bench\":\"");
+    if (!p) return false;
+    p += strlen("{\"bench\":\"");
+    const char *q = strchr(p, '"');
+    if (!q || q == p || (size_t)(q - p) >= sizeof(out->name)) return false;
+    memcpy(out->name, p, (size_t)(q - p));
+    out->name[q - p] = '\0';
+
+    unsigned iters;
+    double ns;
+    if (sscanf(q, "\",\"iters\":%u,\"ns_per_op\":%lf}", &iters, &ns) != 2) return false;
+    out->iters = iters;
+    out->ns_per_op = ns;
+    return true;
+}
@@ -0,0 +1,134 @@
+#include "button_gesture.h"
+#include <string.h>
+
+void button_gesture_init(button_gesture_t *g, const button_gesture_cfg_t *cfg,
+                         int level, int64_t now_us) {
+    memset(g, 0, sizeof(*g));
+    g->cfg = *cfg;
+    g->stable = g->raw = level;
+    g->stable_t = g->raw_t = now_us - (int64_t)cfg->debounce_us;   // first edge is accepted
+    g->state = BG_IDLE;
+}
+
+static uint32_t ms_between(int64_t a, int64_t b) {
+    return b > a ? (uint32_t)((b - a) / 1000) : 0;
+}
+
+static int emit(button_gesture_event_t *out, int n, button_event_type_t type,
+                int level, int64_t t, uint32_t dur_ms) {
+    out[n].type = type;
+    out[n].level = level;
+    out[n].t_us = t;
+    out[n].duration_ms = dur_ms;
+    return n + 1;
+}
+
+/* A debounced level change: advance the gesture state machine */
+static int accept(button_gesture_t *g, int level, int64_t t, button_gesture_event_t *out) {
+    int n = 0;
+    g->stable = level;
+    g->stable_t = t;
+    n = emit(out, n, BUTTON_EVENT_EDGE, level, t, 0);
+
+    const bool pressed = level == g->cfg.active_level;
+    switch (g->state) {
+        case BG_IDLE:
+            if (pressed) {
+                g->state = BG_PRESSED;
+                g->press_t = t;
+            }
+            break;
+        case BG_PRESSED:
+            if (!pressed) {
+                uint32_t dur = ms_between(g->press_t, t);
+                if (t - g->press_t >= (int64_t)g->cfg.long_us) {
+                    n = emit(out, n, BUTTON_EVENT_LONG, level, t, dur);
+                    g->state = BG_IDLE;
+                } else if (g->cfg.double_us == 0) {
+                    n = emit(out, n, BUTTON_EVENT_SHORT, level, t, dur);
+                    g->state = BG_IDLE;
+                } else {
+                    g->state = BG_WAIT_SECOND;
+                    g->release_t = t;
+                }
+            }
+            break;
+        case BG_WAIT_SECOND:
+            if (pressed) {
+                g->state = BG_SECOND_PRESSED;
+                g->press_t = t;
+            }
+            break;
+        case BG_SECOND_PRESSED:
+            if (!pressed) {
+                n = emit(out, n, BUTTON_EVENT_DOUBLE, level, t, ms_between(g->press_t, t));
+                g->state = BG_IDLE;
+            }
+            break;
+        case BG_HELD:
+            if (!pressed) g->state = BG_IDLE;
+            break;
+    }
+    return n;
+}
+
+int button_gesture_edge(button_gesture_t *g, int level, int64_t t_us,
+                        button_gesture_event_t *out) {
+    g->raw = level;
+    g->raw_t = t_us;
+    if (level == g->stable) return 0;   // bounce back to where we are
+    if (t_us - g->stable_t < (int64_t)g->cfg.debounce_us) {
+        return 0;                       // inside the window: reconciled by poll()
+    }
+    return accept(g, level, t_us, out);
+}
+
+int64_t button_gesture_deadline(const button_gesture_t *g) {
+    int64_t d = INT64_MAX;
+    if (g->raw != g->stable) d = g->stable_t + g->cfg.debounce_us;
+    switch (g->state) {
+        case BG_PRESSED: {
+            int64_t hold = g->press_t + g->cfg.hold_us;
+            if (hold < d) d = hold;
+            break;
+        }
+        case BG_WAIT_SECOND: {
+            int64_t dbl = g->release_t + g->cfg.double_us;
+            if (dbl < d) d = dbl;
+            break;
+        }
+        default:
+            break;
+    }
+    return d;
+}
+
+int button_gesture_poll(button_gesture_t *g, int64_t now_us, button_gesture_event_t *out) {
+    int n = 0;
+    // Debounce window closed on a different raw level: the edge was real
+    if (g->raw != g->stable && now_us - g->stable_t >= (int64_t)g->cfg.debounce_us) {
+        int64_t t = g->raw_t > g->stable_t ? g->raw_t : g->stable_t + g->cfg.debounce_us;
+        n += accept(g, g->raw, t, out);
+    }
+    if (g->state == BG_PRESSED && now_us - g->press_t >= (int64_t)g->cfg.hold_us) {
+        n = emit(out, n, BUTTON_EVENT_HOLD, g->stable, g->press_t + g->cfg.hold_us,
+                 g->cfg.hold_us / 1000);
+        g->state = BG_HELD;
+    } else if (g->state == BG_WAIT_SECOND && now_us - g->release_t >= (int64_t)g->cfg.double_us) {
+        n = emit(out, n, BUTTON_EVENT_SHORT, g->stable, g->release_t + g->cfg.double_us,
+                 ms_between(g->press_t, g->release_t));
+        g->state = BG_IDLE;
+    }
+    return n;
+}
+
+const char *button_event_str(button_event_type_t type) {
+    switch (type) {
+        case BUTTON_EVENT_EDGE:   return "edge";
+        case BUTTON_EVENT_SHORT:  return "short";
+        case BUTTON_EVENT_DOUBLE: return "double";
+        case BUTTON_EVENT_LONG:   return "long";
+        case BUTTON_EVENT_HOLD:   return "hold";
+    }
+    return "?";
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-button debounce + gesture classifier driven only by edge timestamps.
+ * No timers: the owner asks for the next deadline and calls poll() when it
+ * passes. Pure C so it can be checked on the host. */
+
+typedef enum {
+    BUTTON_EVENT_EDGE,      // debounced level change (level field valid)
+    BUTTON_EVENT_SHORT,     // press shorter than long_ms, no second press within double_ms
+    BUTTON_EVENT_DOUBLE,    // second press within double_ms of a short release
+    BUTTON_EVENT_LONG,      // released after long_ms but before hold_ms
+    BUTTON_EVENT_HOLD       // still pressed at hold_ms (fires while held)
+} button_event_type_t;
+
+typedef struct {
+    uint32_t debounce_us;
+    uint32_t long_us;
+    uint32_t hold_us;
+    uint32_t double_us;     // 0 = no double-press detection (SHORT fires on release)
+    int active_level;       // level that means "pressed"
+} button_gesture_cfg_t;
+
+typedef struct {
+    button_event_type_t type;
+    int level;              // stable level after the event
+    int64_t t_us;           // timestamp of the edge or deadline that decided it
+    uint32_t duration_ms;   // press length (SHORT/LONG/HOLD/DOUBLE second press)
+} button_gesture_event_t;
+
+typedef enum {
+    BG_IDLE,
+    BG_PRESSED,
+    BG_WAIT_SECOND,         // short press released, waiting for a double
+    BG_SECOND_PRESSED,
+    BG_HELD                 // HOLD reported; swallow the release
+} button_gesture_state_t;
+
+typedef struct {
+    button_gesture_cfg_t cfg;
+    button_gesture_state_t state;
+    int stable;             // debounced level
+    int64_t stable_t;       // when it was accepted
+    int raw;                // last raw edge level
+    int64_t raw_t;
+    int64_t press_t;
+    int64_t release_t;
+} button_gesture_t;
+
+#define BUTTON_GESTURE_MAX_EVENTS 3   // most events one call can produce
+
+void button_gesture_init(button_gesture_t *g, const button_gesture_cfg_t *cfg,
+                         int level, int64_t now_us);
+
+/**
+ * Feed a raw (undebounced) edge. The first edge after a quiet period is
+ * accepted at once; bounces are absorbed, and a level that differs once the
+ * debounce window closes is still accepted (so a press shorter than the
+ * window never loses its release).
+ * @return number of events written to out (<= BUTTON_GESTURE_MAX_EVENTS)
+ */
+int button_gesture_edge(button_gesture_t *g, int level, int64_t t_us,
+                        button_gesture_event_t *out);
+
+/** Resolve deadlines that have passed by now_us */
+int button_gesture_poll(button_gesture_t *g, int64_t now_us, button_gesture_event_t *out);
+
+/** Next time poll() has something to do, or INT64_MAX */
+int64_t button_gesture_deadline(const button_gesture_t *g);
+
+const char *button_event_str(button_event_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
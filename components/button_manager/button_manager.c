@@ -1,110 +1,271 @@
 #include "button_manager.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
-#include "freertos/task.h"
 #include "driver/gpio.h"
+#include "event_dispatcher.h"
+#include "trace.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_sleep.h"
 #include <string.h>
 
 static const char *TAG = "button_manager";
 
+#define BM_QUEUE_LEN 16   // raw edges; bounces included
+
 typedef struct {
+    bool in_use;
     gpio_num_t pin;
-    uint32_t debounce_us;
+    button_gesture_t gesture;       // owned by the dispatcher worker
     volatile int last_level;        // cached stable level
-    volatile int64_t last_isr_t_us; // last accepted edge time
-    button_cb_t cb;
+    /* Latest raw edge as seen by the ISR (under s_isr_lock): if the queue
+     * overflowed mid-burst it holds the final level the queue lost */
+    int isr_level;
+    int64_t isr_t_us;
+    bool isr_overflow;
+    button_event_cb_t cb;
+    button_cb_t legacy_cb;          // button_manager_init(): any-edge callback
     void *cb_user;
-} bm_ctx_t;
+} bm_button_t;
 
-static bm_ctx_t s_ctx;
+static bm_button_t s_buttons[BUTTON_MANAGER_MAX_BUTTONS];
 static QueueHandle_t s_evtq = NULL;
+static bool s_wakeup = false;       // level-triggered mode for light-sleep wakeup
+static volatile bool s_drain_posted = false;
+static dispatch_timer_t s_deadline_timer = DISPATCH_TIMER_INVALID;
+static portMUX_TYPE s_isr_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void drain_edges(void *arg);
 
+/* Raw edge as seen by the ISR; debounce and gestures happen in the dispatcher */
 typedef struct {
-    int level;     // 0/1 at the time we accepted the edge
-    int64_t t_us;  // timestamp (us)
+    uint8_t button;
+    uint8_t level;
+    int64_t t_us;
 } bm_evt_t;
 
 static void IRAM_ATTR isr_handler(void *arg) {
-    (void)arg;
-    const int lvl = gpio_get_level(s_ctx.pin);
-    const int64_t now = esp_timer_get_time();
+    const int idx = (int)(intptr_t)arg;
+    const gpio_num_t pin = s_buttons[idx].pin;
+    const int lvl = gpio_get_level(pin);
+
+    if (s_wakeup) {
+        // Level-triggered (light sleep can only wake on levels): arm for the opposite
+        // level so the next edge both wakes the CPU and interrupts exactly once.
+        gpio_set_intr_type(pin, lvl ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+
+    TRACE_INSTANT("button_edge", idx << 1 | lvl);
+    bm_evt_t evt = { .button = (uint8_t)idx, .level = (uint8_t)lvl, .t_us = esp_timer_get_time() };
+    BaseType_t hp_task_woken = pdFALSE;
+    if (s_evtq) {
+        // Record before queueing so a drain never reconciles to an older level
+        taskENTER_CRITICAL_ISR(&s_isr_lock);
+        s_buttons[idx].isr_level = lvl;
+        s_buttons[idx].isr_t_us = evt.t_us;
+        if (xQueueSendFromISR(s_evtq, &evt, &hp_task_woken) != pdTRUE) {
+            s_buttons[idx].isr_overflow = true;
+        }
+        taskEXIT_CRITICAL_ISR(&s_isr_lock);
+        // One drain job per burst of edges, not one dispatcher slot per bounce
+        if (!s_drain_posted) {
+            s_drain_posted = event_dispatcher_post_from_isr(drain_edges, NULL,
+                                                            DISPATCH_PRIO_HIGH, "button");
+        }
+        if (hp_task_woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
 
-    // Simple time-based debounce in ISR (fast)
-    if ((now - s_ctx.last_isr_t_us) >= (int64_t)s_ctx.debounce_us) {
-        s_ctx.last_isr_t_us = now;
-        bm_evt_t evt = { .level = lvl, .t_us = now };
-        BaseType_t hp_task_woken = pdFALSE;
-        if (s_evtq) {
-            xQueueSendFromISR(s_evtq, &evt, &hp_task_woken);
-            if (hp_task_woken) {
-                portYIELD_FROM_ISR();
-            }
+static void deliver(int idx, const button_gesture_event_t *ev, int n) {
+    bm_button_t *b = &s_buttons[idx];
+    for (int i = 0; i < n; i++) {
+        if (ev[i].type == BUTTON_EVENT_EDGE) {
+            b->last_level = ev[i].level;
+            if (b->legacy_cb) b->legacy_cb(b->cb_user);
         }
+        if (!b->cb) continue;
+        int64_t now = esp_timer_get_time();
+        button_event_t out = {
+            .button = idx,
+            .type = ev[i].type,
+            .level = ev[i].level,
+            .duration_ms = ev[i].duration_ms,
+            .latency_us = now > ev[i].t_us ? (uint32_t)(now - ev[i].t_us) : 0,
+        };
+        b->cb(&out, b->cb_user);
     }
 }
 
-static void button_task(void *arg) {
+/* Re-arm the dispatcher timer for the earliest pending gesture deadline */
+static void arm_deadline(void) {
+    int64_t next = INT64_MAX;
+    for (int i = 0; i < BUTTON_MANAGER_MAX_BUTTONS; i++) {
+        if (!s_buttons[i].in_use) continue;
+        int64_t d = button_gesture_deadline(&s_buttons[i].gesture);
+        if (d < next) next = d;
+    }
+    if (next == INT64_MAX) event_dispatcher_timer_stop(s_deadline_timer);
+    else event_dispatcher_timer_start_at(s_deadline_timer, next);
+}
+
+static void poll_deadlines(void *arg) {
     (void)arg;
+    button_gesture_event_t ev[BUTTON_GESTURE_MAX_EVENTS];
+    const int64_t now = esp_timer_get_time();
+    for (int i = 0; i < BUTTON_MANAGER_MAX_BUTTONS; i++) {
+        if (!s_buttons[i].in_use) continue;
+        int n = button_gesture_poll(&s_buttons[i].gesture, now, ev);
+        deliver(i, ev, n);
+    }
+    arm_deadline();
+}
+
+/* After draining: if the queue dropped edges, the classifier may still hold
+ * a bounce level; feed it the ISR's latest edge so a release is not lost */
+static void reconcile(int idx, button_gesture_event_t *ev) {
+    bm_button_t *b = &s_buttons[idx];
+    taskENTER_CRITICAL(&s_isr_lock);
+    const int level = b->isr_level;
+    const int64_t t_us = b->isr_t_us;
+    const bool overflow = b->isr_overflow;
+    b->isr_overflow = false;
+    taskEXIT_CRITICAL(&s_isr_lock);
+    if (overflow) ESP_LOGW(TAG, "Button %d: edge queue overflowed, resyncing to level %d", idx, level);
+    if (level == b->gesture.raw) return;
+    int n = button_gesture_edge(&b->gesture, level, t_us, ev);
+    deliver(idx, ev, n);
+}
+
+/* Dispatcher job posted by the ISR: feed queued edges to the classifiers */
+static void drain_edges(void *arg) {
+    (void)arg;
+    button_gesture_event_t ev[BUTTON_GESTURE_MAX_EVENTS];
     bm_evt_t evt;
-    while (1) {
-        if (xQueueReceive(s_evtq, &evt, portMAX_DELAY) == pdTRUE) {
-            // Update cached level and call user callback (task context)
-            s_ctx.last_level = evt.level;
-            if (s_ctx.cb) {
-                s_ctx.cb(s_ctx.cb_user);
-            }
+    // Clear first: an edge arriving while we drain posts a fresh job
+    s_drain_posted = false;
+    while (xQueueReceive(s_evtq, &evt, 0) == pdTRUE) {
+        if (evt.button < BUTTON_MANAGER_MAX_BUTTONS && s_buttons[evt.button].in_use) {
+            int n = button_gesture_edge(&s_buttons[evt.button].gesture,
+                                        evt.level, evt.t_us, ev);
+            deliver(evt.button, ev, n);
         }
     }
+    for (int i = 0; i < BUTTON_MANAGER_MAX_BUTTONS; i++) {
+        if (s_buttons[i].in_use) reconcile(i, ev);
+    }
+    poll_deadlines(NULL);
 }
 
-bool button_manager_init(gpio_num_t pin,
-                         bool pullup,
-                         bool pulldown,
-                         uint32_t debounce_ms,
-                         button_cb_t cb,
-                         void *user_data) {
-    memset(&s_ctx, 0, sizeof(s_ctx));
-    s_ctx.pin = pin;
-    s_ctx.debounce_us = debounce_ms * 1000U;
-    s_ctx.cb = cb;
-    s_ctx.cb_user = user_data;
-    s_ctx.last_level = -1;
-    s_ctx.last_isr_t_us = 0;
+/* Shared ISR service, edge queue and deadline timer, created with the first button */
+static bool ensure_started(void) {
+    if (s_evtq) return true;
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "gpio_install_isr_service failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (!event_dispatcher_init()) return false;
+    s_deadline_timer = event_dispatcher_timer_create(poll_deadlines, NULL, "button_deadline");
+    if (s_deadline_timer == DISPATCH_TIMER_INVALID) return false;
+    s_evtq = xQueueCreate(BM_QUEUE_LEN, sizeof(bm_evt_t));
+    return s_evtq != NULL;
+}
+
+static int add_button(const button_config_t *cfg, button_event_cb_t cb,
+                      button_cb_t legacy_cb, void *user_data) {
+    int idx = -1;
+    for (int i = 0; i < BUTTON_MANAGER_MAX_BUTTONS; i++) {
+        if (!s_buttons[i].in_use) { idx = i; break; }
+    }
+    if (idx < 0 || !ensure_started()) return -1;
 
     // Configure GPIO
     gpio_config_t io = {
-        .pin_bit_mask = 1ULL << pin,
+        .pin_bit_mask = 1ULL << cfg->pin,
         .mode = GPIO_MODE_INPUT,
-        .pull_up_en = pullup ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
-        .pull_down_en = pulldown ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE,
+        .pull_up_en = cfg->pullup ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+        .pull_down_en = cfg->pulldown ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE,
         .intr_type = GPIO_INTR_ANYEDGE
     };
-    ESP_ERROR_CHECK(gpio_config(&io));
+    if (gpio_config(&io) != ESP_OK) return -1;
 
-    // Install ISR service (ignore already-installed)
-    esp_err_t err = gpio_install_isr_service(0);
-    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
-        ESP_LOGE(TAG, "gpio_install_isr_service failed: %s", esp_err_to_name(err));
-        return false;
+    bm_button_t *b = &s_buttons[idx];
+    memset(b, 0, sizeof(*b));
+    b->pin = cfg->pin;
+    b->cb = cb;
+    b->legacy_cb = legacy_cb;
+    b->cb_user = user_data;
+    // Seed cached level; do NOT fire callback
+    b->last_level = gpio_get_level(cfg->pin);
+    button_gesture_cfg_t gcfg = {
+        .debounce_us = cfg->debounce_ms * 1000U,
+        .long_us = cfg->long_ms * 1000U,
+        .hold_us = cfg->hold_ms * 1000U,
+        .double_us = cfg->double_ms * 1000U,
+        .active_level = cfg->active_high ? 1 : 0,
+    };
+    b->isr_t_us = esp_timer_get_time();
+    b->isr_level = b->last_level;
+    button_gesture_init(&b->gesture, &gcfg, b->last_level, b->isr_t_us);
+    b->in_use = true;
+
+    if (gpio_isr_handler_add(cfg->pin, isr_handler, (void *)(intptr_t)idx) != ESP_OK) {
+        b->in_use = false;
+        return -1;
+    }
+    if (s_wakeup) {
+        gpio_wakeup_enable(cfg->pin, b->last_level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
     }
-    ESP_ERROR_CHECK(gpio_isr_handler_add(pin, isr_handler, NULL));
+    return idx;
+}
 
-    // Initialize queue + task
-    s_evtq = xQueueCreate(8, sizeof(bm_evt_t));
-    if (!s_evtq) return false;
-    xTaskCreate(button_task, "button_task", 3072, NULL, 5, NULL);
+int button_manager_add(const button_config_t *cfg, button_event_cb_t cb, void *user_data) {
+    return add_button(cfg, cb, NULL, user_data);
+}
 
-    // Seed cached level; do NOT fire callback
-    s_ctx.last_level = gpio_get_level(pin);
+bool button_manager_init(gpio_num_t pin,
+                         bool pullup,
+                         bool pulldown,
+                         uint32_t debounce_ms,
+                         button_cb_t cb,
+                         void *user_data) {
+    button_config_t cfg = BUTTON_CONFIG_DEFAULT(pin);
+    cfg.pullup = pullup;
+    cfg.pulldown = pulldown;
+    cfg.active_high = pulldown;
+    cfg.debounce_ms = debounce_ms;
+    return add_button(&cfg, NULL, cb, user_data) >= 0;
+}
+
+bool button_manager_enable_wakeup(void) {
+    esp_err_t err = ESP_OK;
+    for (int i = 0; i < BUTTON_MANAGER_MAX_BUTTONS && err == ESP_OK; i++) {
+        if (!s_buttons[i].in_use) continue;
+        int lvl = gpio_get_level(s_buttons[i].pin);
+        err = gpio_wakeup_enable(s_buttons[i].pin, lvl ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+    if (err == ESP_OK) err = esp_sleep_enable_gpio_wakeup();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO wakeup setup failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    s_wakeup = true;
     return true;
 }
 
 int button_manager_get_level(void) {
-    return s_ctx.last_level;
+    return button_manager_get_button_level(0);
+}
+
+int button_manager_get_button_level(int button) {
+    if (button < 0 || button >= BUTTON_MANAGER_MAX_BUTTONS || !s_buttons[button].in_use) return -1;
+    return s_buttons[button].last_level;
 }
 
 void button_manager_set_debounce(uint32_t debounce_ms) {
-    s_ctx.debounce_us = debounce_ms * 1000U;
+    for (int i = 0; i < BUTTON_MANAGER_MAX_BUTTONS; i++) {
+        s_buttons[i].gesture.cfg.debounce_us = debounce_ms * 1000U;
+    }
 }
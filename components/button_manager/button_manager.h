@@ -2,16 +2,52 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "driver/gpio.h"
+#include "button_gesture.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define BUTTON_MANAGER_MAX_BUTTONS 4
+
 typedef void (*button_cb_t)(void *user_data);
 
+typedef struct {
+    int button;                 // index returned by button_manager_add()
+    button_event_type_t type;
+    int level;                  // debounced level after the event
+    uint32_t duration_ms;       // press length
+    uint32_t latency_us;        // from the deciding edge (ISR timestamp) or deadline to this callback
+} button_event_t;
+
+typedef void (*button_event_cb_t)(const button_event_t *evt, void *user_data);
+
+typedef struct {
+    gpio_num_t pin;
+    bool pullup;
+    bool pulldown;
+    bool active_high;           // pressed == high (pull-down wiring)
+    uint32_t debounce_ms;
+    uint32_t long_ms;
+    uint32_t hold_ms;
+    uint32_t double_ms;         // 0 disables DOUBLE (SHORT is reported without waiting)
+} button_config_t;
+
+#define BUTTON_CONFIG_DEFAULT(gpio) { \
+    .pin = (gpio), .pullup = true, .pulldown = false, .active_high = false, \
+    .debounce_ms = 30, .long_ms = 800, .hold_ms = 1500, .double_ms = 300 }
+
 /**
- * Initialize a button on the given pin.
- * Triggers the callback on ANY edge (state change), with debounce.
+ * Add a button with gesture detection. All buttons share one ISR and one
+ * edge queue; the event_dispatcher worker classifies SHORT/DOUBLE/LONG/HOLD from the edge
+ * timestamps and calls cb (EDGE events are delivered too).
+ * @return button index, or -1 on failure / table full
+ */
+int button_manager_add(const button_config_t *cfg, button_event_cb_t cb, void *user_data);
+
+/**
+ * Initialize a button on the given pin (legacy single-callback API, becomes
+ * button 0). Triggers the callback on ANY edge (state change), with debounce.
  *
  * @param pin           GPIO number (e.g., GPIO_NUM_18)
  * @param pullup        Enable internal pull-up
@@ -28,10 +64,21 @@ bool button_manager_init(gpio_num_t pin,
                          button_cb_t cb,
                          void *user_data);
 
-/** Optional: read the current (cached) level (0/1), or -1 if uninitialized */
+/**
+ * Optional: let the buttons wake the CPU from light sleep.
+ * Switches the pin from edge to level interrupts (re-armed to the opposite
+ * level after every edge), since GPIO light-sleep wakeup is level-only.
+ * @return true on success
+ */
+bool button_manager_enable_wakeup(void);
+
+/** Optional: read the current (cached) level (0/1) of button 0, or -1 if uninitialized */
 int button_manager_get_level(void);
 
-/** Optional: change debounce at runtime */
+/** Debounced level of a button, or -1 if the index is invalid */
+int button_manager_get_button_level(int button);
+
+/** Optional: change debounce of every button at runtime */
 void button_manager_set_debounce(uint32_t debounce_ms);
 
 #ifdef __cplusplus
@@ -0,0 +1,325 @@
+#include "control_api.h"
+#include "control_format.h"
+#include "alarm_manager.h"
+#include "time_manager.h"
+#include "wifi_manager.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "event_dispatcher.h"
+#include "esp_http_server.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "control_api";
+
+#define CONTROL_RESP_SIZE   2048
+#define CONTROL_BODY_SIZE   256
+#define CONTROL_FRAME_SIZE  (3 + CONFIG_CONTROL_API_PREVIEW_MAX_LEDS * 4)
+#define CONTROL_MAX_CLIENTS 4         // shares the LWIP socket pool with the portal
+#define CONTROL_JOB_SLOTS   4         // lamp changes waiting for the dispatcher
+
+static httpd_handle_t s_server = NULL;
+static neopixel_t *s_strip = NULL;
+static control_api_hooks_t s_hooks = {0};
+static esp_timer_handle_t s_preview_timer = NULL;
+static bool s_preview_running = false;
+
+/* httpd runs handlers one at a time in its own task, so one set of static
+ * buffers serves every request without touching the heap. */
+static char s_resp[CONTROL_RESP_SIZE];
+static char s_body[CONTROL_BODY_SIZE];
+static uint8_t s_frame[CONTROL_FRAME_SIZE];
+static uint8_t s_last_frame[CONTROL_FRAME_SIZE];
+static size_t s_last_len = 0;
+
+static esp_err_t send_json(httpd_req_t *req, const char *status, int len) {
+    if (len < 0) return httpd_resp_send_500(req);
+    httpd_resp_set_type(req, "application/json");
+    if (status) httpd_resp_set_status(req, status);
+    return httpd_resp_send(req, s_resp, len);
+}
+
+static esp_err_t send_result(httpd_req_t *req, bool ok, const char *msg) {
+    int len = control_format_result(s_resp, sizeof(s_resp), ok, msg);
+    return send_json(req, ok ? NULL : "400 Bad Request", len);
+}
+
+/* Whole form body into s_body; false if it is empty or too large */
+static bool read_body(httpd_req_t *req) {
+    if (req->content_len == 0 || req->content_len >= sizeof(s_body)) return false;
+    size_t got = 0;
+    while (got < req->content_len) {
+        int r = httpd_req_recv(req, s_body + got, req->content_len - got);
+        if (r <= 0) return false;
+        got += (size_t)r;
+    }
+    s_body[got] = '\0';
+    return true;
+}
+
+static esp_err_t status_get_handler(httpd_req_t *req) {
+    neopixel_stream_stats_t ss;
+    neopixel_animations_get_stream_stats(&ss);
+    control_status_t st = {
+        .brightness = neopixel_get_brightness_cap(),
+        .anim_active = neopixel_animations_is_active(),
+        .wifi_connected = wifi_manager_is_connected(),
+        .time_quality = (int)time_manager_get_quality(),
+        .now = (int64_t)time(NULL),
+        .uptime_s = (uint32_t)(esp_timer_get_time() / 1000000),
+        .stream_frames = ss.frames,
+        .stream_lost = ss.lost,
+    };
+    neopixel_animations_get_jitter(&st.jitter);
+    return send_json(req, NULL, control_format_status(s_resp, sizeof(s_resp), &st));
+}
+
+static esp_err_t telemetry_get_handler(httpd_req_t *req) {
+    return send_json(req, NULL, telemetry_snapshot_json(s_resp, sizeof(s_resp)));
+}
+
+static bool trace_write_chunk(const char *data, size_t len, void *ctx) {
+    return httpd_resp_send_chunk(ctx, data, (ssize_t)len) == ESP_OK;
+}
+
+/* Chrome trace JSON, streamed straight from the ring */
+static esp_err_t trace_get_handler(httpd_req_t *req) {
+#if CONFIG_TRACE_ENABLE
+    httpd_resp_set_type(req, "application/json");
+    if (!trace_dump(trace_write_chunk, req)) return ESP_FAIL;     // client went away
+    return httpd_resp_send_chunk(req, NULL, 0);
+#else
+    return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "tracing disabled");
+#endif
+}
+
+static esp_err_t trace_delete_handler(httpd_req_t *req) {
+    trace_clear();
+    return send_result(req, true, NULL);
+}
+
+static esp_err_t alarms_get_handler(httpd_req_t *req) {
+    static alarm_info_t list[16];
+    int n = alarm_manager_list(list, sizeof(list) / sizeof(list[0]));
+    return send_json(req, NULL, control_format_alarms(s_resp, sizeof(s_resp), list, n));
+}
+
+static esp_err_t alarms_post_handler(httpd_req_t *req) {
+    char id[16];
+    alarm_time_t t = {0};
+    if (!read_body(req) ||
+        !control_form_get(s_body, "id", id, sizeof(id)) || id[0] == '\0' ||
+        !control_form_get_int(s_body, "day", -1, 6, &t.day) ||
+        !control_form_get_int(s_body, "hour", 0, 23, &t.hour) ||
+        !control_form_get_int(s_body, "minute", 0, 59, &t.minute)) {
+        return send_result(req, false, "need id, day (-1..6), hour, minute");
+    }
+    if (!control_form_get_int(s_body, "second", 0, 59, &t.second)) t.second = 0;
+    // No callback of its own: fires the default (wake) callback, like restored alarms
+    bool ok = alarm_manager_set_alarm(id, t, NULL, NULL);
+    return send_result(req, ok, ok ? NULL : "alarm table full");
+}
+
+static esp_err_t alarms_delete_handler(httpd_req_t *req) {
+    char id[16];
+    if (httpd_req_get_url_query_str(req, s_body, sizeof(s_body)) != ESP_OK ||
+        !control_form_get(s_body, "id", id, sizeof(id))) {
+        return send_result(req, false, "need ?id=");
+    }
+    bool ok = alarm_manager_clear_alarm(id);
+    return send_result(req, ok, ok ? NULL : "no such alarm");
+}
+
+/* A lamp change for main's hooks. They stop and start the render task, arm
+ * duration timers and write the lamp state, which the dispatcher task owns
+ * (buttons and alarms change it there), so the hooks run there too: the
+ * request is copied into a slot, posted, and the slot freed by the job. */
+typedef struct {
+    bool busy;
+    bool brightness;        // set_brightness(cap), else start_animation(mode, r, g, b)
+    neopixel_anim_mode_t mode;
+    uint8_t r, g, b, cap;
+} control_job_t;
+
+static control_job_t s_jobs[CONTROL_JOB_SLOTS];
+static portMUX_TYPE s_job_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void control_job(void *arg) {
+    control_job_t *slot = arg;
+    taskENTER_CRITICAL(&s_job_lock);
+    control_job_t job = *slot;
+    slot->busy = false;
+    taskEXIT_CRITICAL(&s_job_lock);
+
+    if (job.brightness) {
+        if (s_hooks.set_brightness) s_hooks.set_brightness(job.cap, s_hooks.user_data);
+    } else if (s_hooks.start_animation) {
+        s_hooks.start_animation(job.mode, job.r, job.g, job.b, s_hooks.user_data);
+    }
+}
+
+/* false if every slot is taken or the dispatcher queue is full */
+static bool post_job(const control_job_t *job, const char *name) {
+    control_job_t *slot = NULL;
+    taskENTER_CRITICAL(&s_job_lock);
+    for (int i = 0; i < CONTROL_JOB_SLOTS && !slot; i++) {
+        if (!s_jobs[i].busy) {
+            slot = &s_jobs[i];
+            *slot = *job;
+            slot->busy = true;
+        }
+    }
+    taskEXIT_CRITICAL(&s_job_lock);
+    if (!slot) return false;
+    if (event_dispatcher_post(control_job, slot, DISPATCH_PRIO_HIGH, name)) return true;
+    taskENTER_CRITICAL(&s_job_lock);
+    slot->busy = false;
+    taskEXIT_CRITICAL(&s_job_lock);
+    return false;
+}
+
+/* 202 once the change is queued; 503 if the lamp is too busy to take it */
+static esp_err_t send_queued(httpd_req_t *req, bool queued, const char *msg) {
+    int len = control_format_result(s_resp, sizeof(s_resp), queued, queued ? msg : "busy, retry");
+    return send_json(req, queued ? "202 Accepted" : "503 Service Unavailable", len);
+}
+
+static esp_err_t animation_post_handler(httpd_req_t *req) {
+    char name[20];
+    neopixel_anim_mode_t mode;
+    if (!read_body(req) || !control_form_get(s_body, "mode", name, sizeof(name)) ||
+        !control_parse_anim(name, &mode)) {
+        return send_result(req, false, "unknown mode");
+    }
+    int r = 0, g = 0, b = 255;
+    control_form_get_int(s_body, "r", 0, 255, &r);
+    control_form_get_int(s_body, "g", 0, 255, &g);
+    control_form_get_int(s_body, "b", 0, 255, &b);
+    const control_job_t job = {
+        .mode = mode, .r = (uint8_t)r, .g = (uint8_t)g, .b = (uint8_t)b
+    };
+    return send_queued(req, post_job(&job, "api_animation"), control_anim_name(mode));
+}
+
+static esp_err_t brightness_post_handler(httpd_req_t *req) {
+    int value;
+    if (!read_body(req) || !control_form_get_int(s_body, "value", 0, 255, &value)) {
+        return send_result(req, false, "need value 0..255");
+    }
+    const control_job_t job = { .brightness = true, .cap = (uint8_t)value };
+    return send_queued(req, post_job(&job, "api_brightness"), NULL);
+}
+
+/* Runs in the httpd task (via httpd_queue_work), the only task that touches
+ * the sockets. Sends only when the frame changed or a client just joined. */
+static bool s_force_frame = false;
+
+static void preview_work(void *arg) {
+    size_t fds = CONTROL_MAX_CLIENTS;
+    int clients[CONTROL_MAX_CLIENTS];
+    if (!s_server || httpd_get_client_list(s_server, &fds, clients) != ESP_OK) return;
+
+    size_t len = control_format_frame(s_frame, sizeof(s_frame), s_strip->pixels,
+                                      s_strip->count, s_strip->fmt);
+    bool changed = s_force_frame || len != s_last_len || memcmp(s_frame, s_last_frame, len) != 0;
+    s_force_frame = false;
+
+    httpd_ws_frame_t frame = {
+        .final = true, .type = HTTPD_WS_TYPE_BINARY, .payload = s_frame, .len = len
+    };
+    int viewers = 0;
+    for (size_t i = 0; i < fds; i++) {
+        if (httpd_ws_get_fd_info(s_server, clients[i]) != HTTPD_WS_CLIENT_WEBSOCKET) continue;
+        viewers++;
+        if (changed) httpd_ws_send_frame_async(s_server, clients[i], &frame);
+    }
+    if (changed) {
+        memcpy(s_last_frame, s_frame, len);
+        s_last_len = len;
+    }
+    if (viewers == 0 && s_preview_running) {
+        // Nobody watching: stop waking the CPU
+        esp_timer_stop(s_preview_timer);
+        s_preview_running = false;
+    }
+}
+
+static void preview_timer_cb(void *arg) {
+    if (s_server) httpd_queue_work(s_server, preview_work, NULL);
+}
+
+static esp_err_t ws_frame_handler(httpd_req_t *req) {
+    if (req->method == HTTP_GET) {
+        // Handshake done: start streaming
+        s_force_frame = true;
+        if (!s_preview_running) {
+            esp_timer_start_periodic(s_preview_timer, 1000000 / CONFIG_CONTROL_API_PREVIEW_FPS);
+            s_preview_running = true;
+        }
+        return ESP_OK;
+    }
+    // Drain (and ignore) anything the viewer sends
+    httpd_ws_frame_t frame = { .payload = (uint8_t *)s_body };
+    if (httpd_ws_recv_frame(req, &frame, 0) != ESP_OK) return ESP_FAIL;
+    if (frame.len >= sizeof(s_body)) return ESP_FAIL;
+    return frame.len ? httpd_ws_recv_frame(req, &frame, frame.len) : ESP_OK;
+}
+
+static const httpd_uri_t s_uris[] = {
+    { .uri = "/api/status",     .method = HTTP_GET,    .handler = status_get_handler },
+    { .uri = "/api/telemetry",  .method = HTTP_GET,    .handler = telemetry_get_handler },
+    { .uri = "/api/trace",      .method = HTTP_GET,    .handler = trace_get_handler },
+    { .uri = "/api/trace",      .method = HTTP_DELETE, .handler = trace_delete_handler },
+    { .uri = "/api/alarms",     .method = HTTP_GET,    .handler = alarms_get_handler },
+    { .uri = "/api/alarms",     .method = HTTP_POST,   .handler = alarms_post_handler },
+    { .uri = "/api/alarms",     .method = HTTP_DELETE, .handler = alarms_delete_handler },
+    { .uri = "/api/animation",  .method = HTTP_POST,   .handler = animation_post_handler },
+    { .uri = "/api/brightness", .method = HTTP_POST,   .handler = brightness_post_handler },
+    { .uri = "/ws/frame",       .method = HTTP_GET,    .handler = ws_frame_handler,
+      .is_websocket = true },
+};
+
+bool control_api_start(neopixel_t *strip, const control_api_hooks_t *hooks) {
+    if (s_server) return true;
+    s_strip = strip;
+    if (hooks) s_hooks = *hooks;
+    if (!event_dispatcher_init()) return false;
+
+    if (!s_preview_timer) {
+        const esp_timer_create_args_t args = { .callback = preview_timer_cb, .name = "ws_preview" };
+        if (esp_timer_create(&args, &s_preview_timer) != ESP_OK) return false;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_CONTROL_API_PORT;
+    config.ctrl_port = config.ctrl_port + 1;   // the captive portal may own the default
+    config.max_uri_handlers = sizeof(s_uris) / sizeof(s_uris[0]);
+    config.max_open_sockets = CONTROL_MAX_CLIENTS;
+    config.lru_purge_enable = true;
+    config.task_priority = CONFIG_CONTROL_API_TASK_PRIORITY;
+    config.core_id = CONFIG_CONTROL_API_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_CONTROL_API_TASK_CORE;
+    if (httpd_start(&s_server, &config) != ESP_OK) {
+        ESP_LOGE(TAG, "httpd_start failed on port %d", CONFIG_CONTROL_API_PORT);
+        s_server = NULL;
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(s_uris) / sizeof(s_uris[0]); i++) {
+        httpd_register_uri_handler(s_server, &s_uris[i]);
+    }
+    ESP_LOGI(TAG, "Control API on port %d", CONFIG_CONTROL_API_PORT);
+    return true;
+}
+
+void control_api_stop(void) {
+    if (!s_server) return;
+    if (s_preview_running) {
+        esp_timer_stop(s_preview_timer);
+        s_preview_running = false;
+    }
+    httpd_stop(s_server);
+    s_server = NULL;
+}
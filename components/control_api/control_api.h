@@ -0,0 +1,41 @@
+#pragma once
+#include "neopixel_driver.h"
+#include "neopixel_animations.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Actions the API can't perform by itself because main owns the lamp state.
+ * Run on the event dispatcher task, like button and alarm reactions; the
+ * request is answered 202 once the change is queued. */
+typedef struct {
+    void (*start_animation)(neopixel_anim_mode_t mode, uint8_t r, uint8_t g, uint8_t b,
+                            void *user_data);
+    void (*set_brightness)(uint8_t cap, void *user_data);
+    void *user_data;
+} control_api_hooks_t;
+
+/**
+ * Start the local control API (safe to call again, e.g. on every GOT_IP).
+ *
+ *   GET    /api/status                      brightness, clock quality, uptime
+ *   GET    /api/alarms                      list alarms
+ *   POST   /api/alarms     id,day,hour,minute[,second]   add/update (form body)
+ *   DELETE /api/alarms?id=<id>              clear
+ *   POST   /api/animation  mode[,r,g,b]     breath/pulse/rainbow/fade/rainbow_smooth/stream/off (202)
+ *   POST   /api/brightness value            0..255 (202)
+ *   WS     /ws/frame                        binary frames of strip->pixels,
+ *                                           throttled to CONFIG_CONTROL_API_PREVIEW_FPS
+ *
+ * @param strip  strip whose frame buffer is previewed (must outlive the API)
+ * @return true if the server is running
+ */
+bool control_api_start(neopixel_t *strip, const control_api_hooks_t *hooks);
+void control_api_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+#include "control_format.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int hex_val(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool control_form_get(const char *body, const char *key, char *out, size_t out_len) {
+    if (!body || !out || out_len == 0) return false;
+    size_t klen = strlen(key);
+    const char *p = body;
+    while (*p) {
+        const char *end = strchr(p, '&');
+        if (!end) end = p + strlen(p);
+        if ((size_t)(end - p) > klen && strncmp(p, key, klen) == 0 && p[klen] == '=') {
+            size_t n = 0;
+            for (const char *v = p + klen + 1; v < end; v++) {
+                char c = *v;
+                if (c == '+') {
+                    c = ' ';
+                } else if (c == '%' && end - v > 2 && hex_val(v[1]) >= 0 && hex_val(v[2]) >= 0) {
+                    c = (char)(hex_val(v[1]) << 4 | hex_val(v[2]));
+                    v += 2;
+                }
+                if (n + 1 >= out_len) return false;
+                out[n++] = c;
+            }
+            out[n] = '\0';
+            return true;
+        }
+        p = *end ? end + 1 : end;
+    }
+    return false;
+}
+
+bool control_form_get_int(const char *body, const char *key, int min, int max, int *out) {
+    char buf[12];
+    if (!control_form_get(body, key, buf, sizeof(buf)) || buf[0] == '\0') return false;
+    char *end;
+    long v = strtol(buf, &end, 10);
+    if (*end != '\0' || v < min || v > max) return false;
+    *out = (int)v;
+    return true;
+}
+
+static const struct {
+    const char *name;
+    neopixel_anim_mode_t mode;
+} s_anim_names[] = {
+    { "off",            NEOPIXEL_ANIM_NONE },
+    { "breath",         NEOPIXEL_ANIM_BREATH },
+    { "pulse",          NEOPIXEL_ANIM_PULSE },
+    { "rainbow",        NEOPIXEL_ANIM_RAINBOW },
+    { "fade",           NEOPIXEL_ANIM_FADE_TO_SOLID },
+    { "rainbow_smooth", NEOPIXEL_ANIM_RAINBOW_SMOOTH },
+    { "stream",         NEOPIXEL_ANIM_STREAM },
+    { "clip",           NEOPIXEL_ANIM_CLIP },
+    { "sweep",          NEOPIXEL_ANIM_SWEEP },
+};
+
+bool control_parse_anim(const char *name, neopixel_anim_mode_t *out) {
+    for (size_t i = 0; i < sizeof(s_anim_names) / sizeof(s_anim_names[0]); i++) {
+        if (strcmp(name, s_anim_names[i].name) == 0) {
+            *out = s_anim_names[i].mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *control_anim_name(neopixel_anim_mode_t mode) {
+    for (size_t i = 0; i < sizeof(s_anim_names) / sizeof(s_anim_names[0]); i++) {
+        if (s_anim_names[i].mode == mode) return s_anim_names[i].name;
+    }
+    return "unknown";
+}
+
+/* Bounded appender: once anything fails to fit, the whole result is -1 */
+typedef struct {
+    char *buf;
+    size_t len, pos;
+    bool overflow;
+} out_t;
+
+static void out_printf(out_t *o, const char *fmt, ...) {
+    if (o->overflow) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(o->buf + o->pos, o->len - o->pos, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= o->len - o->pos) {
+        o->overflow = true;
+        return;
+    }
+    o->pos += (size_t)n;
+}
+
+/* JSON string body; ids come from API clients so quotes/controls are escaped */
+static void out_json_str(out_t *o, const char *s, size_t max) {
+    for (size_t i = 0; i < max && s[i]; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\') out_printf(o, "\\%c", c);
+        else if (c < 0x20) out_printf(o, "\\u%04x", c);
+        else out_printf(o, "%c", c);
+    }
+}
+
+static int out_finish(out_t *o) {
+    if (o->len == 0) return -1;
+    if (o->overflow) {
+        o->buf[0] = '\0';
+        return -1;
+    }
+    return (int)o->pos;
+}
+
+int control_format_alarms(char *buf, size_t len, const alarm_info_t *alarms, int n) {
+    out_t o = { buf, len, 0, len == 0 };
+    out_printf(&o, "{\"alarms\":[");
+    for (int i = 0; i < n; i++) {
+        const alarm_info_t *a = &alarms[i];
+        out_printf(&o, "%s{\"id\":\"", i ? "," : "");
+        out_json_str(&o, a->id, sizeof(a->id));
+        out_printf(&o, "\",\"day\":%d,\"hour\":%d,\"minute\":%d,\"second\":%d,\"next\":%lld}",
+                   a->time.day, a->time.hour, a->time.minute, a->time.second,
+                   (long long)a->next_fire);
+    }
+    out_printf(&o, "]}");
+    return out_finish(&o);
+}
+
+int control_format_status(char *buf, size_t len, const control_status_t *st) {
+    out_t o = { buf, len, 0, len == 0 };
+    out_printf(&o, "{\"brightness\":%u,\"animating\":%s,\"wifi\":%s,"
+                   "\"time_quality\":%d,\"now\":%lld,\"uptime\":%u,"
+                   "\"stream\":{\"frames\":%u,\"lost\":%u},",
+               st->brightness, st->anim_active ? "true" : "false",
+               st->wifi_connected ? "true" : "false", st->time_quality,
+               (long long)st->now, (unsigned)st->uptime_s,
+               (unsigned)st->stream_frames, (unsigned)st->stream_lost);
+    const neopixel_jitter_stats_t *j = &st->jitter;
+    out_printf(&o, "\"render\":{\"frames\":%u,\"jitter_max_us\":%u,\"jitter_sum_us\":%llu,"
+                   "\"jitter_hist\":[",
+               (unsigned)j->frames, (unsigned)j->max_us, (unsigned long long)j->sum_us);
+    for (int i = 0; i < NEOPIXEL_JITTER_BUCKETS; i++) {
+        out_printf(&o, "%s%u", i ? "," : "", (unsigned)j->hist[i]);
+    }
+    out_printf(&o, "]}}");
+    return out_finish(&o);
+}
+
+int control_format_result(char *buf, size_t len, bool ok, const char *msg) {
+    out_t o = { buf, len, 0, len == 0 };
+    out_printf(&o, "{\"ok\":%s", ok ? "true" : "false");
+    if (msg) {
+        out_printf(&o, ",\"msg\":\"");
+        out_json_str(&o, msg, SIZE_MAX);
+        out_printf(&o, "\"");
+    }
+    out_printf(&o, "}");
+    return out_finish(&o);
+}
+
+size_t control_format_frame(uint8_t *buf, size_t len, const uint8_t *pixels,
+                            int count, const neopixel_format_t *fmt) {
+    if (len < 3 || !fmt) return 0;
+    const int bpp = fmt->bpp;
+    size_t fit = (len - 3) / (size_t)bpp;
+    if ((size_t)count < fit) fit = (size_t)count;
+    buf[0] = (uint8_t)bpp;
+    buf[1] = (uint8_t)(fit & 0xFF);
+    buf[2] = (uint8_t)(fit >> 8);
+    uint8_t *out = buf + 3;
+    for (size_t i = 0; i < fit; i++, pixels += bpp, out += bpp) {
+        out[0] = pixels[fmt->r];
+        out[1] = pixels[fmt->g];
+        out[2] = pixels[fmt->b];
+        if (bpp == 4) out[3] = pixels[fmt->w];
+    }
+    return 3 + fit * (size_t)bpp;
+}
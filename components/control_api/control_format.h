@@ -0,0 +1,60 @@
+#pragma once
+#include "alarm_manager.h"
+#include "neopixel_animations.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Request parsing and response formatting for the control API. Pure C (no
+ * httpd/IDF calls) so it can be driven by a stand-in client on the host. */
+
+typedef struct {
+    uint8_t brightness;
+    bool anim_active;
+    bool wifi_connected;
+    int time_quality;       // time_quality_t
+    int64_t now;            // epoch seconds
+    uint32_t uptime_s;
+    uint32_t stream_frames; // DDP stream mode counters
+    uint32_t stream_lost;
+    neopixel_jitter_stats_t jitter; // render task frame pacing
+} control_status_t;
+
+/**
+ * Find key in an application/x-www-form-urlencoded body (or query string)
+ * and URL-decode its value into out.
+ * @return false if the key is missing or the value does not fit
+ */
+bool control_form_get(const char *body, const char *key, char *out, size_t out_len);
+
+/** control_form_get() + decimal parse with range check */
+bool control_form_get_int(const char *body, const char *key, int min, int max, int *out);
+
+/** Map an animation name ("breath", "rainbow", "off", ...) to its mode */
+bool control_parse_anim(const char *name, neopixel_anim_mode_t *out);
+const char *control_anim_name(neopixel_anim_mode_t mode);
+
+/**
+ * Format responses as JSON into buf.
+ * @return length written (excluding NUL), or -1 if buf is too small
+ */
+int control_format_alarms(char *buf, size_t len, const alarm_info_t *alarms, int n);
+int control_format_status(char *buf, size_t len, const control_status_t *st);
+int control_format_result(char *buf, size_t len, bool ok, const char *msg);
+
+/**
+ * WebSocket preview frame: [bytes per LED][LED count lo][LED count hi] + pixels
+ * as R,G,B[,W] whatever the strip's wire order, truncated to whole LEDs that
+ * fit in len.
+ * @return frame length
+ */
+size_t control_format_frame(uint8_t *buf, size_t len, const uint8_t *pixels,
+                            int count, const neopixel_format_t *fmt);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,275 @@
+#include "event_dispatcher.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+static const char *TAG = "event_dispatcher";
+
+#define DISPATCH_QUEUE_LEN   8      // per priority
+#define DISPATCH_MAX_STATS   16     // distinct callbacks tracked
+#define DISPATCH_SLOW_US     20000  // warn when a callback runs longer than this
+#define DISPATCH_TASK_STACK  4096
+#define DISPATCH_TASK_PRIO   CONFIG_EVENT_DISPATCHER_TASK_PRIORITY
+#define DISPATCH_TASK_CORE   (CONFIG_EVENT_DISPATCHER_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_EVENT_DISPATCHER_TASK_CORE)
+#define DISPATCH_MAX_TIMERS  8
+
+typedef struct {
+    dispatch_cb_t cb;
+    void *user_data;
+    const char *name;
+    int64_t t_post_us;
+} dispatch_evt_t;
+
+static QueueHandle_t s_queues[DISPATCH_PRIO_COUNT];
+static TaskHandle_t s_task = NULL;
+static volatile uint32_t s_dropped = 0;
+
+typedef struct {
+    bool used;
+    bool armed;
+    dispatch_cb_t cb;
+    void *user_data;
+    const char *name;
+    int64_t due_us;
+    uint32_t period_us;
+} dispatch_timer_slot_t;
+
+static dispatch_timer_slot_t s_timers[DISPATCH_MAX_TIMERS];
+static portMUX_TYPE s_timer_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static dispatch_stats_t s_stats[DISPATCH_MAX_STATS];
+static int s_stats_count = 0;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void record_stats(dispatch_cb_t cb, const char *name, uint32_t run_us, uint32_t wait_us) {
+    taskENTER_CRITICAL(&s_stats_lock);
+    dispatch_stats_t *st = NULL;
+    for (int i = 0; i < s_stats_count; i++) {
+        if (s_stats[i].cb == cb) { st = &s_stats[i]; break; }
+    }
+    if (!st && s_stats_count < DISPATCH_MAX_STATS) {
+        st = &s_stats[s_stats_count++];
+        memset(st, 0, sizeof(*st));
+        st->cb = cb;
+        st->name = name;
+    }
+    if (st) {
+        st->calls++;
+        st->total_us += run_us;
+        if (run_us > st->max_us) st->max_us = run_us;
+        if (wait_us > st->max_wait_us) st->max_wait_us = wait_us;
+    }
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+static bool take_next(dispatch_evt_t *evt) {
+    for (int p = 0; p < DISPATCH_PRIO_COUNT; p++) {
+        if (xQueueReceive(s_queues[p], evt, 0) == pdTRUE) return true;
+    }
+    return false;
+}
+
+static void run_cb(dispatch_cb_t cb, void *user_data, const char *name, int64_t since_us) {
+    int64_t t0 = esp_timer_get_time();
+    cb(user_data);
+    int64_t t1 = esp_timer_get_time();
+
+    uint32_t run_us = (uint32_t)(t1 - t0);
+    uint32_t wait_us = t0 > since_us ? (uint32_t)(t0 - since_us) : 0;
+    record_stats(cb, name, run_us, wait_us);
+    if (run_us > DISPATCH_SLOW_US) {
+        ESP_LOGW(TAG, "Slow callback '%s' took %u us", name ? name : "?", (unsigned)run_us);
+    }
+}
+
+/* Run every timer whose deadline has passed (each at most once per pass) */
+static void run_due_timers(void) {
+    for (int i = 0; i < DISPATCH_MAX_TIMERS; i++) {
+        taskENTER_CRITICAL(&s_timer_lock);
+        dispatch_timer_slot_t *t = &s_timers[i];
+        const int64_t now = esp_timer_get_time();
+        if (!t->used || !t->armed || t->due_us > now) {
+            taskEXIT_CRITICAL(&s_timer_lock);
+            continue;
+        }
+        dispatch_cb_t cb = t->cb;
+        void *ud = t->user_data;
+        const char *name = t->name;
+        int64_t due = t->due_us;
+        if (t->period_us) {
+            t->due_us += t->period_us;
+            if (t->due_us <= now) t->due_us = now + t->period_us;   // don't replay missed periods
+        } else {
+            t->armed = false;
+        }
+        taskEXIT_CRITICAL(&s_timer_lock);
+        run_cb(cb, ud, name, due);
+    }
+}
+
+/* Ticks until the earliest armed timer, rounded up so we wake past it */
+static TickType_t ticks_to_next_timer(void) {
+    int64_t next = INT64_MAX;
+    taskENTER_CRITICAL(&s_timer_lock);
+    for (int i = 0; i < DISPATCH_MAX_TIMERS; i++) {
+        if (s_timers[i].used && s_timers[i].armed && s_timers[i].due_us < next) {
+            next = s_timers[i].due_us;
+        }
+    }
+    taskEXIT_CRITICAL(&s_timer_lock);
+    if (next == INT64_MAX) return portMAX_DELAY;
+    int64_t wait_us = next - esp_timer_get_time();
+    if (wait_us <= 0) return 0;
+    const int64_t tick_us = 1000000 / configTICK_RATE_HZ;
+    return (TickType_t)((wait_us + tick_us - 1) / tick_us);
+}
+
+static void dispatcher_task(void *arg) {
+    (void)arg;
+    dispatch_evt_t evt;
+    while (1) {
+        // Sleep until a post or the next timer deadline; then run what is due
+        ulTaskNotifyTake(pdTRUE, ticks_to_next_timer());
+        run_due_timers();
+        while (take_next(&evt)) {
+            run_cb(evt.cb, evt.user_data, evt.name, evt.t_post_us);
+        }
+    }
+}
+
+bool event_dispatcher_init(void) {
+    if (s_task) return true;
+    for (int p = 0; p < DISPATCH_PRIO_COUNT; p++) {
+        s_queues[p] = xQueueCreate(DISPATCH_QUEUE_LEN, sizeof(dispatch_evt_t));
+        if (!s_queues[p]) return false;
+    }
+    xTaskCreatePinnedToCore(dispatcher_task, "dispatch_task", DISPATCH_TASK_STACK, NULL,
+                            DISPATCH_TASK_PRIO, &s_task, DISPATCH_TASK_CORE);
+    return s_task != NULL;
+}
+
+bool event_dispatcher_post(dispatch_cb_t cb, void *user_data,
+                           dispatch_prio_t prio, const char *name) {
+    if (!cb || !s_task || prio >= DISPATCH_PRIO_COUNT) return false;
+    dispatch_evt_t evt = {
+        .cb = cb, .user_data = user_data, .name = name,
+        .t_post_us = esp_timer_get_time()
+    };
+    if (xQueueSend(s_queues[prio], &evt, 0) != pdTRUE) {
+        s_dropped++;
+        ESP_LOGW(TAG, "Queue %d full, dropped '%s'", (int)prio, name ? name : "?");
+        return false;
+    }
+    xTaskNotifyGive(s_task);
+    return true;
+}
+
+bool IRAM_ATTR event_dispatcher_post_from_isr(dispatch_cb_t cb, void *user_data,
+                                              dispatch_prio_t prio, const char *name) {
+    if (!cb || !s_task || prio >= DISPATCH_PRIO_COUNT) return false;
+    dispatch_evt_t evt = {
+        .cb = cb, .user_data = user_data, .name = name,
+        .t_post_us = esp_timer_get_time()
+    };
+    BaseType_t hp_task_woken = pdFALSE;
+    if (xQueueSendFromISR(s_queues[prio], &evt, &hp_task_woken) != pdTRUE) {
+        s_dropped++;
+        return false;
+    }
+    vTaskNotifyGiveFromISR(s_task, &hp_task_woken);
+    if (hp_task_woken) {
+        portYIELD_FROM_ISR();
+    }
+    return true;
+}
+
+dispatch_timer_t event_dispatcher_timer_create(dispatch_cb_t cb, void *user_data,
+                                               const char *name) {
+    if (!cb) return DISPATCH_TIMER_INVALID;
+    dispatch_timer_t id = DISPATCH_TIMER_INVALID;
+    taskENTER_CRITICAL(&s_timer_lock);
+    for (int i = 0; i < DISPATCH_MAX_TIMERS; i++) {
+        if (s_timers[i].used) continue;
+        s_timers[i] = (dispatch_timer_slot_t){
+            .used = true, .cb = cb, .user_data = user_data, .name = name
+        };
+        id = i;
+        break;
+    }
+    taskEXIT_CRITICAL(&s_timer_lock);
+    if (id == DISPATCH_TIMER_INVALID) ESP_LOGE(TAG, "No free timer for '%s'", name ? name : "?");
+    return id;
+}
+
+static bool timer_arm(dispatch_timer_t t, int64_t due_us, uint32_t period_us) {
+    if (t < 0 || t >= DISPATCH_MAX_TIMERS) return false;
+    taskENTER_CRITICAL(&s_timer_lock);
+    bool ok = s_timers[t].used;
+    if (ok) {
+        s_timers[t].due_us = due_us;
+        s_timers[t].period_us = period_us;
+        s_timers[t].armed = true;
+    }
+    taskEXIT_CRITICAL(&s_timer_lock);
+    // Let the worker recompute its sleep
+    if (ok && s_task) xTaskNotifyGive(s_task);
+    return ok;
+}
+
+bool event_dispatcher_timer_start(dispatch_timer_t t, uint32_t delay_ms, uint32_t period_ms) {
+    return timer_arm(t, esp_timer_get_time() + (int64_t)delay_ms * 1000, period_ms * 1000U);
+}
+
+bool event_dispatcher_timer_start_at(dispatch_timer_t t, int64_t due_us) {
+    return timer_arm(t, due_us, 0);
+}
+
+void event_dispatcher_timer_stop(dispatch_timer_t t) {
+    if (t < 0 || t >= DISPATCH_MAX_TIMERS) return;
+    taskENTER_CRITICAL(&s_timer_lock);
+    s_timers[t].armed = false;
+    taskEXIT_CRITICAL(&s_timer_lock);
+}
+
+int64_t event_dispatcher_timer_due_us(dispatch_timer_t t) {
+    if (t < 0 || t >= DISPATCH_MAX_TIMERS) return -1;
+    taskENTER_CRITICAL(&s_timer_lock);
+    int64_t due = s_timers[t].armed ? s_timers[t].due_us : -1;
+    taskEXIT_CRITICAL(&s_timer_lock);
+    return due;
+}
+
+int event_dispatcher_get_stats(dispatch_stats_t *out, int max) {
+    taskENTER_CRITICAL(&s_stats_lock);
+    int n = (s_stats_count < max) ? s_stats_count : max;
+    memcpy(out, s_stats, n * sizeof(dispatch_stats_t));
+    taskEXIT_CRITICAL(&s_stats_lock);
+    return n;
+}
+
+uint32_t event_dispatcher_dropped(void) { return s_dropped; }
+
+void event_dispatcher_log_stats(void) {
+    dispatch_stats_t st[DISPATCH_MAX_STATS];
+    int n = event_dispatcher_get_stats(st, DISPATCH_MAX_STATS);
+    ESP_LOGI(TAG, "%-16s %8s %10s %10s %10s", "callback", "calls", "avg_us", "max_us", "maxwait_us");
+    for (int i = 0; i < n; i++) {
+        uint32_t avg = st[i].calls ? (uint32_t)(st[i].total_us / st[i].calls) : 0;
+        ESP_LOGI(TAG, "%-16s %8u %10u %10u %10u",
+                 st[i].name ? st[i].name : "?", (unsigned)st[i].calls,
+                 (unsigned)avg, (unsigned)st[i].max_us, (unsigned)st[i].max_wait_us);
+    }
+    ESP_LOGI(TAG, "dropped=%u", (unsigned)s_dropped);
+}
+
+void event_dispatcher_log_memory(void) {
+    ESP_LOGI(TAG, "heap free %u (min %u) bytes, dispatch_task stack headroom %u bytes",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_DEFAULT),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT),
+             s_task ? (unsigned)uxTaskGetStackHighWaterMark(s_task) : 0);
+}
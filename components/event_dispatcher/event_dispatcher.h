@@ -0,0 +1,91 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*dispatch_cb_t)(void *user_data);
+
+typedef enum {
+    DISPATCH_PRIO_HIGH,     // alarms, user-visible reactions
+    DISPATCH_PRIO_NORMAL,   // duration timers
+    DISPATCH_PRIO_LOW,      // housekeeping (flash flushes, stats)
+    DISPATCH_PRIO_COUNT
+} dispatch_prio_t;
+
+typedef struct {
+    dispatch_cb_t cb;
+    const char *name;       // name given on first post
+    uint32_t calls;
+    uint32_t max_us;        // longest single run
+    uint64_t total_us;
+    uint32_t max_wait_us;   // longest time spent queued before running
+} dispatch_stats_t;
+
+/**
+ * Start the dispatcher worker (safe to call more than once).
+ * Callbacks posted to it run in the worker task, highest priority first,
+ * FIFO within a priority.
+ * @return true on success
+ */
+bool event_dispatcher_init(void);
+
+/**
+ * Queue cb(user_data) for execution. Never blocks; only enqueues.
+ * @param name  Static label used in stats/logs (may be NULL)
+ * @return false if the queue for that priority is full (event dropped)
+ */
+bool event_dispatcher_post(dispatch_cb_t cb, void *user_data,
+                           dispatch_prio_t prio, const char *name);
+
+/** Same as event_dispatcher_post(), callable from an ISR */
+bool event_dispatcher_post_from_isr(dispatch_cb_t cb, void *user_data,
+                                    dispatch_prio_t prio, const char *name);
+
+/**
+ * Copy per-callback timing stats.
+ * @return number of entries written (<= max)
+ */
+int event_dispatcher_get_stats(dispatch_stats_t *out, int max);
+
+/* ---- Timer sources ----
+ * Timers are serviced by the dispatcher worker itself: it sleeps until the
+ * earliest deadline (or a post), so managers need no task of their own and no
+ * FreeRTOS timer hop. Callbacks run inline in the worker, before queued events. */
+
+typedef int dispatch_timer_t;
+#define DISPATCH_TIMER_INVALID (-1)
+
+/** @return timer handle, or DISPATCH_TIMER_INVALID if the table is full */
+dispatch_timer_t event_dispatcher_timer_create(dispatch_cb_t cb, void *user_data,
+                                               const char *name);
+
+/**
+ * (Re)arm a timer from any task. Re-arming replaces the previous deadline.
+ * @param delay_ms   first expiry (0 = on the next worker pass)
+ * @param period_ms  0 = one-shot, otherwise repeat interval
+ */
+bool event_dispatcher_timer_start(dispatch_timer_t t, uint32_t delay_ms, uint32_t period_ms);
+
+/** One-shot at an absolute esp_timer time (us) */
+bool event_dispatcher_timer_start_at(dispatch_timer_t t, int64_t due_us);
+
+void event_dispatcher_timer_stop(dispatch_timer_t t);
+
+/** esp_timer time (us) of the next expiry, or -1 when not armed */
+int64_t event_dispatcher_timer_due_us(dispatch_timer_t t);
+
+/** Number of events dropped because a queue was full */
+uint32_t event_dispatcher_dropped(void);
+
+/** Log the per-callback timing table */
+void event_dispatcher_log_stats(void);
+
+/** Log free heap (current/minimum) and the worker's stack high-water mark */
+void event_dispatcher_log_memory(void);
+
+#ifdef __cplusplus
+}
+#endif
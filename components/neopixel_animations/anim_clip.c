@@ -0,0 +1,177 @@
+#include "anim_clip.h"
+#include <string.h>
+
+#define OP_HEADER_LEN   5       // kind, start, n
+#define MERGE_GAP       2       // unchanged LEDs cheaper to resend than to start a new op
+#define FILL_MIN        3       // shortest run of equal LEDs worth a FILL op
+
+static inline uint16_t rd16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void wr16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void wr32(uint8_t *p, uint32_t v) {
+    wr16(p, (uint16_t)v);
+    wr16(p + 2, (uint16_t)(v >> 16));
+}
+
+size_t anim_clip_parse(const uint8_t *p, size_t len, anim_clip_t *out) {
+    if (!p || len < ANIM_CLIP_HEADER_LEN || memcmp(p, ANIM_CLIP_MAGIC, 4) != 0) return 0;
+    if (p[4] != ANIM_CLIP_VERSION || (p[5] != 3 && p[5] != 4)) return 0;
+    anim_clip_info_t info = {
+        .channels = p[5],
+        .leds = rd16(p + 6),
+        .frame_ms = rd16(p + 8),
+        .flags = rd16(p + 10),
+        .frames = rd32(p + 12),
+        .data_len = rd32(p + 16),
+    };
+    if (info.frame_ms == 0 || info.data_len > len - ANIM_CLIP_HEADER_LEN) return 0;
+    memcpy(info.name, p + 20, ANIM_CLIP_NAME_LEN);
+    info.name[ANIM_CLIP_NAME_LEN] = '\0';
+    if (out) {
+        out->info = info;
+        out->data = p + ANIM_CLIP_HEADER_LEN;
+        out->pos = 0;
+        out->frame = 0;
+    }
+    return ANIM_CLIP_HEADER_LEN + info.data_len;
+}
+
+bool anim_clip_find(const uint8_t *image, size_t len, const char *name, anim_clip_t *out) {
+    size_t off = 0;
+    anim_clip_t c;
+    while (off < len) {
+        const size_t n = anim_clip_parse(image + off, len - off, &c);
+        if (n == 0) break;
+        if (strncmp(c.info.name, name, ANIM_CLIP_NAME_LEN) == 0) {
+            *out = c;
+            return true;
+        }
+        off += n;
+    }
+    return false;
+}
+
+void anim_clip_rewind(anim_clip_t *c) {
+    c->pos = 0;
+    c->frame = 0;
+}
+
+bool anim_clip_next(anim_clip_t *c, uint8_t *frame, const neopixel_format_t *fmt, int count) {
+    if (c->frame >= c->info.frames || c->info.data_len - c->pos < 2) return false;
+    const uint8_t *p = c->data + c->pos;
+    const uint32_t payload = rd16(p);
+    if (payload > c->info.data_len - c->pos - 2) return false;
+    const uint8_t *op = p + 2, *end = op + payload;
+    const int ch = c->info.channels;
+
+    while (op < end) {
+        if (end - op < OP_HEADER_LEN) return false;
+        const uint8_t kind = op[0];
+        int start = rd16(op + 1), n = rd16(op + 3);
+        const uint8_t *src = op + OP_HEADER_LEN;
+        const size_t src_len = kind == ANIM_CLIP_OP_FILL ? (size_t)ch : (size_t)n * ch;
+        if (kind > ANIM_CLIP_OP_FILL || (size_t)(end - src) < src_len) return false;
+        op = src + src_len;
+
+        if (start >= count) continue;
+        if (n > count - start) n = count - start;
+        uint8_t *dst = frame + start * fmt->bpp;
+        if (kind == ANIM_CLIP_OP_FILL) {
+            fmt->fill(dst, n, src[0], src[1], src[2], ch == 4 ? src[3] : 0);
+        } else if (ch == 4) {
+            fmt->blit_rgbw(dst, src, n);
+        } else {
+            fmt->blit_rgb(dst, src, n);
+        }
+    }
+    c->pos += 2 + payload;
+    c->frame++;
+    return true;
+}
+
+size_t anim_clip_write_header(uint8_t *out, const anim_clip_info_t *info) {
+    memcpy(out, ANIM_CLIP_MAGIC, 4);
+    out[4] = ANIM_CLIP_VERSION;
+    out[5] = info->channels;
+    wr16(out + 6, info->leds);
+    wr16(out + 8, info->frame_ms);
+    wr16(out + 10, info->flags);
+    wr32(out + 12, info->frames);
+    wr32(out + 16, info->data_len);
+    memset(out + 20, 0, ANIM_CLIP_NAME_LEN);
+    memcpy(out + 20, info->name, strnlen(info->name, ANIM_CLIP_NAME_LEN));
+    return ANIM_CLIP_HEADER_LEN;
+}
+
+static bool same_pixel(const uint8_t *a, const uint8_t *b, int ch) {
+    return memcmp(a, b, (size_t)ch) == 0;
+}
+
+/* Equal pixels starting at i, up to end */
+static int run_len(const uint8_t *cur, int i, int end, int ch) {
+    int r = 1;
+    while (i + r < end && same_pixel(cur + (i + r) * ch, cur + i * ch, ch)) r++;
+    return r;
+}
+
+/* Append one op; returns bytes written or 0 if it does not fit */
+static size_t put_op(uint8_t *out, size_t room, uint8_t kind, int start, int n,
+                     const uint8_t *src, size_t src_len) {
+    if (room < OP_HEADER_LEN + src_len) return 0;
+    out[0] = kind;
+    wr16(out + 1, (uint16_t)start);
+    wr16(out + 3, (uint16_t)n);
+    memcpy(out + OP_HEADER_LEN, src, src_len);
+    return OP_HEADER_LEN + src_len;
+}
+
+size_t anim_clip_encode_frame(uint8_t *out, size_t len, const uint8_t *prev, const uint8_t *cur,
+                              int leds, int channels) {
+    if (len < 2) return 0;
+    size_t o = 2;
+    int i = 0;
+    while (i < leds) {
+        if (prev && same_pixel(prev + i * channels, cur + i * channels, channels)) {
+            i++;
+            continue;
+        }
+        // Changed span, absorbing short unchanged gaps
+        int e = i + 1;
+        for (int j = e; j < leds && j - e < MERGE_GAP + 1; j++) {
+            if (!prev || !same_pixel(prev + j * channels, cur + j * channels, channels)) e = j + 1;
+        }
+        // Split it into FILL runs and COPY stretches between them
+        int k = i;
+        while (k < e) {
+            int r = run_len(cur, k, e, channels);
+            size_t n;
+            if (r >= FILL_MIN) {
+                n = put_op(out + o, len - o, ANIM_CLIP_OP_FILL, k, r, cur + k * channels,
+                           (size_t)channels);
+            } else {
+                int c = k + r;
+                while (c < e && (r = run_len(cur, c, e, channels)) < FILL_MIN) c += r;
+                r = c - k;
+                n = put_op(out + o, len - o, ANIM_CLIP_OP_COPY, k, r, cur + k * channels,
+                           (size_t)r * channels);
+            }
+            if (n == 0) return 0;
+            o += n;
+            k += r;
+        }
+        i = e;
+    }
+    if (o - 2 > UINT16_MAX) return 0;
+    wr16(out, (uint16_t)(o - 2));
+    return o;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "neopixel_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Precomputed animation clips. Pure C (no IDF dependencies): the firmware
+ * plays clips straight out of a memory-mapped flash partition, and the host
+ * tool (host/clip_main.c) renders and writes them.
+ *
+ * A clip image is clips back to back, each a header followed by its frame
+ * records; the first bytes that are not a clip header (erased flash) end it.
+ * All integers are little endian.
+ *
+ *   header   "ACLP", version, channels (3 = RGB, 4 = RGBW), leds u16,
+ *            frame_ms u16, flags u16, frames u32, data_len u32, name[16]
+ *   frame    payload_len u16, then ops until the payload is used up
+ *   op       kind u8, start u16, n u16, then
+ *              COPY: n pixels of channels bytes
+ *              FILL: one pixel, repeated n times
+ *
+ * The first frame writes every LED; later frames only touch what changed
+ * since the previous one, so playback needs the previous frame in place
+ * (the strip buffer) and the decoder never copies a frame out of flash first.
+ */
+
+#define ANIM_CLIP_MAGIC         "ACLP"
+#define ANIM_CLIP_VERSION       1
+#define ANIM_CLIP_HEADER_LEN    36
+#define ANIM_CLIP_NAME_LEN      16      // including the NUL when shorter
+#define ANIM_CLIP_FLAG_LOOP     0x0001
+
+#define ANIM_CLIP_OP_COPY       0
+#define ANIM_CLIP_OP_FILL       1
+
+typedef struct {
+    char name[ANIM_CLIP_NAME_LEN + 1];
+    uint8_t channels;
+    uint16_t leds;
+    uint16_t frame_ms;
+    uint16_t flags;
+    uint32_t frames;
+    uint32_t data_len;          // bytes of frame records after the header
+} anim_clip_info_t;
+
+typedef struct {
+    anim_clip_info_t info;
+    const uint8_t *data;        // first frame record (inside the mapped image)
+    uint32_t pos;               // next record, offset into data
+    uint32_t frame;             // index of the next frame
+} anim_clip_t;
+
+/**
+ * Parse the clip header at p.
+ * @return bytes the whole clip occupies (header + frames), 0 if p does not
+ *         hold a valid clip within len
+ */
+size_t anim_clip_parse(const uint8_t *p, size_t len, anim_clip_t *out);
+
+/** Find a clip by name in an image; false if absent */
+bool anim_clip_find(const uint8_t *image, size_t len, const char *name, anim_clip_t *out);
+
+/**
+ * Apply the next frame to a strip buffer laid out as fmt (count LEDs; spans
+ * past it are clipped) through the format's span kernels.
+ * @return false at the end of the clip or on a corrupt record
+ */
+bool anim_clip_next(anim_clip_t *c, uint8_t *frame, const neopixel_format_t *fmt, int count);
+
+/** Back to the first frame */
+void anim_clip_rewind(anim_clip_t *c);
+
+/* ---- Writing (host tool) ---- */
+
+/** Serialize a header; returns ANIM_CLIP_HEADER_LEN */
+size_t anim_clip_write_header(uint8_t *out, const anim_clip_info_t *info);
+
+/**
+ * Encode cur as a frame record against prev (NULL for a full first frame).
+ * Pixels are info->channels bytes each, RGB(W).
+ * @return record length, 0 if out is too small
+ */
+size_t anim_clip_encode_frame(uint8_t *out, size_t len, const uint8_t *prev, const uint8_t *cur,
+                              int leds, int channels);
+
+#ifdef __cplusplus
+}
+#endif
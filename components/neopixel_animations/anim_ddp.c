@@ -0,0 +1,55 @@
+#include "anim_ddp.h"
+#include <string.h>
+
+bool ddp_parse(const uint8_t *buf, size_t len, ddp_packet_t *out) {
+    if (len < DDP_HEADER_LEN) return false;
+    if ((buf[0] & DDP_FLAG_VER_MASK) != DDP_FLAG_VER1) return false;
+    size_t hdr = (buf[0] & DDP_FLAG_TIMECODE) ? DDP_HEADER_LEN + 4 : DDP_HEADER_LEN;
+    if (len < hdr) return false;
+
+    out->flags = buf[0];
+    out->seq = buf[1] & 0x0F;
+    out->type = buf[2];
+    out->id = buf[3];
+    out->offset = (uint32_t)buf[4] << 24 | (uint32_t)buf[5] << 16 |
+                  (uint32_t)buf[6] << 8 | buf[7];
+    out->len = (uint16_t)(buf[8] << 8 | buf[9]);
+    out->data = buf + hdr;
+    // Trust the datagram size over a lying length field
+    if (out->len > len - hdr) out->len = (uint16_t)(len - hdr);
+    return true;
+}
+
+int ddp_bytes_per_pixel(const ddp_packet_t *p) {
+    // Type byte: C R TTT SSS; TTT 3 = RGBW
+    return ((p->type >> 3) & 0x07) == 3 ? 4 : 3;
+}
+
+int ddp_seq_gap(uint8_t last, uint8_t seq) {
+    if (last == 0 || seq == 0) return 0;
+    int diff = ((int)seq - (int)last + 15) % 15;   // sequence runs 1..15
+    return diff == 0 ? -1 : diff - 1;
+}
+
+int ddp_copy_pixels(uint8_t *frame, int count, const neopixel_format_t *fmt,
+                    const ddp_packet_t *p) {
+    int in_bpp = ddp_bytes_per_pixel(p);
+    if (p->offset % (uint32_t)in_bpp) return 0;   // not pixel aligned
+    uint32_t first = p->offset / (uint32_t)in_bpp;
+    if (first >= (uint32_t)count) return 0;
+    int n = p->len / in_bpp;
+    if (n > count - (int)first) n = count - (int)first;
+
+    uint8_t *dst = frame + first * fmt->bpp;
+    if (in_bpp == 4) fmt->blit_rgbw(dst, p->data, n);
+    else             fmt->blit_rgb(dst, p->data, n);
+    return n;
+}
+
+void ddp_build_reply(uint8_t out[DDP_HEADER_LEN], const ddp_packet_t *p) {
+    memset(out, 0, DDP_HEADER_LEN);
+    out[0] = DDP_FLAG_VER1 | DDP_FLAG_REPLY | DDP_FLAG_PUSH;
+    out[1] = p->seq;
+    out[2] = p->type;
+    out[3] = p->id;
+}
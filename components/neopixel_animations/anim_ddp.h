@@ -0,0 +1,60 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "neopixel_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* DDP (Distributed Display Protocol) packet handling for the stream mode.
+ * Pure C (no IDF dependencies) so the parser can be checked on the host. */
+
+#define DDP_PORT            4048
+#define DDP_HEADER_LEN      10
+#define DDP_MAX_PACKET      1460    // 480 RGB pixels per packet
+
+#define DDP_FLAG_VER1       0x40
+#define DDP_FLAG_VER_MASK   0xC0
+#define DDP_FLAG_TIMECODE   0x10    // 4 extra header bytes
+#define DDP_FLAG_REPLY      0x04
+#define DDP_FLAG_QUERY      0x02
+#define DDP_FLAG_PUSH       0x01    // last packet of a frame: display now
+
+typedef struct {
+    uint8_t flags;
+    uint8_t seq;            // 1..15, 0 = sender doesn't number packets
+    uint8_t type;
+    uint8_t id;
+    uint32_t offset;        // byte offset into the sender's pixel data
+    uint16_t len;
+    const uint8_t *data;    // points into the received buffer
+} ddp_packet_t;
+
+/** Validate and decode a datagram; false if it is not DDP v1 pixel data */
+bool ddp_parse(const uint8_t *buf, size_t len, ddp_packet_t *out);
+
+/** Source bytes per pixel: 4 for the RGBW data type, otherwise 3 (RGB) */
+int ddp_bytes_per_pixel(const ddp_packet_t *p);
+
+/**
+ * Packets lost between two sequence numbers.
+ * @return 0..13 lost, or -1 when seq repeats last (duplicate)
+ */
+int ddp_seq_gap(uint8_t last, uint8_t seq);
+
+/**
+ * Copy the packet's RGB(W) pixels straight into a frame buffer laid out as fmt
+ * at the packet offset, clipping to the strip.
+ * @return number of pixels written
+ */
+int ddp_copy_pixels(uint8_t *frame, int count, const neopixel_format_t *fmt,
+                    const ddp_packet_t *p);
+
+/** Build the 10-byte reply header echoed for QUERY packets (latency probes) */
+void ddp_build_reply(uint8_t out[DDP_HEADER_LEN], const ddp_packet_t *p);
+
+#ifdef __cplusplus
+}
+#endif
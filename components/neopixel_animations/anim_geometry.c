@@ -0,0 +1,151 @@
+#include "anim_geometry.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TURN    65536.0f
+#define TWO_PI  6.28318531f
+
+static int16_t rd16s(const uint8_t *p) {
+    return (int16_t)(p[0] | p[1] << 8);
+}
+
+static uint16_t rd16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static void wr16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static bool layout_fits(const anim_layout_t *l, int count) {
+    switch (l->kind) {
+        case ANIM_LAYOUT_LINE:
+        case ANIM_LAYOUT_RING:   return true;
+        case ANIM_LAYOUT_MATRIX: return l->width > 0 && count % l->width == 0;
+        case ANIM_LAYOUT_POINTS: return l->points != NULL;
+        default:                 return false;
+    }
+}
+
+/* Angle of LED i in the layouts where it follows from the index */
+static uint16_t index_angle(const anim_layout_t *l, int i, int count) {
+    const uint16_t step = (uint16_t)(((uint64_t)i << 16) / (uint64_t)count);
+    return l->kind == ANIM_LAYOUT_RING ? (uint16_t)(l->rotation + step) : step;
+}
+
+/* Physical position of LED i, in the layout's own units */
+static void position(const anim_layout_t *l, int i, int count, float *fx, float *fy) {
+    switch (l->kind) {
+        case ANIM_LAYOUT_RING: {
+            const float a = (float)index_angle(l, i, count) * (TWO_PI / TURN);
+            *fx = cosf(a);
+            *fy = sinf(a);
+            break;
+        }
+        case ANIM_LAYOUT_MATRIX: {
+            const int row = i / l->width;
+            int col = i % l->width;
+            if (l->serpentine && (row & 1)) col = l->width - 1 - col;
+            *fx = (float)col;
+            *fy = (float)row;
+            break;
+        }
+        case ANIM_LAYOUT_POINTS:
+            *fx = (float)rd16s(&l->points[i * 4]);
+            *fy = (float)rd16s(&l->points[i * 4 + 2]);
+            break;
+        default:
+            *fx = (float)i;
+            *fy = 0.0f;
+            break;
+    }
+}
+
+/* v in lo..lo+span as 0..65535; the middle when the span is empty */
+static uint16_t unit(float v, float lo, float span) {
+    if (span <= 0.0f) return 32768;
+    return (uint16_t)((v - lo) / span * 65535.0f + 0.5f);
+}
+
+bool anim_geometry_build(anim_geometry_t *g, const anim_layout_t *layout, int count) {
+    if (!g || !layout || count <= 0 || !layout_fits(layout, count)) return false;
+    anim_point_t *pts = malloc((size_t)count * sizeof(*pts));
+    if (!pts) return false;
+
+    float x0 = INFINITY, y0 = INFINITY, x1 = -INFINITY, y1 = -INFINITY;
+    for (int i = 0; i < count; i++) {
+        float fx, fy;
+        position(layout, i, count, &fx, &fy);
+        x0 = fminf(x0, fx); x1 = fmaxf(x1, fx);
+        y0 = fminf(y0, fy); y1 = fmaxf(y1, fy);
+    }
+    const float cx = (x0 + x1) * 0.5f, cy = (y0 + y1) * 0.5f;
+    float rmax = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float fx, fy;
+        position(layout, i, count, &fx, &fy);
+        rmax = fmaxf(rmax, hypotf(fx - cx, fy - cy));
+    }
+
+    const bool by_index = layout->kind == ANIM_LAYOUT_LINE || layout->kind == ANIM_LAYOUT_RING;
+    for (int i = 0; i < count; i++) {
+        float fx, fy;
+        position(layout, i, count, &fx, &fy);
+        anim_point_t *p = &pts[i];
+        p->x = unit(fx, x0, x1 - x0);
+        p->y = unit(fy, y0, y1 - y0);
+        if (by_index) {
+            p->angle = index_angle(layout, i, count);
+        } else {
+            float a = atan2f(fy - cy, fx - cx);
+            if (a < 0.0f) a += TWO_PI;
+            p->angle = (uint16_t)(uint32_t)(a * (TURN / TWO_PI) + 0.5f);
+        }
+        p->radius = rmax > 0.0f ? unit(hypotf(fx - cx, fy - cy), 0.0f, rmax) : 0;
+    }
+    free(g->pts);
+    g->pts = pts;
+    g->count = count;
+    return true;
+}
+
+void anim_geometry_free(anim_geometry_t *g) {
+    if (!g) return;
+    free(g->pts);
+    g->pts = NULL;
+    g->count = 0;
+}
+
+bool anim_layout_parse(const uint8_t *blob, size_t len, int count, anim_layout_t *out) {
+    if (!blob || len < ANIM_LAYOUT_HEADER_LEN || count <= 0) return false;
+    anim_layout_t l = {
+        .kind = (anim_layout_kind_t)blob[0],
+        .serpentine = (blob[1] & ANIM_LAYOUT_FLAG_SERPENTINE) != 0,
+        .width = rd16(&blob[2]),
+        .rotation = rd16(&blob[4]),
+    };
+    if (l.kind == ANIM_LAYOUT_POINTS) {
+        if (len != ANIM_LAYOUT_LEN(count)) return false;
+        l.points = blob + ANIM_LAYOUT_HEADER_LEN;
+    } else if (len != ANIM_LAYOUT_HEADER_LEN) {
+        return false;
+    }
+    if (!layout_fits(&l, count)) return false;
+    *out = l;
+    return true;
+}
+
+size_t anim_layout_encode(uint8_t *out, size_t len, const anim_layout_t *layout, int count) {
+    const bool points = layout->kind == ANIM_LAYOUT_POINTS;
+    const size_t need = points ? ANIM_LAYOUT_LEN(count) : ANIM_LAYOUT_HEADER_LEN;
+    if (count <= 0 || len < need || (points && !layout->points)) return 0;
+    out[0] = (uint8_t)layout->kind;
+    out[1] = layout->serpentine ? ANIM_LAYOUT_FLAG_SERPENTINE : 0;
+    wr16(&out[2], layout->width);
+    wr16(&out[4], layout->rotation);
+    wr16(&out[6], 0);
+    if (points) memcpy(out + ANIM_LAYOUT_HEADER_LEN, layout->points, (size_t)count * 4);
+    return need;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Physical LED layout for 2D and ring effects. A layout is turned once into a
+ * table of fixed-point coordinates per LED, so effects index the table instead
+ * of doing trig per pixel per frame. Pure C, like anim_kernels.
+ */
+
+typedef enum {
+    ANIM_LAYOUT_LINE,           // a straight strip
+    ANIM_LAYOUT_RING,           // evenly spaced around a circle
+    ANIM_LAYOUT_MATRIX,         // rows of `width` LEDs, wired row after row
+    ANIM_LAYOUT_POINTS,         // arbitrary x,y per LED
+} anim_layout_kind_t;
+
+typedef struct {
+    anim_layout_kind_t kind;
+    uint16_t width;             // MATRIX: LEDs per row; count must be a multiple
+    bool serpentine;            // MATRIX: every other row runs backwards
+    uint16_t rotation;          // RING: angle of LED 0, 65536 = one turn
+    const uint8_t *points;      // POINTS: count x,y pairs, int16 little-endian, any unit
+} anim_layout_t;
+
+/* Coordinates as 16-bit fractions */
+typedef struct {
+    uint16_t x, y;              // across the bounding box, 0..65535 (y down the rows)
+    uint16_t angle;             // around the centre, 65536 = one turn; LINE: along the strip
+    uint16_t radius;            // from the centre, 65535 = the farthest LED
+} anim_point_t;
+
+typedef struct {
+    int count;
+    anim_point_t *pts;          // count entries, in strip order
+} anim_geometry_t;
+
+/**
+ * Precompute the coordinate table (one allocation, freed by
+ * anim_geometry_free()). LINE and RING angles are i / count of a turn, the
+ * same steps as an index gradient.
+ * @return false if the layout does not fit count LEDs or allocation failed
+ */
+bool anim_geometry_build(anim_geometry_t *g, const anim_layout_t *layout, int count);
+void anim_geometry_free(anim_geometry_t *g);
+
+/*
+ * Stored layout (e.g. a settings blob), little-endian:
+ *   kind u8, flags u8 (bit 0 serpentine), width u16, rotation u16, reserved u16,
+ *   then for POINTS count x,y int16 pairs.
+ */
+#define ANIM_LAYOUT_HEADER_LEN      8
+#define ANIM_LAYOUT_FLAG_SERPENTINE 0x01
+#define ANIM_LAYOUT_LEN(count)      (ANIM_LAYOUT_HEADER_LEN + (size_t)(count) * 4)
+
+/** Parse a stored layout; out->points points into blob. false if malformed. */
+bool anim_layout_parse(const uint8_t *blob, size_t len, int count, anim_layout_t *out);
+
+/** @return bytes written, or 0 if out is too small */
+size_t anim_layout_encode(uint8_t *out, size_t len, const anim_layout_t *layout, int count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,86 @@
+#include "anim_kernels.h"
+#include <math.h>
+
+/* Simple and branchy but compact */
+void anim_hsv_to_rgb(float H, uint8_t S, uint8_t V, uint8_t *r, uint8_t *g, uint8_t *b) {
+    if (S == 0) { *r = *g = *b = V; return; }
+    float s = S / 255.0f, v = V / 255.0f;
+    float C = s * v;
+    float Hp = fmodf(H / 60.0f, 6.0f);
+    float X = C * (1.0f - fabsf(fmodf(Hp, 2.0f) - 1.0f));
+    float r1=0, g1=0, b1=0;
+    if      (0.0f <= Hp && Hp < 1.0f) { r1=C; g1=X; b1=0; }
+    else if (1.0f <= Hp && Hp < 2.0f) { r1=X; g1=C; b1=0; }
+    else if (2.0f <= Hp && Hp < 3.0f) { r1=0; g1=C; b1=X; }
+    else if (3.0f <= Hp && Hp < 4.0f) { r1=0; g1=X; b1=C; }
+    else if (4.0f <= Hp && Hp < 5.0f) { r1=X; g1=0; b1=C; }
+    else                               { r1=C; g1=0; b1=X; }
+    float m = v - C;
+    *r = (uint8_t)((r1 + m) * 255.0f);
+    *g = (uint8_t)((g1 + m) * 255.0f);
+    *b = (uint8_t)((b1 + m) * 255.0f);
+}
+
+#define RAINBOW_CHUNK   16      // pixels converted per blit
+#define GRADIENT_CHUNK  16
+
+void anim_rainbow_frame(uint8_t *frame, const neopixel_format_t *fmt, const anim_geometry_t *geo,
+                        int count, float base_h, bool gradient, uint8_t sat, uint8_t val) {
+    uint8_t r, g, b;
+    if (gradient && count > 1) {
+        const anim_point_t *pts = geo && geo->count == count ? geo->pts : NULL;
+        uint8_t rgb[RAINBOW_CHUNK * 3];
+        for (int i0 = 0; i0 < count; i0 += RAINBOW_CHUNK) {
+            const int n = count - i0 < RAINBOW_CHUNK ? count - i0 : RAINBOW_CHUNK;
+            for (int k = 0; k < n; k++) {
+                float h = base_h + (pts ? (float)pts[i0 + k].angle * (360.0f / 65536.0f)
+                                        : 360.0f * ((float)(i0 + k) / (float)count));
+                if (h >= 360.0f) h -= 360.0f;
+                anim_hsv_to_rgb(h, sat, val, &rgb[k * 3], &rgb[k * 3 + 1], &rgb[k * 3 + 2]);
+            }
+            fmt->blit_rgb(&frame[i0 * fmt->bpp], rgb, n);
+        }
+    } else {
+        anim_hsv_to_rgb(base_h, sat, val, &r, &g, &b);
+        fmt->fill(frame, count, r, g, b, 0);
+    }
+}
+
+void anim_fade_frame(uint8_t *frame, const uint8_t *start, const neopixel_format_t *fmt,
+                     int count, const uint8_t target[4], float u) {
+    // Target in wire order once, then every byte lerps the same way
+    uint8_t t[4];
+    fmt->fill(t, 1, target[0], target[1], target[2], target[3]);
+    const int bpp = fmt->bpp;
+    for (int i = 0; i < count * bpp; i += bpp) {
+        for (int c = 0; c < bpp; c++) {
+            const uint8_t s = start[i + c];
+            frame[i + c] = (uint8_t)(s + (int)((int)t[c] - (int)s) * u);
+        }
+    }
+}
+
+static uint16_t coord(const anim_point_t *p, anim_axis_t axis) {
+    switch (axis) {
+        case ANIM_AXIS_Y:      return p->y;
+        case ANIM_AXIS_ANGLE:  return p->angle;
+        case ANIM_AXIS_RADIUS: return p->radius;
+        default:               return p->x;
+    }
+}
+
+void anim_gradient_frame(uint8_t *frame, const neopixel_format_t *fmt, const anim_geometry_t *geo,
+                         anim_axis_t axis, uint16_t offset, const uint8_t from[4],
+                         const uint8_t to[4]) {
+    int32_t d[4];
+    for (int c = 0; c < 4; c++) d[c] = (int32_t)to[c] - from[c];
+    uint8_t rgbw[GRADIENT_CHUNK * 4];
+    for (int i0 = 0; i0 < geo->count; i0 += GRADIENT_CHUNK) {
+        const int n = geo->count - i0 < GRADIENT_CHUNK ? geo->count - i0 : GRADIENT_CHUNK;
+        for (int k = 0; k < n; k++) {
+            const int32_t u = (uint16_t)(coord(&geo->pts[i0 + k], axis) - offset);
+            for (int c = 0; c < 4; c++) rgbw[k * 4 + c] = (uint8_t)(from[c] + ((d[c] * u) >> 16));
+        }
+        fmt->blit_rgbw(&frame[i0 * fmt->bpp], rgbw, n);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "neopixel_format.h"
+#include "anim_geometry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-frame effect kernels used by the render task. Pure C (no IDF
+ * dependencies) so they can be benchmarked and checked on the host.
+ * Frames are in the strip's wire order, written through fmt's kernels. */
+
+/** HSV (0..360, 0..255, 0..255) -> RGB (0..255) */
+void anim_hsv_to_rgb(float h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b);
+
+/**
+ * One smooth-rainbow frame starting at hue base_h (degrees). With gradient the
+ * hue turns once around geo's angle table (or along the strip when geo is NULL
+ * or for another count), otherwise every pixel gets base_h. W is cleared.
+ */
+void anim_rainbow_frame(uint8_t *frame, const neopixel_format_t *fmt, const anim_geometry_t *geo,
+                        int count, float base_h, bool gradient, uint8_t sat, uint8_t val);
+
+typedef enum {
+    ANIM_AXIS_X,
+    ANIM_AXIS_Y,
+    ANIM_AXIS_ANGLE,
+    ANIM_AXIS_RADIUS,
+} anim_axis_t;
+
+/**
+ * Two-colour gradient over one of geo's coordinates, geo->count pixels: from
+ * where the coordinate equals offset to `to` just before it comes round again.
+ * The coordinate wraps, so moving offset scrolls the gradient (on ANGLE, sweeps
+ * it around). Fixed point only.
+ * @param from, to  r, g, b, w
+ */
+void anim_gradient_frame(uint8_t *frame, const neopixel_format_t *fmt, const anim_geometry_t *geo,
+                         anim_axis_t axis, uint16_t offset, const uint8_t from[4],
+                         const uint8_t to[4]);
+
+/**
+ * One fade-to-solid frame: each channel at start + (target - start) * u.
+ * @param start  snapshot of the first frame; may alias frame
+ * @param target r, g, b, w
+ * @param u      progress 0..1
+ */
+void anim_fade_frame(uint8_t *frame, const uint8_t *start, const neopixel_format_t *fmt,
+                     int count, const uint8_t target[4], float u);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,15 +1,93 @@
 #include "neopixel_animations.h"
+#include "anim_ddp.h"
+#include "anim_kernels.h"
+#include "anim_clip.h"
+#include "esp_partition.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "sdkconfig.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 #include <math.h>
 #include <string.h>
 
+static const char *TAG = "neopixel_anim";
+
+#define STREAM_RECV_SLICE_MS 100    // recv timeout; bounds how late a timeout is noticed
+#define CAP_REFRESH_MS       40     // static-frame refresh while the brightness cap slews
+#define FRAME_PERIOD_MS      20     // cadence of the fixed-rate modes
+#define SWEEP_PERIOD_MS      3000   // one turn of the sweep
+#define RENDER_TASK_CORE     (CONFIG_NEOPIXEL_RENDER_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_NEOPIXEL_RENDER_TASK_CORE)
+
 // ===== Existing globals =====
 static neopixel_t *s_strip = NULL;
 static neopixel_anim_mode_t s_mode = NEOPIXEL_ANIM_NONE;
 static TaskHandle_t s_task = NULL;
 static uint8_t s_r=0, s_g=0, s_b=0;
 
+// ===== Layout =====
+static const anim_geometry_t *s_geo = NULL;    // from neopixel_animations_set_geometry()
+static anim_geometry_t s_line_geo;              // fallback: a straight strip
+
+// ===== Power management =====
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_pm_lock = NULL;  // held while frames are being rendered
+#endif
+static bool s_pm_held = false;
+
+static void render_pm_hold(bool hold) {
+    if (hold == s_pm_held) return;
+#if CONFIG_PM_ENABLE
+    if (!s_pm_lock &&
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "anim", &s_pm_lock) != ESP_OK) {
+        return;
+    }
+    if (hold) esp_pm_lock_acquire(s_pm_lock);
+    else esp_pm_lock_release(s_pm_lock);
+#endif
+    neopixel_set_low_power(!hold);
+    s_pm_held = hold;
+}
+
+static void ensure_task(void);
+
+// ===== Frame pacing =====
+static const uint32_t s_jitter_edges_us[NEOPIXEL_JITTER_BUCKETS - 1] = { 250, 1000, 2000, 5000 };
+static neopixel_jitter_stats_t s_jitter;
+static bool s_paced = false;            // last_wake holds a valid cadence reference
+static int64_t s_paced_prev_us = 0;     // previous paced wake-up
+
+static void record_jitter(int64_t dev_us) {
+    const uint32_t d = (uint32_t)(dev_us < 0 ? -dev_us : dev_us);
+    int b = 0;
+    while (b < NEOPIXEL_JITTER_BUCKETS - 1 && d >= s_jitter_edges_us[b]) b++;
+    s_jitter.hist[b]++;
+    s_jitter.frames++;
+    s_jitter.sum_us += d;
+    if (d > s_jitter.max_us) s_jitter.max_us = d;
+}
+
+/* Fixed-rate modes: sleep to the next period boundary (render time does not
+ * stretch the period), then record how far this wake-up landed from one
+ * period after the previous one. */
+static void pace_frame(TickType_t *last_wake, uint32_t period_ms) {
+    if (!s_paced) {
+        *last_wake = xTaskGetTickCount();
+        s_paced_prev_us = 0;
+        s_paced = true;
+    }
+    if (xTaskDelayUntil(last_wake, pdMS_TO_TICKS(period_ms)) == pdFALSE) {
+        *last_wake = xTaskGetTickCount();   // overran: resync rather than burst to catch up
+    }
+    const int64_t now = esp_timer_get_time();
+    if (s_paced_prev_us) record_jitter(now - s_paced_prev_us - (int64_t)period_ms * 1000);
+    s_paced_prev_us = now;
+}
+
 // ===== fade-to-solid state =====
 static uint8_t *s_fade_start = NULL;     // snapshot of starting pixels (GRB/GRBW)
 static uint8_t  s_target_r=0, s_target_g=0, s_target_b=0, s_target_w=0;
@@ -22,25 +100,48 @@ static bool     s_rainbow_gradient = true;  // gradient along strip or uniform
 static uint8_t  s_rainbow_sat = 255;        // saturation 0..255
 static uint8_t  s_rainbow_val = 255;        // value/brightness 0..255
 
-/* HSV (0..360,0..255,0..255) -> RGB (0..255)
-   Simple and branchy but compact; W channel stays 0 (driver cap still applies). */
-static void hsv_to_rgb(float H, uint8_t S, uint8_t V, uint8_t *r, uint8_t *g, uint8_t *b) {
-    if (S == 0) { *r = *g = *b = V; return; }
-    float s = S / 255.0f, v = V / 255.0f;
-    float C = s * v;
-    float Hp = fmodf(H / 60.0f, 6.0f);
-    float X = C * (1.0f - fabsf(fmodf(Hp, 2.0f) - 1.0f));
-    float r1=0, g1=0, b1=0;
-    if      (0.0f <= Hp && Hp < 1.0f) { r1=C; g1=X; b1=0; }
-    else if (1.0f <= Hp && Hp < 2.0f) { r1=X; g1=C; b1=0; }
-    else if (2.0f <= Hp && Hp < 3.0f) { r1=0; g1=C; b1=X; }
-    else if (3.0f <= Hp && Hp < 4.0f) { r1=0; g1=X; b1=C; }
-    else if (4.0f <= Hp && Hp < 5.0f) { r1=X; g1=0; b1=C; }
-    else                               { r1=C; g1=0; b1=X; }
-    float m = v - C;
-    *r = (uint8_t)((r1 + m) * 255.0f);
-    *g = (uint8_t)((g1 + m) * 255.0f);
-    *b = (uint8_t)((b1 + m) * 255.0f);
+// ===== Clip playback state =====
+static const uint8_t *s_clip_image = NULL;  // clips partition, mapped once and kept
+static size_t s_clip_image_len = 0;
+/* s_clip is the render task's decoder state. Other tasks stage a new clip in
+ * s_clip_next (under s_clip_lock) and the render task adopts it in
+ * clip_sync() between slices, so it never decodes a half-copied clip. */
+static anim_clip_t s_clip;
+static anim_clip_t s_clip_next;
+static bool s_clip_pending = false;
+static portMUX_TYPE s_clip_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ===== UDP stream state =====
+/* The render task owns the open socket and prev_frame: it may be blocked in
+ * recvfrom() on one, or restoring the other, at any moment. Other tasks only
+ * say which socket they want (s_stream_want, under s_stream_lock); the render
+ * task adopts or closes accordingly in stream_sync() between slices. */
+typedef struct {
+    int sock;                       // -1 when not listening
+    uint32_t timeout_ms;
+    TickType_t last_rx;
+    uint8_t last_seq;
+    bool push_seen;                 // sender marks frame ends; show only on PUSH
+    neopixel_anim_mode_t prev_mode; // resumed when the stream goes quiet
+    uint8_t *prev_frame;            // restored if nothing was animating
+} stream_state_t;
+
+static stream_state_t s_stream = { .sock = -1 };
+static int s_stream_want = -1;                  // socket the render task should be using
+static uint32_t s_stream_want_timeout_ms;
+static neopixel_anim_mode_t s_stream_want_prev_mode;
+static portMUX_TYPE s_stream_lock = portMUX_INITIALIZER_UNLOCKED;
+static neopixel_stream_stats_t s_stream_stats;
+static uint8_t s_stream_pkt[DDP_MAX_PACKET + 4];   // one static receive buffer, no per-packet allocation
+
+/* The configured layout, or a straight line of the strip's length */
+static const anim_geometry_t *geometry(void) {
+    if (s_geo && s_geo->count == s_strip->count) return s_geo;
+    if (s_line_geo.count != s_strip->count) {
+        const anim_layout_t line = { .kind = ANIM_LAYOUT_LINE };
+        if (!anim_geometry_build(&s_line_geo, &line, s_strip->count)) return NULL;
+    }
+    return &s_line_geo;
 }
 
 static void free_fade_buf(void) {
@@ -49,8 +150,7 @@ static void free_fade_buf(void) {
 
 static void begin_fade_snapshot(uint8_t r, uint8_t g, uint8_t b, uint8_t w, uint32_t dur_ms) {
     free_fade_buf();
-    int bpp = s_strip->use_rgbw ? 4 : 3;
-    size_t bytes = (size_t)s_strip->count * bpp;
+    size_t bytes = (size_t)s_strip->count * s_strip->fmt->bpp;
     s_fade_start = (uint8_t *)pvPortMalloc(bytes);
     if (s_fade_start) {
         memcpy(s_fade_start, s_strip->pixels, bytes); // capture current frame
@@ -60,29 +160,174 @@ static void begin_fade_snapshot(uint8_t r, uint8_t g, uint8_t b, uint8_t w, uint
     s_fade_elapsed_ms = 0;
 }
 
+/* Render task (or with it stopped): drop the socket in use */
+static void stream_close(void) {
+    if (s_stream.sock >= 0) {
+        close(s_stream.sock);
+        s_stream.sock = -1;
+    }
+    if (s_stream.prev_frame) { vPortFree(s_stream.prev_frame); s_stream.prev_frame = NULL; }
+}
+
+/* Any task: ask for sock (or -1 for none). Returns a wanted socket the render
+ * task never adopted, which the caller closes. */
+static int stream_want(int sock, uint32_t timeout_ms, neopixel_anim_mode_t prev_mode) {
+    taskENTER_CRITICAL(&s_stream_lock);
+    int stale = (s_stream_want != s_stream.sock) ? s_stream_want : -1;
+    s_stream_want = sock;
+    s_stream_want_timeout_ms = timeout_ms;
+    s_stream_want_prev_mode = prev_mode;
+    taskEXIT_CRITICAL(&s_stream_lock);
+    return stale;
+}
+
+/* Mode starters: the stream ends; the render task closes it */
+static void stream_release(void) {
+    int stale = stream_want(-1, 0, NEOPIXEL_ANIM_NONE);
+    if (stale >= 0) close(stale);
+}
+
+/* Render task, before every slice: switch to the socket other tasks asked for */
+static void stream_sync(void) {
+    taskENTER_CRITICAL(&s_stream_lock);
+    const int want = s_stream_want;
+    const bool change = (want != s_stream.sock);
+    const uint32_t timeout_ms = s_stream_want_timeout_ms;
+    const neopixel_anim_mode_t prev_mode = s_stream_want_prev_mode;
+    taskEXIT_CRITICAL(&s_stream_lock);
+    if (!change) return;
+
+    stream_close();
+    if (want < 0) return;
+    size_t bytes = (size_t)s_strip->count * s_strip->fmt->bpp;
+    s_stream.prev_frame = (uint8_t *)pvPortMalloc(bytes);   // once per stream, not per packet
+    if (s_stream.prev_frame) memcpy(s_stream.prev_frame, s_strip->pixels, bytes);
+    s_stream.timeout_ms = timeout_ms;
+    s_stream.last_rx = xTaskGetTickCount();
+    s_stream.last_seq = 0;
+    s_stream.push_seen = false;
+    s_stream.prev_mode = prev_mode;
+    s_stream.sock = want;
+}
+
+/* Stream went quiet: hand the strip back to whatever was there before */
+static void stream_fall_back(void) {
+    taskENTER_CRITICAL(&s_stream_lock);
+    const bool queued = (s_stream_want != s_stream.sock);   // a new stream replaces this one
+    if (!queued) s_stream_want = -1;
+    taskEXIT_CRITICAL(&s_stream_lock);
+    s_stream_stats.timeouts++;
+    if (queued) {
+        stream_close();
+        return;
+    }
+    ESP_LOGI(TAG, "Stream timed out (%u frames, %u lost), resuming previous mode",
+             (unsigned)s_stream_stats.frames, (unsigned)s_stream_stats.lost);
+    neopixel_anim_mode_t prev = s_stream.prev_mode;
+    if (prev == NEOPIXEL_ANIM_NONE || prev == NEOPIXEL_ANIM_FADE_TO_SOLID ||
+        prev == NEOPIXEL_ANIM_STREAM) {
+        if (s_stream.prev_frame) {
+            memcpy(s_strip->pixels, s_stream.prev_frame,
+                   (size_t)s_strip->count * s_strip->fmt->bpp);
+            neopixel_show(s_strip);
+        }
+        prev = NEOPIXEL_ANIM_NONE;
+    }
+    stream_close();
+    s_mode = prev;
+}
+
+/* Render task, before every slice: take over a clip staged by clip_start */
+static void clip_sync(void) {
+    taskENTER_CRITICAL(&s_clip_lock);
+    if (s_clip_pending) {
+        s_clip = s_clip_next;
+        s_clip_pending = false;
+    }
+    taskEXIT_CRITICAL(&s_clip_lock);
+}
+
+/* Clip finished: stop, unless another clip was staged meanwhile */
+static void clip_end(void) {
+    taskENTER_CRITICAL(&s_clip_lock);
+    const bool queued = s_clip_pending;
+    taskEXIT_CRITICAL(&s_clip_lock);
+    if (queued) return;
+    ESP_LOGI(TAG, "Clip '%s' ended after %u frames", s_clip.info.name, (unsigned)s_clip.frame);
+    s_mode = NEOPIXEL_ANIM_NONE;
+}
+
+/* One receive slice of the stream mode (runs in the render task) */
+static void stream_step(void) {
+    if (s_stream.sock < 0) {    // released by a mode change racing this slice
+        vTaskDelay(1);
+        return;
+    }
+    struct sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+    int n = recvfrom(s_stream.sock, s_stream_pkt, sizeof(s_stream_pkt), 0,
+                     (struct sockaddr *)&from, &from_len);
+    if (n <= 0) {
+        if ((xTaskGetTickCount() - s_stream.last_rx) >= pdMS_TO_TICKS(s_stream.timeout_ms)) {
+            stream_fall_back();
+        }
+        return;
+    }
+    s_stream.last_rx = xTaskGetTickCount();
+    s_stream_stats.packets++;
+
+    ddp_packet_t p;
+    if (!ddp_parse(s_stream_pkt, (size_t)n, &p) || (p.flags & DDP_FLAG_REPLY)) {
+        s_stream_stats.bad++;
+        return;
+    }
+    int gap = ddp_seq_gap(s_stream.last_seq, p.seq);
+    if (gap < 0) {
+        s_stream_stats.duplicates++;
+        return;
+    }
+    s_stream_stats.lost += (uint32_t)gap;
+    if (p.seq) s_stream.last_seq = p.seq;
+
+    if (p.len && ddp_copy_pixels(s_strip->pixels, s_strip->count, s_strip->fmt, &p) == 0) {
+        s_stream_stats.bad++;
+    }
+    if (p.flags & DDP_FLAG_PUSH) s_stream.push_seen = true;
+    if ((p.flags & DDP_FLAG_PUSH) || !s_stream.push_seen) {
+        neopixel_show(s_strip);
+        s_stream_stats.frames++;
+    }
+    if (p.flags & DDP_FLAG_QUERY) {
+        uint8_t reply[DDP_HEADER_LEN];
+        ddp_build_reply(reply, &p);
+        sendto(s_stream.sock, reply, sizeof(reply), 0, (struct sockaddr *)&from, from_len);
+    }
+}
+
 static void anim_task(void *arg) {
     uint32_t t = 0;
-    const TickType_t tick_20ms = pdMS_TO_TICKS(20);
+    TickType_t last_wake = 0;
     while (1) {
+        stream_sync();
+        clip_sync();
         switch (s_mode) {
             case NEOPIXEL_ANIM_BREATH: {
                 float phase = (float)((t % 2000) / 2000.0);
                 float inten = 0.5 * (1.0 + sin(phase * 2.0 * 3.1415926535));
                 uint8_t br = (uint8_t)(inten * 120.0);
-                for (int i=0;i<s_strip->count;i++) {
-                    neopixel_set_pixel(s_strip,i,
-                        (uint8_t)((s_r*br)/255),(uint8_t)((s_g*br)/255),(uint8_t)((s_b*br)/255),0);
-                }
+                neopixel_fill(s_strip,
+                    (uint8_t)((s_r*br)/255),(uint8_t)((s_g*br)/255),(uint8_t)((s_b*br)/255),0);
                 neopixel_show(s_strip);
-                vTaskDelay(tick_20ms);
+                pace_frame(&last_wake, FRAME_PERIOD_MS);
                 t += 20;
                 break;
             }
             case NEOPIXEL_ANIM_PULSE: {
-                for (int i=0;i<s_strip->count;i++) neopixel_set_pixel(s_strip,i,s_r,s_g,s_b,0);
+                s_paced = false;
+                neopixel_fill(s_strip,s_r,s_g,s_b,0);
                 neopixel_show(s_strip);
                 vTaskDelay(pdMS_TO_TICKS(500));
-                for (int i=0;i<s_strip->count;i++) neopixel_set_pixel(s_strip,i,0,0,0,0);
+                neopixel_fill(s_strip,0,0,0,0);
                 neopixel_show(s_strip);
                 vTaskDelay(pdMS_TO_TICKS(500));
                 t += 1000;
@@ -95,44 +340,24 @@ static void anim_task(void *arg) {
                 uint8_t r = (uint8_t)((t/10) % 255);
                 uint8_t g = (uint8_t)(((t/10) + 64) % 255);
                 uint8_t b = (uint8_t)(((t/10) + 128) % 255);
-                for (int i=0;i<s_strip->count;i++) {
-                    neopixel_set_pixel(s_strip,i,r,g,b,0);
-                }
+                neopixel_fill(s_strip,r,g,b,0);
                 neopixel_show(s_strip);
-                vTaskDelay(pdMS_TO_TICKS(20));
+                pace_frame(&last_wake, FRAME_PERIOD_MS);
                 t += 15;
                 break;
             }
             case NEOPIXEL_ANIM_FADE_TO_SOLID: {
                 // step ~20ms
-                vTaskDelay(tick_20ms);
+                pace_frame(&last_wake, FRAME_PERIOD_MS);
                 s_fade_elapsed_ms += 20;
                 float u = (s_fade_duration_ms == 0) ? 1.0f :
                           (float)s_fade_elapsed_ms / (float)s_fade_duration_ms;
                 if (u > 1.0f) u = 1.0f;
 
-                int bpp = s_strip->use_rgbw ? 4 : 3;
-                for (int i=0;i<s_strip->count;i++) {
-                    uint8_t sr = 0, sg = 0, sb = 0, sw = 0;
-                    if (s_fade_start) {
-                        uint8_t *sp = &s_fade_start[i*bpp];
-                        sg = sp[0]; sr = sp[1]; sb = sp[2];
-                        if (s_strip->use_rgbw) sw = sp[3];
-                    } else {
-                        // no snapshot → assume start = current buffer values
-                        uint8_t *sp = &s_strip->pixels[i*bpp];
-                        sg = sp[0]; sr = sp[1]; sb = sp[2];
-                        if (s_strip->use_rgbw) sw = sp[3];
-                    }
-                    // Lerp per channel: start + (target - start) * u
-                    uint8_t nr = (uint8_t)(sr + (int)((int)s_target_r - (int)sr) * u);
-                    uint8_t ng = (uint8_t)(sg + (int)((int)s_target_g - (int)sg) * u);
-                    uint8_t nb = (uint8_t)(sb + (int)((int)s_target_b - (int)sb) * u);
-                    uint8_t nw = s_strip->use_rgbw
-                                 ? (uint8_t)(sw + (int)((int)s_target_w - (int)sw) * u)
-                                 : 0;
-                    neopixel_set_pixel(s_strip, i, nr, ng, nb, nw);
-                }
+                // No snapshot: fade from the current buffer in place
+                const uint8_t target[4] = { s_target_r, s_target_g, s_target_b, s_target_w };
+                anim_fade_frame(s_strip->pixels, s_fade_start ? s_fade_start : s_strip->pixels,
+                                s_strip->fmt, s_strip->count, target, u);
                 neopixel_show(s_strip);
 
                 if (u >= 1.0f) {
@@ -148,58 +373,212 @@ static void anim_task(void *arg) {
                 float u = (s_rainbow_speed_ms == 0) ? 0.0f : ((t % s_rainbow_speed_ms) / (float)s_rainbow_speed_ms);
                 float base_h = u * 360.0f;  // degrees
 
-                if (s_rainbow_gradient && s_strip->count > 1) {
-                    for (int i = 0; i < s_strip->count; i++) {
-                        float h = base_h + (360.0f * ((float)i / (float)s_strip->count));
-                        if (h >= 360.0f) h -= 360.0f;
-                        uint8_t rr, gg, bb;
-                        hsv_to_rgb(h, s_rainbow_sat, s_rainbow_val, &rr, &gg, &bb);
-                        neopixel_set_pixel(s_strip, i, rr, gg, bb, 0);
-                    }
+                anim_rainbow_frame(s_strip->pixels, s_strip->fmt, s_geo, s_strip->count, base_h,
+                                   s_rainbow_gradient, s_rainbow_sat, s_rainbow_val);
+                neopixel_show(s_strip);
+                pace_frame(&last_wake, FRAME_PERIOD_MS);
+                t += 20;
+                break;
+            }
+
+            case NEOPIXEL_ANIM_SWEEP: {
+                // Head at angle -phase, tail fading out behind it over one turn
+                const uint8_t head[4] = { s_r, s_g, s_b, 0 }, tail[4] = { 0, 0, 0, 0 };
+                const uint16_t phase = (uint16_t)(((t % SWEEP_PERIOD_MS) << 16) / SWEEP_PERIOD_MS);
+                const anim_geometry_t *geo = geometry();
+                if (geo) {
+                    anim_gradient_frame(s_strip->pixels, s_strip->fmt, geo, ANIM_AXIS_ANGLE,
+                                        (uint16_t)-phase, head, tail);
                 } else {
-                    uint8_t rr, gg, bb;
-                    hsv_to_rgb(base_h, s_rainbow_sat, s_rainbow_val, &rr, &gg, &bb);
-                    for (int i = 0; i < s_strip->count; i++) {
-                        neopixel_set_pixel(s_strip, i, rr, gg, bb, 0);
-                    }
+                    neopixel_fill(s_strip, s_r, s_g, s_b, 0);
                 }
-
                 neopixel_show(s_strip);
-                vTaskDelay(tick_20ms);
+                pace_frame(&last_wake, FRAME_PERIOD_MS);
                 t += 20;
                 break;
             }
 
+            case NEOPIXEL_ANIM_STREAM: {
+                s_paced = false;    // paced by the sender
+                // Paced by the sender; recv blocks for at most one slice
+                stream_step();
+                break;
+            }
+
+            case NEOPIXEL_ANIM_CLIP: {
+                if (!anim_clip_next(&s_clip, s_strip->pixels, s_strip->fmt, s_strip->count)) {
+                    if ((s_clip.info.flags & ANIM_CLIP_FLAG_LOOP) && s_clip.frame > 0) {
+                        anim_clip_rewind(&s_clip);
+                    } else {
+                        clip_end();     // finished (or corrupt): hold the last frame
+                    }
+                    break;
+                }
+                neopixel_show(s_strip);
+                pace_frame(&last_wake, s_clip.info.frame_ms);
+                break;
+            }
+
             default: {
-                vTaskDelay(pdMS_TO_TICKS(100));
+                s_paced = false;
+                if (s_strip && neopixel_brightness_settling()) {
+                    // No animation, but the cap is still slewing: resend the
+                    // static frame at a low rate until it lands
+                    neopixel_show(s_strip);
+                    vTaskDelay(pdMS_TO_TICKS(CAP_REFRESH_MS));
+                    break;
+                }
+                // Idle: drop the PM lock and block until a new mode is started
+                // (or the cap changes), so the CPU can light-sleep between animations.
+                render_pm_hold(false);
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                render_pm_hold(true);
                 break;
             }
         }
     }
 }
 
+/* Target cap changed (any task): wake the idle render loop to refresh */
+static void cap_changed(void *arg) {
+    if (s_task) xTaskNotifyGive(s_task);
+}
+
+/* Create the render task on first use, otherwise wake it from idle */
+static void ensure_task(void) {
+    if (!s_task) {
+        neopixel_set_cap_hook(cap_changed, NULL);
+        render_pm_hold(true);
+        s_paced = false;
+        // Pinned so the RMT driver (installed from this task) takes its ISR on the same core
+        xTaskCreatePinnedToCore(anim_task, "anim_task", 4096, NULL,
+                                CONFIG_NEOPIXEL_RENDER_TASK_PRIORITY, &s_task, RENDER_TASK_CORE);
+    } else {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+bool neopixel_animations_stream_start(neopixel_t *strip, uint16_t port, uint32_t timeout_ms) {
+    s_strip = strip;
+    if (s_mode == NEOPIXEL_ANIM_STREAM && s_stream_want >= 0) return true;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) return false;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    struct timeval tv = { .tv_sec = 0, .tv_usec = STREAM_RECV_SLICE_MS * 1000 };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0) {
+        ESP_LOGE(TAG, "Stream socket setup failed on port %u", port);
+        close(sock);
+        return false;
+    }
+
+    int stale = stream_want(sock, timeout_ms, s_mode);   // render task swaps it in
+    if (stale >= 0) close(stale);
+    free_fade_buf();
+    s_mode = NEOPIXEL_ANIM_STREAM;
+    ESP_LOGI(TAG, "Listening for DDP on UDP %u", port);
+    ensure_task();
+    return true;
+}
+
+static bool clips_map(void) {
+    if (s_clip_image) return true;
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           CONFIG_NEOPIXEL_CLIP_PARTITION);
+    if (!part) {
+        ESP_LOGW(TAG, "No '%s' partition", CONFIG_NEOPIXEL_CLIP_PARTITION);
+        return false;
+    }
+    const void *ptr;
+    esp_partition_mmap_handle_t handle;
+    if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Mapping '%s' failed", CONFIG_NEOPIXEL_CLIP_PARTITION);
+        return false;
+    }
+    s_clip_image = (const uint8_t *)ptr;
+    s_clip_image_len = part->size;
+    return true;
+}
+
+bool neopixel_animations_clip_start(neopixel_t *strip, const char *name) {
+    anim_clip_t clip;
+    if (!clips_map()) return false;
+    if (!anim_clip_find(s_clip_image, s_clip_image_len, name, &clip)) {
+        ESP_LOGW(TAG, "Clip '%s' not found", name);
+        return false;
+    }
+    if (clip.info.leds != strip->count) {
+        ESP_LOGW(TAG, "Clip '%s' has %u LEDs, strip %d", name, clip.info.leds, strip->count);
+    }
+    s_strip = strip;
+    stream_release();
+    free_fade_buf();
+    taskENTER_CRITICAL(&s_clip_lock);     // the render task adopts it in clip_sync()
+    s_clip_next = clip;
+    s_clip_pending = true;
+    taskEXIT_CRITICAL(&s_clip_lock);
+    s_mode = NEOPIXEL_ANIM_CLIP;
+    ESP_LOGI(TAG, "Playing clip '%s': %u frames at %u ms", name,
+             (unsigned)clip.info.frames, clip.info.frame_ms);
+    ensure_task();
+    return true;
+}
+
+void neopixel_animations_set_geometry(const anim_geometry_t *geo) {
+    s_geo = geo;
+}
+
+void neopixel_animations_get_stream_stats(neopixel_stream_stats_t *out) {
+    *out = s_stream_stats;
+}
+
+void neopixel_animations_get_jitter(neopixel_jitter_stats_t *out) {
+    *out = s_jitter;
+}
+
 void neopixel_animations_start(neopixel_t *strip, neopixel_anim_mode_t mode,
                                uint8_t r, uint8_t g, uint8_t b) {
+    if (mode == NEOPIXEL_ANIM_STREAM) {
+        neopixel_animations_stream_start(strip, CONFIG_NEOPIXEL_STREAM_PORT,
+                                         CONFIG_NEOPIXEL_STREAM_TIMEOUT_MS);
+        return;
+    }
+    if (mode == NEOPIXEL_ANIM_CLIP) {
+        neopixel_animations_clip_start(strip, CONFIG_NEOPIXEL_CLIP_DEFAULT);
+        return;
+    }
+    stream_release();
     s_strip = strip; s_mode = mode; s_r = r; s_g = g; s_b = b;
     // cancel any pending fade buffer if switching modes
     free_fade_buf();
-    if (!s_task) xTaskCreate(anim_task,"anim_task",4096,NULL,5,&s_task);
+    ensure_task();
 }
 
 void neopixel_animations_stop(neopixel_t *strip) {
     (void)strip;
     if (s_task) { vTaskDelete(s_task); s_task = NULL; }
     s_mode = NEOPIXEL_ANIM_NONE;
+    render_pm_hold(false);
     free_fade_buf();
+    // The render task is gone: close what it had and anything still queued for it
+    stream_release();
+    stream_close();
 }
 
 void neopixel_animations_fade_to(neopixel_t *strip,
                                  uint8_t r, uint8_t g, uint8_t b, uint8_t w,
                                  uint32_t duration_ms) {
     s_strip = strip;
-    if (!s_task) xTaskCreate(anim_task,"anim_task",4096,NULL,5,&s_task);
+    stream_release();
     begin_fade_snapshot(r, g, b, w, duration_ms);
     s_mode = NEOPIXEL_ANIM_FADE_TO_SOLID;
+    ensure_task();
 }
 
 void neopixel_animations_rainbow_smooth_start(neopixel_t *strip,
@@ -208,10 +587,15 @@ void neopixel_animations_rainbow_smooth_start(neopixel_t *strip,
                                               uint8_t saturation,
                                               uint8_t value) {
     s_strip = strip;
-    if (!s_task) xTaskCreate(anim_task, "anim_task", 4096, NULL, 5, &s_task);
+    stream_release();
     s_rainbow_speed_ms = (speed_ms_per_cycle == 0) ? 6000 : speed_ms_per_cycle;
     s_rainbow_gradient = gradient;
     s_rainbow_sat = saturation;
     s_rainbow_val = value;
     s_mode = NEOPIXEL_ANIM_RAINBOW_SMOOTH;
+    ensure_task();
+}
+
+bool neopixel_animations_is_active(void) {
+    return s_mode != NEOPIXEL_ANIM_NONE;
 }
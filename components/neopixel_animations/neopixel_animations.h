@@ -1,6 +1,7 @@
 
 #pragma once
 #include "neopixel_driver.h"
+#include "anim_geometry.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -10,9 +11,32 @@ typedef enum {
     NEOPIXEL_ANIM_PULSE,
     NEOPIXEL_ANIM_RAINBOW,
     NEOPIXEL_ANIM_FADE_TO_SOLID,
-    NEOPIXEL_ANIM_RAINBOW_SMOOTH
+    NEOPIXEL_ANIM_RAINBOW_SMOOTH,
+    NEOPIXEL_ANIM_STREAM,           // frames received over UDP (DDP)
+    NEOPIXEL_ANIM_CLIP,             // precomputed frames from the clips partition
+    NEOPIXEL_ANIM_SWEEP             // the color swept around the layout with a fading tail
 } neopixel_anim_mode_t;
 
+typedef struct {
+    uint32_t packets;
+    uint32_t frames;        // frames shown (PUSH packets, or every packet if the sender never pushes)
+    uint32_t lost;          // gaps in the DDP sequence numbers
+    uint32_t duplicates;
+    uint32_t bad;           // not DDP / not pixel aligned
+    uint32_t timeouts;      // streams that ended by going quiet
+} neopixel_stream_stats_t;
+
+/* Frame pacing of the fixed-rate modes (breath, rainbow, fade, clips):
+ * deviation of each wake-up interval from the frame period, since boot */
+#define NEOPIXEL_JITTER_BUCKETS 5   // < 250 us, < 1 ms, < 2 ms, < 5 ms, >= 5 ms
+
+typedef struct {
+    uint32_t frames;
+    uint32_t max_us;
+    uint64_t sum_us;        // mean = sum_us / frames
+    uint32_t hist[NEOPIXEL_JITTER_BUCKETS];
+} neopixel_jitter_stats_t;
+
 void neopixel_animations_start(neopixel_t *strip, neopixel_anim_mode_t mode,
                                uint8_t r, uint8_t g, uint8_t b);
 void neopixel_animations_stop(neopixel_t *strip);
@@ -24,3 +48,33 @@ void neopixel_animations_rainbow_smooth_start(neopixel_t *strip,
                                               bool gradient,
                                               uint8_t saturation,
                                               uint8_t value);
+/**
+ * Realtime stream mode: listen for DDP packets on a UDP port and copy their
+ * pixels straight into the strip's frame buffer. When no packet arrives for
+ * timeout_ms the previous animation resumes (or the previous frame is
+ * restored if nothing was animating). neopixel_animations_start() with
+ * NEOPIXEL_ANIM_STREAM uses the Kconfig port/timeout.
+ * Packets with the QUERY flag are answered with a REPLY header once their
+ * frame is on the wire, so a sender can measure end-to-end latency.
+ */
+bool neopixel_animations_stream_start(neopixel_t *strip, uint16_t port, uint32_t timeout_ms);
+/**
+ * Play a precomputed clip (anim_clip.h) by name from the clips partition,
+ * decoding each frame straight from mapped flash into the strip buffer at
+ * the clip's frame rate. Looping clips run until another mode starts; others
+ * hold their last frame. neopixel_animations_start() with NEOPIXEL_ANIM_CLIP
+ * plays the Kconfig default clip.
+ * @return false if the partition or the clip is missing (nothing changes)
+ */
+bool neopixel_animations_clip_start(neopixel_t *strip, const char *name);
+/**
+ * Physical layout used by the rainbow gradient and the sweep (kept by
+ * pointer; NULL or a table for another LED count = a straight strip).
+ * Set it before starting animations.
+ */
+void neopixel_animations_set_geometry(const anim_geometry_t *geo);
+void neopixel_animations_get_stream_stats(neopixel_stream_stats_t *out);
+void neopixel_animations_get_jitter(neopixel_jitter_stats_t *out);
+
+/** True while an animation or fade is rendering frames */
+bool neopixel_animations_is_active(void);
@@ -0,0 +1,55 @@
+#include "neopixel_apa102.h"
+#include <string.h>
+
+#define APA102_START_LEN    4
+#define APA102_LED_LEN      4
+#define APA102_GLOBAL_MAX   31
+#define APA102_LED_MARKER   0xE0
+
+/* Half a clock per LED pushes the data through the chain; SK9822 also wants
+ * a 32-bit frame to latch */
+static size_t end_len(int count) {
+    return 4 + ((size_t)count + 15) / 16;
+}
+
+size_t apa102_frame_len(int count) {
+    if (count < 0) count = 0;
+    return APA102_START_LEN + (size_t)count * APA102_LED_LEN + end_len(count);
+}
+
+/* v * cap / 255 expressed against global / 31 instead of 1, as a 16.16
+ * factor per global value so the per-channel work is a multiply */
+static inline uint8_t scale_channel(uint8_t v, uint32_t factor) {
+    const uint32_t out = ((uint32_t)v * factor + 0x8000) >> 16;
+    return out > 255 ? 255 : (uint8_t)out;
+}
+
+size_t apa102_encode(uint8_t *out, size_t len, const uint8_t *pixels, int count,
+                     const neopixel_format_t *fmt, uint8_t cap) {
+    const size_t need = apa102_frame_len(count);
+    if (!out || !pixels || !fmt || len < need) return 0;
+
+    uint32_t factor[APA102_GLOBAL_MAX + 1];
+    for (uint32_t g = 1; g <= APA102_GLOBAL_MAX; g++) {
+        const uint32_t den = 255U * g;
+        factor[g] = (((uint32_t)cap * APA102_GLOBAL_MAX << 16) + den / 2) / den;
+    }
+
+    memset(out, 0, APA102_START_LEN);
+    uint8_t *o = out + APA102_START_LEN;
+    const uint8_t *p = pixels;
+    for (int i = 0; i < count; i++, p += fmt->bpp, o += APA102_LED_LEN) {
+        const uint8_t r = p[fmt->r], g = p[fmt->g], b = p[fmt->b];
+        uint8_t max = r > g ? r : g;
+        if (b > max) max = b;
+        // Smallest global with max * cap / 255 <= 255 * global / 31
+        uint32_t global = ((uint32_t)max * cap * APA102_GLOBAL_MAX + 255U * 255U - 1) / (255U * 255U);
+        if (global == 0) global = 1;
+        o[0] = (uint8_t)(APA102_LED_MARKER | global);
+        o[1] = scale_channel(b, factor[global]);
+        o[2] = scale_channel(g, factor[global]);
+        o[3] = scale_channel(r, factor[global]);
+    }
+    memset(o, 0, end_len(count));
+    return need;
+}
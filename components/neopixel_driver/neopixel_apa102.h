@@ -0,0 +1,37 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "neopixel_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * APA102 / SK9822 frame encoding. Pure C (no IDF dependencies) so frames can
+ * be checked on the host.
+ *
+ * Wire format: a 32-bit zero start frame, then per LED 0xE0 | global (5 bits)
+ * followed by B, G, R, then a zero end frame long enough to clock the data
+ * through the whole chain (SK9822 latches on it too).
+ *
+ * The brightness cap is folded into each LED's 5-bit global field rather than
+ * the 8-bit channels: the smallest global that still fits the LED's brightest
+ * channel is used and the channels are scaled up to match, so dim pixels keep
+ * close to 8 bits of color resolution instead of cap/255 of it.
+ */
+
+/** Bytes in one frame for count LEDs */
+size_t apa102_frame_len(int count);
+
+/**
+ * Encode count pixels (laid out as fmt; W is ignored) into out.
+ * @param cap brightness cap 0..255
+ * @return bytes written, 0 if out is shorter than apa102_frame_len(count)
+ */
+size_t apa102_encode(uint8_t *out, size_t len, const uint8_t *pixels, int count,
+                     const neopixel_format_t *fmt, uint8_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,7 +1,13 @@
 
 #include "neopixel_driver.h"
+#include "neopixel_apa102.h"
 #include "driver/rmt.h"
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "trace.h"
+#include "sdkconfig.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -36,19 +42,48 @@ static inline rmt_item32_t bit1_item(void) {
 
 typedef struct {
     rmt_channel_t channel;
+    rmt_config_t cfg;
+    bool installed;
+    bool low_power;        // release the RMT driver (and its APB PM lock) between frames
     rmt_item32_t *items;
     size_t items_len;
 } neopixel_rmt_t;
 
+#define NEOPIXEL_SPI_HOST   SPI2_HOST
+
+typedef struct {
+    spi_bus_config_t bus;
+    spi_device_interface_config_t dev_cfg;
+    spi_device_handle_t dev;
+    bool installed;
+    uint8_t *buf;          // DMA-capable, one whole frame
+    size_t buf_len;
+} neopixel_spi_t;
+
 static neopixel_rmt_t s_rmt = {0};
+static neopixel_spi_t s_spi = {0};
+static neopixel_driver_stats_t s_stats = {0};
 
-void neopixel_init(neopixel_t *strip, int pin, int count, neopixel_order_t order) {
+/* Fields and frame buffer shared by both strip types */
+static void init_strip(neopixel_t *strip, neopixel_type_t type, int pin, int count,
+                       neopixel_order_t order) {
+    strip->type = type;
     strip->pin = pin;
+    strip->clk_pin = -1;
     strip->count = count;
+    strip->fmt = neopixel_format(order);
+    if (!strip->fmt) {
+        ESP_LOGW(TAG, "Unknown pixel order %d, using GRB", (int)order);
+        order = NEOPIXEL_ORDER_GRB;
+        strip->fmt = neopixel_format(order);
+    }
     strip->order = order;
-    strip->use_rgbw = (order == NEOPIXEL_ORDER_GRBW);
-    int bpp = strip->use_rgbw ? 4 : 3;
-    strip->pixels = (uint8_t*)calloc(count, bpp);
+    strip->use_rgbw = (strip->fmt->bpp == 4);
+    strip->pixels = (uint8_t*)calloc(count, strip->fmt->bpp);
+}
+
+void neopixel_init(neopixel_t *strip, int pin, int count, neopixel_order_t order) {
+    init_strip(strip, NEOPIXEL_TYPE_WS2812, pin, count, order);
 
     // Configure RMT
     s_rmt.channel = RMT_CHANNEL_0;
@@ -65,76 +100,189 @@ void neopixel_init(neopixel_t *strip, int pin, int count, neopixel_order_t order
             .idle_level = RMT_IDLE_LEVEL_LOW
         }
     };
+    s_rmt.cfg = cfg;
     rmt_config(&cfg);
-    rmt_driver_install(s_rmt.channel, 0, 0);
+    // The driver is installed by the first neopixel_show(): its interrupt is
+    // allocated on the calling core, which should be the render task's
+    s_rmt.installed = false;
 
-    ESP_LOGI(TAG, "Init on GPIO %d, LEDs=%d, %s", pin, count, strip->use_rgbw ? "RGBW" : "RGB");
+    ESP_LOGI(TAG, "Init on GPIO %d, LEDs=%d, %s", pin, count, neopixel_order_name(strip->order));
 }
 
-static uint8_t s_brightness_cap = 255; // default off
+void neopixel_init_apa102(neopixel_t *strip, int data_pin, int clk_pin, int count,
+                          neopixel_order_t order, uint32_t clock_hz) {
+    if (order == NEOPIXEL_ORDER_GRBW) order = NEOPIXEL_ORDER_GRB;   // no white channel
+    if (order == NEOPIXEL_ORDER_RGBW) order = NEOPIXEL_ORDER_RGB;
+    init_strip(strip, NEOPIXEL_TYPE_APA102, data_pin, count, order);
+    strip->clk_pin = clk_pin;
+
+    s_spi.buf_len = apa102_frame_len(count);
+    s_spi.buf = (uint8_t *)heap_caps_malloc(s_spi.buf_len, MALLOC_CAP_DMA);
+    if (!s_spi.buf) {
+        ESP_LOGE(TAG, "No DMA memory for a %u byte frame", (unsigned)s_spi.buf_len);
+        s_spi.buf_len = 0;
+    }
+    spi_bus_config_t bus = {
+        .mosi_io_num = data_pin,
+        .miso_io_num = -1,
+        .sclk_io_num = clk_pin,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = (int)apa102_frame_len(count),
+    };
+    spi_device_interface_config_t dev_cfg = {
+        .clock_speed_hz = (int)clock_hz,
+        .mode = 0,                  // data sampled on the rising clock edge
+        .spics_io_num = -1,         // no chip select: the strip listens to everything
+        .queue_size = 1,
+    };
+    s_spi.bus = bus;
+    s_spi.dev_cfg = dev_cfg;
+    // Installed by the first neopixel_show(), like RMT, so the SPI interrupt
+    // lands on the render task's core
+    s_spi.installed = false;
+
+    ESP_LOGI(TAG, "Init APA102 on GPIO %d (clock %d, %u kHz), LEDs=%d, %s", data_pin, clk_pin,
+             (unsigned)(clock_hz / 1000), count, neopixel_order_name(strip->order));
+}
+
+/* Brightness cap: callers set a target; each transmitted frame moves the
+ * applied cap toward it at s_cap_slew units/s, so changes ride the normal
+ * frame cadence instead of jumping (or forcing an extra transmit). */
+static uint8_t s_brightness_cap = 255;          // applied to the frame being sent
+static volatile uint8_t s_cap_target = 255;
+static int32_t s_cap_q8 = 255 << 8;             // slewing value, 8 fractional bits
+static uint16_t s_cap_slew = CONFIG_NEOPIXEL_CAP_SLEW_PER_S;   // 0 = instant
+static int64_t s_cap_t_us = 0;                  // when s_cap_q8 was last advanced
+static neopixel_cap_hook_t s_cap_hook = NULL;
+static void *s_cap_hook_arg = NULL;
+
 static inline uint8_t apply_cap(uint8_t v) {
     // v * cap / 255
     return (uint8_t)((v * (uint16_t)s_brightness_cap) / 255U);
 }
-void neopixel_set_brightness_cap(uint8_t cap) { s_brightness_cap = cap; }
-uint8_t neopixel_get_brightness_cap(void) { return s_brightness_cap; }
 
+static uint8_t cap_for_frame(void) {
+    const int64_t now = esp_timer_get_time();
+    const int32_t target = (int32_t)s_cap_target << 8;
+    if (s_cap_slew == 0) {
+        s_cap_q8 = target;
+    } else if (s_cap_q8 != target) {
+        int64_t step = (int64_t)s_cap_slew * 256 * (now - s_cap_t_us) / 1000000;
+        if (s_cap_q8 < target) s_cap_q8 = (s_cap_q8 + step >= target) ? target : (int32_t)(s_cap_q8 + step);
+        else                   s_cap_q8 = (s_cap_q8 - step <= target) ? target : (int32_t)(s_cap_q8 - step);
+    }
+    s_cap_t_us = now;
+    return (uint8_t)((s_cap_q8 + 128) >> 8);
+}
+
+void neopixel_set_brightness_cap(uint8_t cap) {
+    if (cap == s_cap_target) return;
+    // Settled until now: start the ramp from this moment, not from the last frame
+    if (!neopixel_brightness_settling()) s_cap_t_us = esp_timer_get_time();
+    s_cap_target = cap;
+    if (s_cap_hook) s_cap_hook(s_cap_hook_arg);
+}
+uint8_t neopixel_get_brightness_cap(void) { return s_cap_target; }
+uint8_t neopixel_get_applied_brightness_cap(void) { return s_brightness_cap; }
+void neopixel_set_brightness_slew(uint16_t units_per_s) { s_cap_slew = units_per_s; }
+
+bool neopixel_brightness_settling(void) {
+    return s_cap_q8 != ((int32_t)s_cap_target << 8);
+}
+
+void neopixel_set_cap_hook(neopixel_cap_hook_t hook, void *arg) {
+    s_cap_hook_arg = arg;
+    s_cap_hook = hook;
+}
+
+
+void neopixel_set_low_power(bool enable) {
+    s_rmt.low_power = enable;
+    if (enable && s_rmt.installed) {
+        // The installed RMT driver holds an APB_FREQ_MAX lock, which blocks light sleep
+        rmt_driver_uninstall(s_rmt.channel);
+        s_rmt.installed = false;
+    }
+}
 
 void neopixel_set_pixel(neopixel_t *strip, int i, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
     if (!strip || !strip->pixels) return;
     if (i < 0 || i >= strip->count) return;
-    int bpp = strip->use_rgbw ? 4 : 3;
-    uint8_t *p = &strip->pixels[i*bpp];
-    // Most strips expect GRB (and GRBW for SK6812)
-    p[0] = g;
-    p[1] = r;
-    p[2] = b;
-    if (strip->use_rgbw) p[3] = w;
+    strip->fmt->fill(&strip->pixels[i * strip->fmt->bpp], 1, r, g, b, w);
+}
+
+/* Clip [*start, *start + *n) to the strip; returns the pixels skipped at the
+ * front (source offset for blits), or -1 if nothing is left */
+static int clip_span(const neopixel_t *strip, int *start, int *n) {
+    if (!strip || !strip->pixels || *n <= 0) return -1;
+    int skip = 0;
+    if (*start < 0) {
+        skip = -*start;
+        *n -= skip;
+        *start = 0;
+    }
+    if (*n > strip->count - *start) *n = strip->count - *start;
+    return *n > 0 ? skip : -1;
+}
+
+void neopixel_fill_range(neopixel_t *strip, int start, int n,
+                         uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    if (clip_span(strip, &start, &n) < 0) return;
+    strip->fmt->fill(&strip->pixels[start * strip->fmt->bpp], n, r, g, b, w);
+}
+
+void neopixel_blit_rgb(neopixel_t *strip, int start, const uint8_t *rgb, int n) {
+    const int skip = rgb ? clip_span(strip, &start, &n) : -1;
+    if (skip < 0) return;
+    strip->fmt->blit_rgb(&strip->pixels[start * strip->fmt->bpp], rgb + skip * 3, n);
+}
+
+void neopixel_blit_rgbw(neopixel_t *strip, int start, const uint8_t *rgbw, int n) {
+    const int skip = rgbw ? clip_span(strip, &start, &n) : -1;
+    if (skip < 0) return;
+    strip->fmt->blit_rgbw(&strip->pixels[start * strip->fmt->bpp], rgbw + skip * 4, n);
 }
 
 void neopixel_fill(neopixel_t *strip, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
     if (!strip) return;
-    for (int i=0;i<strip->count;i++) neopixel_set_pixel(strip,i,r,g,b,w);
+    neopixel_fill_range(strip, 0, strip->count, r, g, b, w);
 }
 
 void neopixel_clear(neopixel_t *strip) {
     if (!strip || !strip->pixels) return;
-    memset(strip->pixels, 0, strip->count * (strip->use_rgbw ? 4 : 3));
+    memset(strip->pixels, 0, strip->count * strip->fmt->bpp);
     neopixel_show(strip);
 }
 
-void neopixel_show(neopixel_t *strip) {
-    if (!strip || !strip->pixels) return;
-    int bpp = strip->use_rgbw ? 4 : 3;
-    const size_t nbits = strip->count * bpp * 8;
+static size_t encode_spi(const neopixel_t *strip) {
+    return apa102_encode(s_spi.buf, s_spi.buf_len, strip->pixels, strip->count, strip->fmt,
+                         s_brightness_cap);
+}
+
+static size_t encode_rmt(const neopixel_t *strip) {
+    const size_t nbytes = (size_t)strip->count * strip->fmt->bpp;
+    const size_t nbits = nbytes * 8;
     // Allocate items: one rmt item per bit + reset tail
     size_t reset_items = 1;
     size_t total_items = nbits + reset_items;
     if (s_rmt.items_len < total_items || !s_rmt.items) {
         free(s_rmt.items);
         s_rmt.items = (rmt_item32_t*)calloc(total_items, sizeof(rmt_item32_t));
-        s_rmt.items_len = total_items;
+        s_rmt.items_len = s_rmt.items ? total_items : 0;
+        if (!s_rmt.items) return 0;
     }
 
     rmt_item32_t b0 = bit0_item();
     rmt_item32_t b1 = bit1_item();
 
     size_t k = 0;
-    for (int i = 0; i < strip->count; i++) {
-        uint8_t *p = &strip->pixels[i*bpp];
-        // GRB(W) order; apply cap
-        uint8_t g = apply_cap(p[0]);
-        uint8_t r = apply_cap(p[1]);
-        uint8_t b = apply_cap(p[2]);
-        uint8_t w = strip->use_rgbw ? apply_cap(p[3]) : 0;
-
-        uint8_t bytes[4] = { g, r, b, w };
-        for (int j = 0; j < bpp; j++) {
-            uint8_t byte = bytes[j];
-            for (int bit = 7; bit >= 0; bit--) {
-                bool one = (byte >> bit) & 0x01;
-                s_rmt.items[k++] = one ? b1 : b0;
-            }
+    // The buffer is already in wire order: every byte goes out as is, capped
+    for (size_t j = 0; j < nbytes; j++) {
+        uint8_t byte = apply_cap(strip->pixels[j]);
+        for (int bit = 7; bit >= 0; bit--) {
+            bool one = (byte >> bit) & 0x01;
+            s_rmt.items[k++] = one ? b1 : b0;
         }
     }
     // Reset pulse (low) for >50us
@@ -144,7 +292,76 @@ void neopixel_show(neopixel_t *strip) {
     reset.level1 = 0;
     reset.duration1 = 0;
     s_rmt.items[k++] = reset;
+    return k;
+}
 
-    rmt_write_items(s_rmt.channel, s_rmt.items, k, true);
+size_t neopixel_encode(const neopixel_t *strip) {
+    if (!strip || !strip->pixels) return 0;
+    return strip->type == NEOPIXEL_TYPE_APA102 ? encode_spi(strip) : encode_rmt(strip);
+}
+
+static bool transmit_rmt(size_t k) {
+    if (!s_rmt.installed) {
+        rmt_config(&s_rmt.cfg);
+        if (rmt_driver_install(s_rmt.channel, 0, 0) != ESP_OK) return false;
+        s_rmt.installed = true;
+    }
+    bool ok = rmt_write_items(s_rmt.channel, s_rmt.items, k, true) == ESP_OK;
     rmt_wait_tx_done(s_rmt.channel, portMAX_DELAY);
+    if (s_rmt.low_power) {
+        rmt_driver_uninstall(s_rmt.channel);
+        s_rmt.installed = false;
+    }
+    return ok;
+}
+
+static bool transmit_spi(size_t len) {
+    if (!s_spi.installed) {
+        if (spi_bus_initialize(NEOPIXEL_SPI_HOST, &s_spi.bus, SPI_DMA_CH_AUTO) != ESP_OK) {
+            return false;
+        }
+        if (spi_bus_add_device(NEOPIXEL_SPI_HOST, &s_spi.dev_cfg, &s_spi.dev) != ESP_OK) {
+            spi_bus_free(NEOPIXEL_SPI_HOST);
+            return false;
+        }
+        s_spi.installed = true;
+    }
+    spi_transaction_t t = {
+        .length = len * 8,          // bits
+        .tx_buffer = s_spi.buf,
+    };
+    return spi_device_transmit(s_spi.dev, &t) == ESP_OK;
+}
+
+#if CONFIG_TRACE_ENABLE
+/* FNV-1a over the frame and its cap: lets trace tools find the first frame
+ * that looks different after an input */
+static uint32_t frame_tag(const neopixel_t *strip) {
+    uint32_t h = (2166136261U ^ s_brightness_cap) * 16777619U;
+    const size_t n = (size_t)strip->count * strip->fmt->bpp;
+    for (size_t i = 0; i < n; i++) h = (h ^ strip->pixels[i]) * 16777619U;
+    return h;
+}
+#endif
+
+void neopixel_show(neopixel_t *strip) {
+    if (!strip || !strip->pixels) return;
+    const int64_t t0 = esp_timer_get_time();
+    s_brightness_cap = cap_for_frame();
+    TRACE_BEGIN("led_show", frame_tag(strip));
+    const size_t k = neopixel_encode(strip);
+    const bool ok = k != 0 &&
+                    (strip->type == NEOPIXEL_TYPE_APA102 ? transmit_spi(k) : transmit_rmt(k));
+    TRACE_END("led_show", ok);      // the frame is on the wire
+    if (!ok) {
+        s_stats.errors++;
+        return;
+    }
+    s_stats.frames++;
+    s_stats.last_show_us = (uint32_t)(esp_timer_get_time() - t0);
+    if (s_stats.last_show_us > s_stats.max_show_us) s_stats.max_show_us = s_stats.last_show_us;
+}
+
+void neopixel_get_stats(neopixel_driver_stats_t *out) {
+    if (out) *out = s_stats;
 }
@@ -2,32 +2,94 @@
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "neopixel_format.h"
 
 typedef enum {
-    NEOPIXEL_ORDER_GRB,   // WS2812(B)
-    NEOPIXEL_ORDER_GRBW   // SK6812 RGBW
-} neopixel_order_t;
+    NEOPIXEL_TYPE_WS2812,   // WS2812 / SK6812: one-wire, RMT
+    NEOPIXEL_TYPE_APA102    // APA102 / SK9822: data + clock, SPI DMA
+} neopixel_type_t;
 
 typedef struct {
-    int pin;
+    neopixel_type_t type;
+    int pin;             // data
+    int clk_pin;         // APA102 only, -1 otherwise
     int count;
-    uint8_t *pixels;     // raw bytes (3 or 4 per LED depending on order)
+    uint8_t *pixels;     // raw bytes in wire order (fmt->bpp per LED)
     neopixel_order_t order;
-    bool use_rgbw;
+    bool use_rgbw;       // fmt->bpp == 4
+    const neopixel_format_t *fmt;   // layout and span kernels for order
 } neopixel_t;
 
 /**
  * Initialize strip
- * @param order NEOPIXEL_ORDER_GRB or NEOPIXEL_ORDER_GRBW
+ * @param order channel order on the wire; unknown orders fall back to GRB
  */
 void neopixel_init(neopixel_t *strip, int pin, int count, neopixel_order_t order);
+/**
+ * Initialize an APA102/SK9822 strip on the SPI peripheral. order is the
+ * buffer layout the span API writes (the wire is always the chip's BGR);
+ * 4-byte orders fall back to their 3-byte counterpart. The brightness cap is
+ * applied through each LED's 5-bit global field, see neopixel_apa102.h.
+ * @param clock_hz SPI clock; both chips handle several MHz
+ */
+void neopixel_init_apa102(neopixel_t *strip, int data_pin, int clk_pin, int count,
+                          neopixel_order_t order, uint32_t clock_hz);
 // Set a global brightness cap (0..255). Applied at transmit time.
 // 255 = no cap; 128 = half; 0 = off
+// This sets a target: each neopixel_show() moves the applied cap toward it at
+// the slew rate, so nothing is transmitted by the call itself.
 void neopixel_set_brightness_cap(uint8_t cap);
+/** Target cap (last value set) */
 uint8_t neopixel_get_brightness_cap(void);
+/** Cap used for the most recent frame */
+uint8_t neopixel_get_applied_brightness_cap(void);
+/** Cap slew rate in cap units per second (0 = jump instantly) */
+void neopixel_set_brightness_slew(uint16_t units_per_s);
+/** True while the applied cap has not reached the target (frames still needed) */
+bool neopixel_brightness_settling(void);
+
+/** Called (from the setter's task) whenever the target cap changes; lets
+ *  the render loop wake up and refresh a static frame while the cap slews */
+typedef void (*neopixel_cap_hook_t)(void *arg);
+void neopixel_set_cap_hook(neopixel_cap_hook_t hook, void *arg);
 void neopixel_set_pixel(neopixel_t *strip, int i, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
 void neopixel_fill(neopixel_t *strip, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
-/** Transmit current buffer to the LEDs using RMT */
+/*
+ * Span writes: clipped to the strip once per call, then handed to the
+ * strip's order-specific kernel. Prefer these to per-pixel set_pixel loops.
+ */
+/** Pixels start..start+n-1 to one color */
+void neopixel_fill_range(neopixel_t *strip, int start, int n,
+                         uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+/** n pixels from r,g,b triplets, starting at pixel start (W cleared) */
+void neopixel_blit_rgb(neopixel_t *strip, int start, const uint8_t *rgb, int n);
+/** n pixels from r,g,b,w quads, starting at pixel start (W dropped on 3-byte strips) */
+void neopixel_blit_rgbw(neopixel_t *strip, int start, const uint8_t *rgbw, int n);
+/** Transmit current buffer to the LEDs (RMT or SPI, by strip type) */
 void neopixel_show(neopixel_t *strip);
+/**
+ * Encode the buffer (applied cap included) into the driver's RMT symbol or
+ * SPI byte buffer without transmitting; the first half of neopixel_show(),
+ * exposed for benchmarks. Must not run concurrently with neopixel_show().
+ * @return symbols (RMT) or bytes (SPI) encoded, 0 if the buffer could not be
+ *         allocated
+ */
+size_t neopixel_encode(const neopixel_t *strip);
+/**
+ * Low-power mode: release the RMT driver between frames so its PM lock does
+ * not keep the CPU out of light sleep. Meant for when no animation is running;
+ * each neopixel_show() then re-installs the driver for one transmit. SPI
+ * strips only hold the lock during a transfer, so this is a no-op for them.
+ */
+void neopixel_set_low_power(bool enable);
+typedef struct {
+    uint32_t frames;        // completed transmits
+    uint32_t errors;        // RMT/SPI install or transmit failures
+    uint32_t last_show_us;  // encode + transmit time of the latest frame
+    uint32_t max_show_us;
+} neopixel_driver_stats_t;
+
+void neopixel_get_stats(neopixel_driver_stats_t *out);
 /** Optional: set all to off and show */
 void neopixel_clear(neopixel_t *strip);
@@ -0,0 +1,59 @@
+#include "neopixel_format.h"
+#include <stddef.h>
+
+/* order, kernel suffix, name, bytes per pixel, offsets of R, G, B, W */
+#define NEOPIXEL_FORMATS(X)                                  \
+    X(NEOPIXEL_ORDER_GRB,  grb,  "GRB",  3, 1, 0, 2, 0)      \
+    X(NEOPIXEL_ORDER_GRBW, grbw, "GRBW", 4, 1, 0, 2, 3)      \
+    X(NEOPIXEL_ORDER_RGB,  rgb,  "RGB",  3, 0, 1, 2, 0)      \
+    X(NEOPIXEL_ORDER_BRG,  brg,  "BRG",  3, 1, 2, 0, 0)      \
+    X(NEOPIXEL_ORDER_RGBW, rgbw, "RGBW", 4, 0, 1, 2, 3)
+
+/* Each expansion produces one order's kernels; BPP and the channel offsets
+ * are constants, so the W handling folds away per order: 4-byte orders store
+ * W, 3-byte orders mix it into R, G and B so white still shows. */
+#define DEFINE_KERNELS(ORDER, NAME, STR, BPP, RI, GI, BI, WI)                             \
+    static void fill_##NAME(uint8_t *dst, int n, uint8_t r, uint8_t g, uint8_t b,        \
+                            uint8_t w) {                                                  \
+        for (int i = 0; i < n; i++, dst += BPP) {                                         \
+            dst[RI] = BPP == 4 ? r : neopixel_add_w(r, w);                                \
+            dst[GI] = BPP == 4 ? g : neopixel_add_w(g, w);                                \
+            dst[BI] = BPP == 4 ? b : neopixel_add_w(b, w);                                \
+            if (BPP == 4) dst[WI] = w;                                                    \
+        }                                                                                 \
+    }                                                                                     \
+    static void blit_rgb_##NAME(uint8_t *dst, const uint8_t *src, int n) {               \
+        for (int i = 0; i < n; i++, dst += BPP, src += 3) {                               \
+            dst[RI] = src[0];                                                             \
+            dst[GI] = src[1];                                                             \
+            dst[BI] = src[2];                                                             \
+            if (BPP == 4) dst[WI] = 0;                                                    \
+        }                                                                                 \
+    }                                                                                     \
+    static void blit_rgbw_##NAME(uint8_t *dst, const uint8_t *src, int n) {              \
+        for (int i = 0; i < n; i++, dst += BPP, src += 4) {                               \
+            dst[RI] = BPP == 4 ? src[0] : neopixel_add_w(src[0], src[3]);                 \
+            dst[GI] = BPP == 4 ? src[1] : neopixel_add_w(src[1], src[3]);                 \
+            dst[BI] = BPP == 4 ? src[2] : neopixel_add_w(src[2], src[3]);                 \
+            if (BPP == 4) dst[WI] = src[3];                                               \
+        }                                                                                 \
+    }
+
+NEOPIXEL_FORMATS(DEFINE_KERNELS)
+
+#define FORMAT_ENTRY(ORDER, NAME, STR, BPP, RI, GI, BI, WI) \
+    [ORDER] = { ORDER, BPP, RI, GI, BI, WI, fill_##NAME, blit_rgb_##NAME, blit_rgbw_##NAME },
+#define NAME_ENTRY(ORDER, NAME, STR, BPP, RI, GI, BI, WI) [ORDER] = STR,
+
+static const neopixel_format_t s_formats[NEOPIXEL_ORDER_COUNT] = { NEOPIXEL_FORMATS(FORMAT_ENTRY) };
+static const char *const s_names[NEOPIXEL_ORDER_COUNT] = { NEOPIXEL_FORMATS(NAME_ENTRY) };
+
+const neopixel_format_t *neopixel_format(neopixel_order_t order) {
+    if ((unsigned)order >= NEOPIXEL_ORDER_COUNT) return NULL;
+    return &s_formats[order];
+}
+
+const char *neopixel_order_name(neopixel_order_t order) {
+    if ((unsigned)order >= NEOPIXEL_ORDER_COUNT) return "?";
+    return s_names[order];
+}
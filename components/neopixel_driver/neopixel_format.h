@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Channel orders on the wire. The frame buffer holds pixels in this order, so
+ * encoding is a straight byte copy. */
+typedef enum {
+    NEOPIXEL_ORDER_GRB,   // WS2812(B)
+    NEOPIXEL_ORDER_GRBW,  // SK6812 RGBW
+    NEOPIXEL_ORDER_RGB,   // WS2811, APA106
+    NEOPIXEL_ORDER_BRG,   // some WS2811 modules
+    NEOPIXEL_ORDER_RGBW,  // SK6812 variants wired RGB-first
+    NEOPIXEL_ORDER_COUNT
+} neopixel_order_t;
+
+/*
+ * One order's layout plus span kernels specialized for it at compile time, so
+ * their inner loops carry no order or W-channel branches. Pure C (no IDF
+ * dependencies). Spans are unchecked: callers clip to the strip.
+ */
+typedef struct {
+    neopixel_order_t order;
+    uint8_t bpp;                    // 3 or 4
+    uint8_t r, g, b, w;             // byte offset of each channel; w only when bpp == 4
+    /** n pixels of one color; w is added to r, g, b on 3-byte orders */
+    void (*fill)(uint8_t *dst, int n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+    /** n pixels from r,g,b triplets; W is cleared on 4-byte orders */
+    void (*blit_rgb)(uint8_t *dst, const uint8_t *rgb, int n);
+    /** n pixels from r,g,b,w quads; W is added to R, G, B on 3-byte orders */
+    void (*blit_rgbw)(uint8_t *dst, const uint8_t *rgbw, int n);
+} neopixel_format_t;
+
+/** A channel plus white, saturating: how 3-byte orders show the W channel */
+static inline uint8_t neopixel_add_w(uint8_t c, uint8_t w) {
+    return (uint8_t)(c + w > 255 ? 255 : c + w);
+}
+
+/** Layout and kernels for an order, NULL if it is not one of the above */
+const neopixel_format_t *neopixel_format(neopixel_order_t order);
+/** Short name ("GRB", "RGBW", ...) for logs */
+const char *neopixel_order_name(neopixel_order_t order);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,81 @@
+#include "pot_filter.h"
+#include <string.h>
+
+#define POT_STILL_SAMPLES 10    // idle samples before each period doubling
+
+void pot_filter_init(pot_filter_t *f, uint8_t alpha_percent, uint16_t band_counts,
+                     uint32_t fast_ms, uint32_t slow_ms) {
+    memset(f, 0, sizeof(*f));
+    f->alpha = alpha_percent > 99 ? 99 : alpha_percent;
+    f->band = band_counts;
+    f->fast_ms = fast_ms;
+    f->slow_ms = slow_ms < fast_ms ? fast_ms : slow_ms;
+    f->period_ms = fast_ms;
+    f->moving_counts = band_counts / 2 ? band_counts / 2 : 1;
+}
+
+static uint16_t median(const uint16_t *v, int n) {
+    uint16_t s[POT_FILTER_MEDIAN_N];
+    memcpy(s, v, (size_t)n * sizeof(s[0]));
+    for (int i = 1; i < n; i++) {           // insertion sort, n <= 5
+        uint16_t x = s[i];
+        int j = i - 1;
+        while (j >= 0 && s[j] > x) { s[j + 1] = s[j]; j--; }
+        s[j + 1] = x;
+    }
+    return s[n / 2];
+}
+
+bool pot_filter_push(pot_filter_t *f, uint16_t raw, uint16_t *filtered) {
+    if (raw > POT_FILTER_MAX_RAW) raw = POT_FILTER_MAX_RAW;
+    f->window[f->head] = raw;
+    f->head = (uint8_t)((f->head + 1) % POT_FILTER_MEDIAN_N);
+    if (f->count < POT_FILTER_MEDIAN_N) f->count++;
+    int32_t m = (int32_t)median(f->window, f->count) << 8;
+
+    if (f->count == 1 || f->alpha == 0) {
+        f->iir_q8 = m;
+    } else {
+        f->iir_q8 = (f->iir_q8 * f->alpha + m * (100 - f->alpha)) / 100;
+    }
+    uint16_t out = (uint16_t)((f->iir_q8 + 128) >> 8);
+    if (filtered) *filtered = out;
+
+    // Adaptive period: any real movement snaps back to fast sampling. A raw
+    // reading far from the output is a spike or the knob starting to move;
+    // the median needs more samples to tell, so get them without an idle wait.
+    int jump = (int)raw - (int)f->last_filtered;
+    f->confirm = f->count > 1 && (jump > (int)f->band || -jump > (int)f->band);
+    int step = (int)out - (int)f->last_filtered;
+    f->last_filtered = out;
+    if (step >= f->moving_counts || -step >= f->moving_counts) {
+        f->still_count = 0;
+        f->period_ms = f->fast_ms;
+    } else if (++f->still_count >= POT_STILL_SAMPLES) {
+        f->still_count = 0;
+        f->period_ms = f->period_ms * 2 > f->slow_ms ? f->slow_ms : f->period_ms * 2;
+    }
+
+    // Hysteresis: report only once the value leaves the band around the last report
+    int delta = (int)out - (int)f->reported;
+    // 0%/100% always reachable: noise at an end stop keeps the output a few
+    // counts off the rail, inside the band, so compare rounded percentages
+    uint8_t pct = pot_filter_percent(out);
+    bool at_end = (pct == 0 || pct == 100) && pct != pot_filter_percent(f->reported);
+    if (!f->has_report || at_end || delta > (int)f->band || -delta > (int)f->band) {
+        f->has_report = true;
+        f->reported = out;
+        f->still_count = 0;
+        f->period_ms = f->fast_ms;
+        return true;
+    }
+    return false;
+}
+
+uint32_t pot_filter_period_ms(const pot_filter_t *f) {
+    return f->confirm ? f->fast_ms : f->period_ms;
+}
+
+uint8_t pot_filter_percent(uint16_t filtered) {
+    return (uint8_t)((filtered * 100U + POT_FILTER_MAX_RAW / 2) / POT_FILTER_MAX_RAW);
+}
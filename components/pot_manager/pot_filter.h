@@ -0,0 +1,60 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Potentiometer signal chain: median-of-5 (kills single-sample spikes) ->
+ * IIR -> hysteresis on the filtered value -> adaptive sample period.
+ * Pure C (no IDF dependencies) so recorded traces can be replayed on the host. */
+
+#define POT_FILTER_MEDIAN_N 5
+#define POT_FILTER_MAX_RAW  4095
+
+typedef struct {
+    uint16_t window[POT_FILTER_MEDIAN_N];
+    uint8_t count;              // samples in the window (fills up at start)
+    uint8_t head;
+    uint8_t alpha;              // IIR "keep old" percent, 0..99 (0 = no IIR)
+    uint16_t band;              // hysteresis in raw counts
+    int32_t iir_q8;             // filtered value, 8 fractional bits
+    uint16_t reported;          // filtered value at the last report
+    bool has_report;
+    // adaptive period
+    uint32_t fast_ms, slow_ms, period_ms;
+    uint16_t still_count;       // consecutive samples without movement
+    uint16_t moving_counts;     // filtered step that counts as movement
+    uint16_t last_filtered;
+    bool confirm;               // last raw reading jumped: take the next one fast
+} pot_filter_t;
+
+/**
+ * @param alpha_percent  IIR smoothing (0..99, higher = smoother)
+ * @param band_counts    how far the filtered value must move from the last
+ *                       report before reporting again
+ * @param fast_ms        sample period while the knob moves
+ * @param slow_ms        period it backs off to when idle
+ */
+void pot_filter_init(pot_filter_t *f, uint8_t alpha_percent, uint16_t band_counts,
+                     uint32_t fast_ms, uint32_t slow_ms);
+
+/**
+ * Add one (possibly oversampled) reading.
+ * @param filtered  receives the filtered value (may be NULL)
+ * @return true when the value moved past the hysteresis band, or onto 0% or
+ *         100% (first sample always reports)
+ */
+bool pot_filter_push(pot_filter_t *f, uint16_t raw, uint16_t *filtered);
+
+/** Delay before the next sample: fast while moving (or to confirm a jump),
+ *  doubling to slow_ms when idle */
+uint32_t pot_filter_period_ms(const pot_filter_t *f);
+
+/** Filtered counts -> 0..100 (rounded) */
+uint8_t pot_filter_percent(uint16_t filtered);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,90 +1,139 @@
 #include "pot_manager.h"
+#include "pot_filter.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
 #include "esp_log.h"
+#include "event_dispatcher.h"
+#include "sdkconfig.h"
+#if CONFIG_POT_MANAGER_CONTINUOUS
+#include "esp_adc/adc_continuous.h"
+#endif
 
 static const char *TAG = "pot_manager";
 
+#define POT_DEFAULT_THRESH_PCT 2
+#define POT_DEFAULT_ALPHA      80
+
 static struct {
     adc1_channel_t chan;
-    uint32_t period_ms;
     pot_cb_t cb;
     void *user;
     uint16_t raw;            // filtered raw 0..4095
     uint8_t percent;         // 0..100
-    uint8_t notify_thresh;   // % delta to notify
-    uint8_t alpha;           // IIR smoothing in percent (0..100)
+    pot_filter_t filter;
 } s_pm;
 
-static TaskHandle_t s_task = NULL;
+static dispatch_timer_t s_timer = DISPATCH_TIMER_INVALID;
+
+#if CONFIG_POT_MANAGER_CONTINUOUS
+/* One hardware-paced burst per sample: the DMA fills a frame of conversions,
+ * which are averaged (oversampling). The driver is stopped between bursts so
+ * its PM lock doesn't keep the CPU out of light sleep while the knob is idle. */
+#define POT_OVERSAMPLE     CONFIG_POT_MANAGER_OVERSAMPLE
+#define POT_FRAME_BYTES    (POT_OVERSAMPLE * SOC_ADC_DIGI_RESULT_BYTES)
+#define POT_SAMPLE_FREQ_HZ 20000     // lowest rate the ESP32 digital controller supports
+
+static adc_continuous_handle_t s_adc = NULL;
+static uint8_t s_frame[POT_FRAME_BYTES];
+
+static bool adc_setup(void) {
+    adc_continuous_handle_cfg_t hcfg = {
+        .max_store_buf_size = POT_FRAME_BYTES * 2,
+        .conv_frame_size = POT_FRAME_BYTES,
+    };
+    if (adc_continuous_new_handle(&hcfg, &s_adc) != ESP_OK) return false;
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_11,
+        .channel = (uint8_t)s_pm.chan,
+        .unit = ADC_UNIT_1,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_continuous_config_t cfg = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = POT_SAMPLE_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    return adc_continuous_config(s_adc, &cfg) == ESP_OK;
+}
+
+static int adc_sample(void) {
+    uint32_t got = 0;
+    if (adc_continuous_start(s_adc) != ESP_OK) return -1;
+    esp_err_t err = adc_continuous_read(s_adc, s_frame, sizeof(s_frame), &got, 20);
+    adc_continuous_stop(s_adc);
+    if (err != ESP_OK) return -1;
+
+    uint32_t sum = 0, n = 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *d = (const adc_digi_output_data_t *)&s_frame[i];
+        if (d->type1.channel != (uint32_t)s_pm.chan) continue;
+        sum += d->type1.data;
+        n++;
+    }
+    return n ? (int)(sum / n) : -1;
+}
+#else
+static bool adc_setup(void) {
+    // Configure ADC1 (12-bit default)
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    // Use atten to cover mostly 0..3.3V; 11dB ~ 0..~3.6V
+    adc1_config_channel_atten(s_pm.chan, ADC_ATTEN_DB_11);
+    return true;
+}
 
-static inline uint16_t lerp_u16(uint16_t a, uint16_t b, uint8_t alpha) {
-    // IIR: a*(alpha/100) + b*(1-alpha/100)
-    // here alpha is "keep old" percent
-    return (uint16_t)((a * alpha + b * (100 - alpha)) / 100);
+static int adc_sample(void) {
+    return adc1_get_raw(s_pm.chan);           // 12-bit: 0..4095
 }
+#endif
 
-static void pot_task(void *arg) {
+/* Dispatcher timer: one sample per expiry (a burst of a few ms in continuous mode) */
+static void pot_sample(void *arg) {
     (void)arg;
-    uint8_t last_notified = 255; // force first notify
-    for (;;) {
-        int raw = adc1_get_raw(s_pm.chan);           // 12-bit: 0..4095
-        if (raw < 0) raw = 0;
+    int raw = adc_sample();
+    if (raw >= 0) {
         if (raw > 4095) raw = 4095;
-
-        if (s_pm.alpha > 0 && s_pm.alpha < 100) {
-            s_pm.raw = lerp_u16(s_pm.raw, (uint16_t)raw, s_pm.alpha);
-        } else {
-            s_pm.raw = (uint16_t)raw;
-        }
-
-        uint8_t pct = (uint8_t)((s_pm.raw * 100U) / 4095U);
-        if (pct > 100) pct = 100;
-        s_pm.percent = pct;
-
-        if (s_pm.cb) {
-            if (last_notified == 255 ||
-                (pct > last_notified
-                    ? (pct - last_notified) >= s_pm.notify_thresh
-                    : (last_notified - pct) >= s_pm.notify_thresh)) {
-                last_notified = pct;
-                s_pm.cb(s_pm.raw, s_pm.percent, s_pm.user);
-            }
-        }
-
-        vTaskDelay(pdMS_TO_TICKS(s_pm.period_ms));
+        uint16_t filtered;
+        bool report = pot_filter_push(&s_pm.filter, (uint16_t)raw, &filtered);
+        s_pm.raw = filtered;
+        s_pm.percent = pot_filter_percent(filtered);
+        if (report && s_pm.cb) s_pm.cb(s_pm.raw, s_pm.percent, s_pm.user);
     }
+    // Fast while the knob moves, backing off to the idle period when it rests
+    event_dispatcher_timer_start(s_timer, pot_filter_period_ms(&s_pm.filter), 0);
 }
 
 bool pot_manager_init(adc1_channel_t channel, uint32_t sample_ms,
                       pot_cb_t cb, void *user) {
     s_pm.chan = channel;
-    s_pm.period_ms = (sample_ms == 0) ? 50 : sample_ms;
     s_pm.cb = cb;
     s_pm.user = user;
     s_pm.raw = 0;
     s_pm.percent = 0;
-    s_pm.notify_thresh = 2;
-    s_pm.alpha = 80; // keep 80% old, 20% new
+    uint32_t fast = (sample_ms == 0) ? 50 : sample_ms;
+    pot_filter_init(&s_pm.filter, POT_DEFAULT_ALPHA, 4095U * POT_DEFAULT_THRESH_PCT / 100U,
+                    fast, CONFIG_POT_MANAGER_IDLE_PERIOD_MS);
 
-    // Configure ADC1 (12-bit default)
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    // Use atten to cover mostly 0..3.3V; 11dB ~ 0..~3.6V
-    adc1_config_channel_atten(s_pm.chan, ADC_ATTEN_DB_11);
+    if (!adc_setup()) {
+        ESP_LOGE(TAG, "ADC setup failed");
+        return false;
+    }
 
-    xTaskCreate(pot_task, "pot_task", 3072, NULL, 5, &s_task);
-    return s_task != NULL;
+    if (!event_dispatcher_init()) return false;
+    s_timer = event_dispatcher_timer_create(pot_sample, NULL, "pot");
+    return event_dispatcher_timer_start(s_timer, 0, 0);
 }
 
 uint16_t pot_manager_get_raw(void) { return s_pm.raw; }
 uint8_t  pot_manager_get_percent(void) { return s_pm.percent; }
+uint32_t pot_manager_get_sample_period_ms(void) { return pot_filter_period_ms(&s_pm.filter); }
 
 void pot_manager_set_notify_threshold_percent(uint8_t pct) {
     if (pct > 50) pct = 50;
-    s_pm.notify_thresh = pct;
+    s_pm.filter.band = (uint16_t)(4095U * pct / 100U);
 }
 
 void pot_manager_set_smoothing(uint8_t alpha_percent) {
-    if (alpha_percent > 100) alpha_percent = 100;
-    s_pm.alpha = alpha_percent;
+    if (alpha_percent > 99) alpha_percent = 99;
+    s_pm.filter.alpha = alpha_percent;
 }
@@ -26,10 +26,16 @@ uint16_t pot_manager_get_raw(void);
 /** Get last mapped percent (0..100) */
 uint8_t pot_manager_get_percent(void);
 
-/** Configure how much change (%) triggers the callback (default 2%) */
+/** Current polling period (ms); each sample is a CPU wakeup. Adaptive: the
+ *  sample_ms given at init while the knob moves, backing off when idle. */
+uint32_t pot_manager_get_sample_period_ms(void);
+
+/** Hysteresis: how far (%) the filtered value must move from the last
+ *  notification before the callback fires again (default 2%) */
 void pot_manager_set_notify_threshold_percent(uint8_t pct);
 
-/** Set IIR smoothing factor (0..100, higher = smoother; default 80) */
+/** Set IIR smoothing factor (0..99, higher = smoother; default 80).
+ *  Applied after a median-of-5 that rejects single-sample spikes. */
 void pot_manager_set_smoothing(uint8_t alpha_percent);
 
 #ifdef __cplusplus
@@ -0,0 +1,80 @@
+#include "power_manager.h"
+#include "esp_pm.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+
+static const char *TAG = "power_manager";
+
+static volatile int64_t s_slept_us = 0;
+static volatile uint32_t s_sleeps = 0;
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+/* Runs inside the sleep critical section: keep it tiny and in IRAM */
+static esp_err_t IRAM_ATTR light_sleep_exit_cb(int64_t sleep_time_us, void *arg) {
+    (void)arg;
+    s_slept_us += sleep_time_us;
+    s_sleeps++;
+    return ESP_OK;
+}
+#endif
+
+bool power_manager_init(void) {
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t cfg = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true
+#endif
+    };
+    esp_err_t err = esp_pm_configure(&cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+        return false;
+    }
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {
+        .exit_cb = light_sleep_exit_cb,
+    };
+    esp_pm_light_sleep_register_cbs(&cbs);
+#endif
+    ESP_LOGI(TAG, "PM enabled: %d..%d MHz, light sleep %s", cfg.min_freq_mhz, cfg.max_freq_mhz,
+             cfg.light_sleep_enable ? "on" : "off");
+    return cfg.light_sleep_enable;
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE is off; light sleep unavailable");
+    return false;
+#endif
+}
+
+void power_manager_get_report(power_report_t *out) {
+    out->uptime_us = esp_timer_get_time();
+    out->slept_us = s_slept_us;
+    out->sleeps = s_sleeps;
+}
+
+void power_manager_log_report(const power_wake_inputs_t *in) {
+    power_report_t r;
+    power_manager_get_report(&r);
+    unsigned pct = r.uptime_us > 0 ? (unsigned)((r.slept_us * 100) / r.uptime_us) : 0;
+    ESP_LOGI(TAG, "asleep %lld ms of %lld ms (%u%%), %u sleeps",
+             (long long)(r.slept_us / 1000), (long long)(r.uptime_us / 1000), pct,
+             (unsigned)r.sleeps);
+
+    if (in) {
+        power_wake_reason_t why;
+        int64_t wake = power_next_wake_us(in, r.uptime_us, &why);
+        if (wake == INT64_MAX) {
+            ESP_LOGI(TAG, "next wake: GPIO only");
+        } else {
+            ESP_LOGI(TAG, "next wake in %lld ms (%s)",
+                     (long long)((wake - r.uptime_us) / 1000), power_wake_reason_str(why));
+        }
+    }
+#if CONFIG_PM_PROFILING
+    esp_pm_dump_locks(stdout);
+#endif
+}
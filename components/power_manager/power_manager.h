@@ -0,0 +1,33 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "power_wake.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int64_t uptime_us;
+    int64_t slept_us;       // total time spent in light sleep
+    uint32_t sleeps;        // number of light-sleep entries
+} power_report_t;
+
+/**
+ * Enable dynamic frequency scaling + automatic light sleep.
+ * Requires CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE; wakeup sources
+ * are the tasks' own timeouts (alarm deadline, pot sampling) plus the button GPIO
+ * (see button_manager_enable_wakeup()).
+ * @return true if light sleep was enabled
+ */
+bool power_manager_init(void);
+
+/** Fill sleep statistics (slept_us stays 0 without CONFIG_PM_LIGHT_SLEEP_CALLBACKS) */
+void power_manager_get_report(power_report_t *out);
+
+/** Log sleep statistics and the next expected wake for the given inputs */
+void power_manager_log_report(const power_wake_inputs_t *in);
+
+#ifdef __cplusplus
+}
+#endif
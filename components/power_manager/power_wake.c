@@ -0,0 +1,36 @@
+#include "power_wake.h"
+#include <stddef.h>
+
+int64_t power_next_wake_us(const power_wake_inputs_t *in, int64_t now_us,
+                           power_wake_reason_t *reason) {
+    power_wake_reason_t why = POWER_WAKE_NONE;
+    int64_t wake = INT64_MAX;
+
+    if (in->render_active) {
+        why = POWER_WAKE_RENDER;
+        wake = now_us;
+    } else {
+        if (in->alarm_wake_us >= 0 && in->alarm_wake_us < wake) {
+            wake = in->alarm_wake_us;
+            why = POWER_WAKE_ALARM;
+        }
+        if (in->pot_next_sample_us >= 0 && in->pot_next_sample_us < wake) {
+            wake = in->pot_next_sample_us;
+            why = POWER_WAKE_POT;
+        }
+        // A deadline already in the past means "wake now"
+        if (wake < now_us) wake = now_us;
+    }
+
+    if (reason) *reason = why;
+    return wake;
+}
+
+const char *power_wake_reason_str(power_wake_reason_t reason) {
+    switch (reason) {
+        case POWER_WAKE_RENDER: return "render";
+        case POWER_WAKE_ALARM:  return "alarm";
+        case POWER_WAKE_POT:    return "pot";
+        default:                return "none";
+    }
+}
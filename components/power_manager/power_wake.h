@@ -0,0 +1,37 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pure wake-time computation (no IDF dependencies) so it can be checked on the host. */
+
+typedef enum {
+    POWER_WAKE_NONE,     // nothing scheduled; only async sources (button GPIO) remain
+    POWER_WAKE_RENDER,   // an animation is running, no sleep at all
+    POWER_WAKE_ALARM,    // alarm manager deadline
+    POWER_WAKE_POT       // next potentiometer sample
+} power_wake_reason_t;
+
+typedef struct {
+    bool render_active;
+    int64_t alarm_wake_us;      // absolute time of the alarm task's next wake, <0 if none
+    int64_t pot_next_sample_us; // absolute time of the next pot sample, <0 if none
+} power_wake_inputs_t;
+
+/**
+ * Earliest time at which something needs the CPU.
+ * @param now_us  current time in the same timebase as the inputs
+ * @param reason  optional, receives which source wins
+ * @return absolute wake time; now_us when rendering; INT64_MAX when nothing is scheduled
+ */
+int64_t power_next_wake_us(const power_wake_inputs_t *in, int64_t now_us,
+                           power_wake_reason_t *reason);
+
+const char *power_wake_reason_str(power_wake_reason_t reason);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+#include "storage_backend.h"
+
+esp_err_t storage_backend_open(storage_backend_t *b, const char *ns, uint32_t *out_handle) {
+    esp_err_t err = b->open(b, ns, out_handle);
+    if (err == ESP_OK) b->stats.opens++;
+    return err;
+}
+
+esp_err_t storage_backend_set_blob(storage_backend_t *b, uint32_t h, const char *key,
+                                   const void *data, size_t len) {
+    esp_err_t err = b->set_blob(b, h, key, data, len);
+    if (err == ESP_OK) {
+        b->stats.writes++;
+        b->stats.bytes_written += len;
+    }
+    return err;
+}
+
+esp_err_t storage_backend_get_blob(storage_backend_t *b, uint32_t h, const char *key,
+                                   void *out, size_t *inout_len) {
+    esp_err_t err = b->get_blob(b, h, key, out, inout_len);
+    b->stats.reads++;
+    if (err == ESP_OK && out) b->stats.bytes_read += *inout_len;
+    return err;
+}
+
+esp_err_t storage_backend_erase(storage_backend_t *b, uint32_t h, const char *key) {
+    esp_err_t err = b->erase(b, h, key);
+    if (err == ESP_OK) b->stats.erases++;
+    return err;
+}
+
+esp_err_t storage_backend_commit(storage_backend_t *b, uint32_t h) {
+    esp_err_t err = b->commit(b, h);
+    b->stats.commits++;
+    return err;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "nvs.h"                // error codes shared by every backend
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counters kept for every backend (updated by the storage_backend_* wrappers) */
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t erases;
+    uint32_t commits;
+    uint32_t opens;
+    uint32_t bytes_read;
+    uint32_t bytes_written;
+} storage_stats_t;
+
+/*
+ * Key/value blob store behind storage_manager. Handles are opaque per-namespace
+ * ids returned by open(); storage_manager caches them, so open() is called once
+ * per namespace. Errors use the NVS codes (ESP_ERR_NVS_NOT_FOUND, ...).
+ */
+typedef struct storage_backend {
+    const char *name;
+    esp_err_t (*init)(struct storage_backend *b);
+    esp_err_t (*open)(struct storage_backend *b, const char *ns, uint32_t *out_handle);
+    esp_err_t (*set_blob)(struct storage_backend *b, uint32_t h, const char *key,
+                          const void *data, size_t len);
+    /* out == NULL queries the stored length only */
+    esp_err_t (*get_blob)(struct storage_backend *b, uint32_t h, const char *key,
+                          void *out, size_t *inout_len);
+    esp_err_t (*erase)(struct storage_backend *b, uint32_t h, const char *key);
+    esp_err_t (*commit)(struct storage_backend *b, uint32_t h);
+    void *ctx;
+    storage_stats_t stats;
+} storage_backend_t;
+
+/** ESP-IDF NVS partition (the on-device default) */
+storage_backend_t *storage_backend_nvs(void);
+/** Volatile RAM store; commits are counted but persist nothing */
+storage_backend_t *storage_backend_mem(void);
+/** RAM store persisted to a file on every commit (Linux host builds) */
+storage_backend_t *storage_backend_file(const char *path);
+
+/* Counting wrappers used by storage_manager */
+esp_err_t storage_backend_open(storage_backend_t *b, const char *ns, uint32_t *out_handle);
+esp_err_t storage_backend_set_blob(storage_backend_t *b, uint32_t h, const char *key,
+                                   const void *data, size_t len);
+esp_err_t storage_backend_get_blob(storage_backend_t *b, uint32_t h, const char *key,
+                                   void *out, size_t *inout_len);
+esp_err_t storage_backend_erase(storage_backend_t *b, uint32_t h, const char *key);
+esp_err_t storage_backend_commit(storage_backend_t *b, uint32_t h);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,232 @@
+#include "storage_backend.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "storage_mem";
+
+#define MEM_MAX_ENTRIES     64
+#define MEM_MAX_NAMESPACES  8
+#define MEM_NAME_LEN        16      // matches NVS: 15 chars + NUL
+#define FILE_MAGIC          0x42534143u  // "CASB"
+#define FILE_VERSION        1
+
+typedef struct {
+    bool used;
+    uint8_t ns;                 // index into mem_ctx_t.ns
+    char key[MEM_NAME_LEN];
+    uint8_t *data;
+    size_t len;
+} mem_entry_t;
+
+typedef struct {
+    mem_entry_t entries[MEM_MAX_ENTRIES];
+    char ns[MEM_MAX_NAMESPACES][MEM_NAME_LEN];
+    int ns_count;
+    const char *path;           // NULL for the purely volatile backend
+} mem_ctx_t;
+
+static mem_ctx_t s_mem_ctx;
+static mem_ctx_t s_file_ctx;
+
+static mem_entry_t *mem_find(mem_ctx_t *c, uint32_t h, const char *key) {
+    for (int i = 0; i < MEM_MAX_ENTRIES; i++) {
+        mem_entry_t *e = &c->entries[i];
+        if (e->used && e->ns == h && strcmp(e->key, key) == 0) return e;
+    }
+    return NULL;
+}
+
+static int mem_ns_index(mem_ctx_t *c, const char *ns, bool create) {
+    for (int i = 0; i < c->ns_count; i++) {
+        if (strcmp(c->ns[i], ns) == 0) return i;
+    }
+    if (!create || c->ns_count >= MEM_MAX_NAMESPACES) return -1;
+    snprintf(c->ns[c->ns_count], MEM_NAME_LEN, "%s", ns);
+    return c->ns_count++;
+}
+
+static esp_err_t mem_put(mem_ctx_t *c, uint32_t h, const char *key, const void *data, size_t len) {
+    if (strlen(key) >= MEM_NAME_LEN) return ESP_ERR_INVALID_ARG;
+    mem_entry_t *e = mem_find(c, h, key);
+    if (!e) {
+        for (int i = 0; i < MEM_MAX_ENTRIES && !e; i++) {
+            if (!c->entries[i].used) e = &c->entries[i];
+        }
+        if (!e) return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        memset(e, 0, sizeof(*e));
+        e->ns = (uint8_t)h;
+        snprintf(e->key, MEM_NAME_LEN, "%s", key);
+    }
+    uint8_t *copy = malloc(len ? len : 1);
+    if (!copy) return ESP_ERR_NO_MEM;
+    memcpy(copy, data, len);
+    free(e->data);
+    e->data = copy;
+    e->len = len;
+    e->used = true;
+    return ESP_OK;
+}
+
+static void mem_reset(mem_ctx_t *c) {
+    for (int i = 0; i < MEM_MAX_ENTRIES; i++) free(c->entries[i].data);
+    memset(c->entries, 0, sizeof(c->entries));
+    memset(c->ns, 0, sizeof(c->ns));
+    c->ns_count = 0;
+}
+
+static esp_err_t mem_be_init(storage_backend_t *b) {
+    (void)b;
+    return ESP_OK;
+}
+
+static esp_err_t mem_be_open(storage_backend_t *b, const char *ns, uint32_t *out_handle) {
+    int idx = mem_ns_index(b->ctx, ns, true);
+    if (idx < 0) return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    *out_handle = (uint32_t)idx;
+    return ESP_OK;
+}
+
+static esp_err_t mem_be_set_blob(storage_backend_t *b, uint32_t h, const char *key,
+                                 const void *data, size_t len) {
+    return mem_put(b->ctx, h, key, data, len);
+}
+
+static esp_err_t mem_be_get_blob(storage_backend_t *b, uint32_t h, const char *key,
+                                 void *out, size_t *inout_len) {
+    mem_entry_t *e = mem_find(b->ctx, h, key);
+    if (!e) return ESP_ERR_NVS_NOT_FOUND;
+    if (out) {
+        if (*inout_len < e->len) return ESP_ERR_NVS_INVALID_LENGTH;
+        memcpy(out, e->data, e->len);
+    }
+    *inout_len = e->len;
+    return ESP_OK;
+}
+
+static esp_err_t mem_be_erase(storage_backend_t *b, uint32_t h, const char *key) {
+    mem_entry_t *e = mem_find(b->ctx, h, key);
+    if (!e) return ESP_ERR_NVS_NOT_FOUND;
+    free(e->data);
+    memset(e, 0, sizeof(*e));
+    return ESP_OK;
+}
+
+static esp_err_t mem_be_commit(storage_backend_t *b, uint32_t h) {
+    (void)b; (void)h;
+    return ESP_OK;
+}
+
+/* ---- File persistence: whole store rewritten on commit ---- */
+
+static bool write_str(FILE *f, const char *s) {
+    uint8_t n = (uint8_t)strlen(s);
+    return fwrite(&n, 1, 1, f) == 1 && fwrite(s, 1, n, f) == n;
+}
+
+static bool read_str(FILE *f, char *out) {
+    uint8_t n;
+    if (fread(&n, 1, 1, f) != 1 || n >= MEM_NAME_LEN) return false;
+    if (fread(out, 1, n, f) != n) return false;
+    out[n] = '\0';
+    return true;
+}
+
+static esp_err_t file_be_init(storage_backend_t *b) {
+    mem_ctx_t *c = b->ctx;
+    mem_reset(c);            // the file is the source of truth
+    FILE *f = fopen(c->path, "rb");
+    if (!f) return ESP_OK;   // first run: empty store
+
+    uint32_t hdr[3];  // magic, version, count
+    esp_err_t err = ESP_OK;
+    if (fread(hdr, sizeof(hdr), 1, f) != 1 || hdr[0] != FILE_MAGIC || hdr[1] != FILE_VERSION) {
+        ESP_LOGW(TAG, "%s: bad header, starting empty", c->path);
+        fclose(f);
+        return ESP_OK;
+    }
+    for (uint32_t i = 0; i < hdr[2] && err == ESP_OK; i++) {
+        char ns[MEM_NAME_LEN], key[MEM_NAME_LEN];
+        uint32_t len;
+        if (!read_str(f, ns) || !read_str(f, key) || fread(&len, sizeof(len), 1, f) != 1) {
+            err = ESP_FAIL;
+            break;
+        }
+        uint8_t *buf = malloc(len ? len : 1);
+        if (!buf) { err = ESP_ERR_NO_MEM; break; }
+        if (fread(buf, 1, len, f) != len) {
+            free(buf);
+            err = ESP_FAIL;
+            break;
+        }
+        int idx = mem_ns_index(c, ns, true);
+        err = (idx < 0) ? ESP_ERR_NVS_NOT_ENOUGH_SPACE : mem_put(c, (uint32_t)idx, key, buf, len);
+        free(buf);
+    }
+    fclose(f);
+    if (err != ESP_OK) ESP_LOGW(TAG, "%s: truncated store (%s)", c->path, esp_err_to_name(err));
+    return ESP_OK;
+}
+
+static esp_err_t file_be_commit(storage_backend_t *b, uint32_t h) {
+    (void)h;
+    mem_ctx_t *c = b->ctx;
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", c->path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return ESP_FAIL;
+
+    uint32_t count = 0;
+    for (int i = 0; i < MEM_MAX_ENTRIES; i++) {
+        if (c->entries[i].used) count++;
+    }
+    uint32_t hdr[3] = { FILE_MAGIC, FILE_VERSION, count };
+    bool ok = fwrite(hdr, sizeof(hdr), 1, f) == 1;
+    for (int i = 0; i < MEM_MAX_ENTRIES && ok; i++) {
+        mem_entry_t *e = &c->entries[i];
+        if (!e->used) continue;
+        uint32_t len = (uint32_t)e->len;
+        ok = write_str(f, c->ns[e->ns]) && write_str(f, e->key) &&
+             fwrite(&len, sizeof(len), 1, f) == 1 &&
+             fwrite(e->data, 1, e->len, f) == e->len;
+    }
+    if (fclose(f) != 0) ok = false;
+    // Atomic replace so a crash mid-commit keeps the previous store
+    if (!ok || rename(tmp, c->path) != 0) {
+        remove(tmp);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static storage_backend_t s_mem_backend = {
+    .name = "mem",
+    .init = mem_be_init,
+    .open = mem_be_open,
+    .set_blob = mem_be_set_blob,
+    .get_blob = mem_be_get_blob,
+    .erase = mem_be_erase,
+    .commit = mem_be_commit,
+    .ctx = &s_mem_ctx,
+};
+
+static storage_backend_t s_file_backend = {
+    .name = "file",
+    .init = file_be_init,
+    .open = mem_be_open,
+    .set_blob = mem_be_set_blob,
+    .get_blob = mem_be_get_blob,
+    .erase = mem_be_erase,
+    .commit = file_be_commit,
+    .ctx = &s_file_ctx,
+};
+
+storage_backend_t *storage_backend_mem(void) {
+    return &s_mem_backend;
+}
+
+storage_backend_t *storage_backend_file(const char *path) {
+    s_file_ctx.path = path;
+    return &s_file_backend;
+}
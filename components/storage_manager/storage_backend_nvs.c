@@ -0,0 +1,57 @@
+#include "storage_backend.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+static esp_err_t nvs_be_init(storage_backend_t *b) {
+    (void)b;
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        nvs_flash_erase();
+        ret = nvs_flash_init();
+    }
+    return ret;
+}
+
+static esp_err_t nvs_be_open(storage_backend_t *b, const char *ns, uint32_t *out_handle) {
+    (void)b;
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(ns, NVS_READWRITE, &h);
+    if (err == ESP_OK) *out_handle = (uint32_t)h;
+    return err;
+}
+
+static esp_err_t nvs_be_set_blob(storage_backend_t *b, uint32_t h, const char *key,
+                                 const void *data, size_t len) {
+    (void)b;
+    return nvs_set_blob((nvs_handle_t)h, key, data, len);
+}
+
+static esp_err_t nvs_be_get_blob(storage_backend_t *b, uint32_t h, const char *key,
+                                 void *out, size_t *inout_len) {
+    (void)b;
+    return nvs_get_blob((nvs_handle_t)h, key, out, inout_len);
+}
+
+static esp_err_t nvs_be_erase(storage_backend_t *b, uint32_t h, const char *key) {
+    (void)b;
+    return nvs_erase_key((nvs_handle_t)h, key);
+}
+
+static esp_err_t nvs_be_commit(storage_backend_t *b, uint32_t h) {
+    (void)b;
+    return nvs_commit((nvs_handle_t)h);
+}
+
+static storage_backend_t s_nvs_backend = {
+    .name = "nvs",
+    .init = nvs_be_init,
+    .open = nvs_be_open,
+    .set_blob = nvs_be_set_blob,
+    .get_blob = nvs_be_get_blob,
+    .erase = nvs_be_erase,
+    .commit = nvs_be_commit,
+};
+
+storage_backend_t *storage_backend_nvs(void) {
+    return &s_nvs_backend;
+}
@@ -0,0 +1,64 @@
+#include "storage_manager.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+
+static const char *TAG = "storage_bench";
+
+#define BENCH_NS "bench"
+
+/* Baseline: what storage_manager did before handle caching/batching */
+static void legacy_set(const char *key, uint32_t v, uint32_t *commits) {
+    nvs_handle_t h;
+    if (nvs_open(BENCH_NS, NVS_READWRITE, &h) != ESP_OK) return;
+    if (nvs_set_blob(h, key, &v, sizeof(v)) == ESP_OK) {
+        nvs_commit(h);
+        (*commits)++;
+    }
+    nvs_close(h);
+}
+
+static void report(const char *name, int updates, int keys, int64_t us, uint32_t commits) {
+    uint32_t ops = (uint32_t)(updates * keys);
+    uint32_t ops_per_s = us > 0 ? (uint32_t)((int64_t)ops * 1000000 / us) : 0;
+    ESP_LOGI(TAG, "%-8s %6u ops in %7lld us: %6u ops/s, %u.%02u commits/update",
+             name, (unsigned)ops, (long long)us, (unsigned)ops_per_s,
+             (unsigned)(commits / updates), (unsigned)((commits * 100 / updates) % 100));
+}
+
+void storage_manager_run_benchmark(int updates, int keys_per_update) {
+    if (updates <= 0 || keys_per_update <= 0) return;
+    char key[8];
+
+    uint32_t legacy_commits = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (int u = 0; u < updates; u++) {
+        for (int k = 0; k < keys_per_update; k++) {
+            snprintf(key, sizeof(key), "k%d", k);
+            legacy_set(key, (uint32_t)(u * 31 + k), &legacy_commits);
+        }
+    }
+    int64_t legacy_us = esp_timer_get_time() - t0;
+
+    storage_stats_t before, after;
+    storage_manager_get_stats(&before);
+    t0 = esp_timer_get_time();
+    for (int u = 0; u < updates; u++) {
+        storage_manager_begin();
+        for (int k = 0; k < keys_per_update; k++) {
+            uint32_t v = (uint32_t)(u * 31 + k + 1);
+            snprintf(key, sizeof(key), "k%d", k);
+            storage_manager_set_blob_ns(BENCH_NS, key, &v, sizeof(v));
+        }
+        storage_manager_commit();
+    }
+    int64_t batched_us = esp_timer_get_time() - t0;
+    storage_manager_get_stats(&after);
+
+    report("legacy", updates, keys_per_update, legacy_us, legacy_commits);
+    ESP_LOGI(TAG, "cached/batched path uses the '%s' backend", storage_manager_get_backend()->name);
+    report("batched", updates, keys_per_update, batched_us, after.commits - before.commits);
+    ESP_LOGI(TAG, "nvs_open calls: legacy %d, cached %u",
+             updates * keys_per_update, (unsigned)(after.opens - before.opens));
+}
@@ -1,33 +1,188 @@
-
 #include "storage_manager.h"
-#include "nvs_flash.h"
-#include "nvs.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
 
-bool storage_manager_init(void) {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        nvs_flash_erase();
-        ret = nvs_flash_init();
+static const char *TAG = "storage_manager";
+
+#define STORAGE_MAX_NAMESPACES 4
+
+typedef struct {
+    char ns[16];          // NVS namespace names are at most 15 chars
+    uint32_t handle;      // backend handle
+    bool open;
+    bool dirty;           // written since the last commit
+} ns_handle_t;
+
+static ns_handle_t s_ns[STORAGE_MAX_NAMESPACES];
+static SemaphoreHandle_t s_lock = NULL;
+static int s_batch_depth = 0;
+static storage_backend_t *s_backend = NULL;
+
+static void lock(void)   { if (s_lock) xSemaphoreTakeRecursive(s_lock, portMAX_DELAY); }
+static void unlock(void) { if (s_lock) xSemaphoreGiveRecursive(s_lock); }
+
+/* Return the cached read-write handle for a namespace, opening it on first use.
+ * Caller holds the lock. */
+static ns_handle_t *get_ns(const char *ns) {
+    ns_handle_t *free_slot = NULL;
+    for (int i = 0; i < STORAGE_MAX_NAMESPACES; i++) {
+        if (s_ns[i].open && strcmp(s_ns[i].ns, ns) == 0) return &s_ns[i];
+        if (!s_ns[i].open && !free_slot) free_slot = &s_ns[i];
+    }
+    if (!free_slot) {
+        ESP_LOGE(TAG, "No free handle slot for namespace '%s'", ns);
+        return NULL;
     }
-    return ret == ESP_OK;
+    if (!s_backend || storage_backend_open(s_backend, ns, &free_slot->handle) != ESP_OK) return NULL;
+    strncpy(free_slot->ns, ns, sizeof(free_slot->ns)-1);
+    free_slot->open = true;
+    free_slot->dirty = false;
+    return free_slot;
 }
 
-bool storage_manager_set_blob(const char *key, const void *data, size_t len) {
-    nvs_handle_t handle;
-    if (nvs_open("storage", NVS_READWRITE, &handle) != ESP_OK) return false;
-    esp_err_t err = nvs_set_blob(handle, key, data, len);
-    if (err == ESP_OK) err = nvs_commit(handle);
-    nvs_close(handle);
+/* Commit now unless a batch is open. Caller holds the lock. */
+static esp_err_t finish_write(ns_handle_t *h, esp_err_t err) {
+    if (err != ESP_OK) return err;
+    h->dirty = true;
+    if (s_batch_depth > 0) return ESP_OK;
+    err = storage_backend_commit(s_backend, h->handle);
+    h->dirty = false;
+    return err;
+}
+
+bool storage_manager_init_with_backend(storage_backend_t *backend) {
+    if (!s_lock) s_lock = xSemaphoreCreateRecursiveMutex();
+    lock();
+    memset(s_ns, 0, sizeof(s_ns));     // handles belong to the previous backend
+    s_batch_depth = 0;
+    s_backend = backend;
+    esp_err_t err = backend->init(backend);
+    unlock();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Backend '%s' init failed: %s", backend->name, esp_err_to_name(err));
+        return false;
+    }
+    ESP_LOGI(TAG, "Using '%s' backend", backend->name);
+    return true;
+}
+
+bool storage_manager_init(void) {
+#if CONFIG_STORAGE_MANAGER_BACKEND_FILE
+    return storage_manager_init_with_backend(storage_backend_file(CONFIG_STORAGE_MANAGER_FILE_PATH));
+#elif CONFIG_STORAGE_MANAGER_BACKEND_MEM
+    return storage_manager_init_with_backend(storage_backend_mem());
+#else
+    return storage_manager_init_with_backend(storage_backend_nvs());
+#endif
+}
+
+storage_backend_t *storage_manager_get_backend(void) {
+    return s_backend;
+}
+
+bool storage_manager_set_blob_ns(const char *ns, const char *key, const void *data, size_t len) {
+    lock();
+    ns_handle_t *h = get_ns(ns);
+    esp_err_t err = h ? finish_write(h, storage_backend_set_blob(s_backend, h->handle, key, data, len))
+                      : ESP_FAIL;
+    unlock();
     return err == ESP_OK;
 }
 
-bool storage_manager_get_blob(const char *key, void *out_data, size_t len, size_t *out_len) {
-    nvs_handle_t handle;
-    if (nvs_open("storage", NVS_READONLY, &handle) != ESP_OK) return false;
+bool storage_manager_get_blob_ns(const char *ns, const char *key, void *out_data, size_t len, size_t *out_len) {
+    lock();
+    ns_handle_t *h = get_ns(ns);
     size_t required = len;
-    esp_err_t err = nvs_get_blob(handle, key, out_data, &required);
+    esp_err_t err = h ? storage_backend_get_blob(s_backend, h->handle, key, out_data, &required)
+                      : ESP_FAIL;
+    unlock();
     if (out_len) *out_len = required;
-    nvs_close(handle);
     return err == ESP_OK;
 }
+
+bool storage_manager_erase_ns(const char *ns, const char *key) {
+    lock();
+    ns_handle_t *h = get_ns(ns);
+    esp_err_t err = h ? storage_backend_erase(s_backend, h->handle, key) : ESP_FAIL;
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_OK;
+    } else if (h) {
+        err = finish_write(h, err);
+    }
+    unlock();
+    return err == ESP_OK;
+}
+
+bool storage_manager_set_blob(const char *key, const void *data, size_t len) {
+    return storage_manager_set_blob_ns(STORAGE_DEFAULT_NS, key, data, len);
+}
+
+bool storage_manager_get_blob(const char *key, void *out_data, size_t len, size_t *out_len) {
+    return storage_manager_get_blob_ns(STORAGE_DEFAULT_NS, key, out_data, len, out_len);
+}
+
+bool storage_manager_erase(const char *key) {
+    return storage_manager_erase_ns(STORAGE_DEFAULT_NS, key);
+}
+
+bool storage_manager_get_blob_size(const char *key, size_t *out_len) {
+    lock();
+    ns_handle_t *h = get_ns(STORAGE_DEFAULT_NS);
+    size_t required = 0;
+    // A NULL buffer reports the stored length only
+    esp_err_t err = h ? storage_backend_get_blob(s_backend, h->handle, key, NULL, &required)
+                      : ESP_FAIL;
+    unlock();
+    if (out_len) *out_len = (err == ESP_OK) ? required : 0;
+    return err == ESP_OK;
+}
+
+/* Typed values are stored as fixed-size blobs so every backend supports them */
+#define TYPED_ACCESSORS(name, type)                                             \
+    bool storage_manager_set_##name(const char *key, type value) {              \
+        return storage_manager_set_blob(key, &value, sizeof(value));            \
+    }                                                                           \
+    bool storage_manager_get_##name(const char *key, type *out) {               \
+        type v;                                                                 \
+        size_t len = 0;                                                         \
+        if (!storage_manager_get_blob(key, &v, sizeof(v), &len) ||              \
+            len != sizeof(v)) return false;                                     \
+        *out = v;                                                               \
+        return true;                                                            \
+    }
+
+TYPED_ACCESSORS(u8, uint8_t)
+TYPED_ACCESSORS(u32, uint32_t)
+TYPED_ACCESSORS(i32, int32_t)
+
+void storage_manager_begin(void) {
+    lock();
+    s_batch_depth++;
+    unlock();
+}
+
+bool storage_manager_commit(void) {
+    lock();
+    esp_err_t err = ESP_OK;
+    if (s_batch_depth > 0) s_batch_depth--;
+    if (s_batch_depth == 0) {
+        for (int i = 0; i < STORAGE_MAX_NAMESPACES; i++) {
+            if (!s_ns[i].open || !s_ns[i].dirty) continue;
+            esp_err_t e = storage_backend_commit(s_backend, s_ns[i].handle);
+            s_ns[i].dirty = false;
+            if (e != ESP_OK) err = e;
+        }
+    }
+    unlock();
+    return err == ESP_OK;
+}
+
+void storage_manager_get_stats(storage_stats_t *out) {
+    lock();
+    if (s_backend) *out = s_backend->stats;
+    else memset(out, 0, sizeof(*out));
+    unlock();
+}
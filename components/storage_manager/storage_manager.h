@@ -1,7 +1,51 @@
-
 #pragma once
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "storage_backend.h"
+
+#define STORAGE_DEFAULT_NS "storage"
+
+/** Init with the backend selected in Kconfig (NVS on device, file on Linux) */
 bool storage_manager_init(void);
+/** Init with an explicit backend (e.g. storage_backend_mem() for experiments) */
+bool storage_manager_init_with_backend(storage_backend_t *backend);
+storage_backend_t *storage_manager_get_backend(void);
 bool storage_manager_set_blob(const char *key, const void *data, size_t len);
 bool storage_manager_get_blob(const char *key, void *out_data, size_t len, size_t *out_len);
+/** Remove a key; returns true if it was erased or did not exist */
+bool storage_manager_erase(const char *key);
+
+/** Size of a stored blob without reading it; false if the key is missing */
+bool storage_manager_get_blob_size(const char *key, size_t *out_len);
+
+/* Namespace-aware variants (handles stay open per namespace) */
+bool storage_manager_set_blob_ns(const char *ns, const char *key, const void *data, size_t len);
+bool storage_manager_get_blob_ns(const char *ns, const char *key, void *out_data, size_t len, size_t *out_len);
+bool storage_manager_erase_ns(const char *ns, const char *key);
+
+/* Typed helpers (default namespace) */
+bool storage_manager_set_u8(const char *key, uint8_t value);
+bool storage_manager_get_u8(const char *key, uint8_t *out);
+bool storage_manager_set_u32(const char *key, uint32_t value);
+bool storage_manager_get_u32(const char *key, uint32_t *out);
+bool storage_manager_set_i32(const char *key, int32_t value);
+bool storage_manager_get_i32(const char *key, int32_t *out);
+
+/**
+ * Batching: writes between begin() and commit() are not committed individually;
+ * commit() issues one nvs_commit per touched namespace. Calls may nest; only the
+ * outermost commit() flushes.
+ */
+void storage_manager_begin(void);
+bool storage_manager_commit(void);
+
+/** Counters of the active backend (reads, writes, bytes, commits, opens) */
+void storage_manager_get_stats(storage_stats_t *out);
+
+/**
+ * Microbenchmark: compares the open/commit/close-per-call path against cached
+ * handles + batched commits for `updates` logical updates of `keys_per_update`
+ * keys each, and logs ops/sec and commits per logical update.
+ */
+void storage_manager_run_benchmark(int updates, int keys_per_update);
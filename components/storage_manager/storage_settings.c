@@ -0,0 +1,166 @@
+#include "storage_settings.h"
+#include "storage_manager.h"
+#include "event_dispatcher.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include <string.h>
+
+static const char *TAG = "storage_settings";
+
+typedef struct {
+    char key[16];       // NVS key limit is 15 chars
+    int32_t value;
+    bool used;
+    bool dirty;
+} setting_t;
+
+static setting_t s_settings[STORAGE_SETTINGS_MAX];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static TimerHandle_t s_flush_timer = NULL;
+static uint32_t s_flush_delay_ms = STORAGE_SETTINGS_DEFAULT_DELAY_MS;
+
+/* Caller holds s_lock */
+static setting_t *find(const char *key) {
+    for (int i = 0; i < STORAGE_SETTINGS_MAX; i++) {
+        if (s_settings[i].used && strcmp(s_settings[i].key, key) == 0) return &s_settings[i];
+    }
+    return NULL;
+}
+
+/* Caller holds s_lock */
+static setting_t *insert(const char *key, int32_t value) {
+    for (int i = 0; i < STORAGE_SETTINGS_MAX; i++) {
+        if (!s_settings[i].used) {
+            setting_t *st = &s_settings[i];
+            memset(st, 0, sizeof(*st));
+            strncpy(st->key, key, sizeof(st->key)-1);
+            st->value = value;
+            st->used = true;
+            return st;
+        }
+    }
+    return NULL;
+}
+
+static void flush_job(void *arg) {
+    (void)arg;
+    storage_settings_flush();
+}
+
+static void flush_timer_cb(TimerHandle_t t) {
+    (void)t;
+    // NVS writes can take tens of ms; run them on the dispatcher, not the timer task
+    if (!event_dispatcher_post(flush_job, NULL, DISPATCH_PRIO_LOW, "settings_flush")) {
+        xTimerReset(s_flush_timer, 0);
+    }
+}
+
+static void shutdown_handler(void) {
+    storage_settings_flush();
+}
+
+bool storage_settings_init(uint32_t flush_delay_ms) {
+    if (s_flush_timer) return true;
+    if (flush_delay_ms) s_flush_delay_ms = flush_delay_ms;
+    event_dispatcher_init();
+    s_flush_timer = xTimerCreate("set_flush", pdMS_TO_TICKS(s_flush_delay_ms),
+                                 pdFALSE, NULL, flush_timer_cb);
+    if (!s_flush_timer) return false;
+    esp_register_shutdown_handler(shutdown_handler);
+    return true;
+}
+
+void storage_settings_set_flush_delay(uint32_t flush_delay_ms) {
+    if (flush_delay_ms == 0) return;
+    s_flush_delay_ms = flush_delay_ms;
+    if (s_flush_timer) xTimerChangePeriod(s_flush_timer, pdMS_TO_TICKS(flush_delay_ms), 0);
+}
+
+int32_t storage_settings_get(const char *key, int32_t def) {
+    taskENTER_CRITICAL(&s_lock);
+    setting_t *st = find(key);
+    int32_t v = st ? st->value : def;
+    taskEXIT_CRITICAL(&s_lock);
+    if (st) return v;
+
+    // Cache miss: one flash read, then the key lives in RAM
+    int32_t stored;
+    if (storage_manager_get_blob_ns(STORAGE_SETTINGS_NS, key, &stored, sizeof(stored), NULL)) {
+        v = stored;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    st = find(key);
+    if (st) v = st->value;   // raced with a set(); keep the newer value
+    else insert(key, v);     // if the cache is full the value is simply not cached
+    taskEXIT_CRITICAL(&s_lock);
+    return v;
+}
+
+bool storage_settings_set(const char *key, int32_t value) {
+    bool changed = false;
+    taskENTER_CRITICAL(&s_lock);
+    setting_t *st = find(key);
+    if (!st) {
+        st = insert(key, value);
+        changed = (st != NULL);
+    } else if (st->value != value) {
+        st->value = value;
+        changed = true;
+    }
+    if (changed) st->dirty = true;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!st) {
+        ESP_LOGE(TAG, "Settings cache full, dropping '%s'", key);
+        return false;
+    }
+    if (changed) {
+        if (s_flush_timer) xTimerReset(s_flush_timer, 0);   // debounce
+        else storage_settings_flush();
+    }
+    return true;
+}
+
+bool storage_settings_flush(void) {
+    setting_t pending[STORAGE_SETTINGS_MAX];
+    int n = 0;
+
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < STORAGE_SETTINGS_MAX; i++) {
+        if (s_settings[i].used && s_settings[i].dirty) {
+            pending[n++] = s_settings[i];
+            s_settings[i].dirty = false;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (n == 0) return true;
+
+    bool ok = true;
+    storage_manager_begin();
+    for (int i = 0; i < n; i++) {
+        if (!storage_manager_set_blob_ns(STORAGE_SETTINGS_NS, pending[i].key,
+                                         &pending[i].value, sizeof(pending[i].value))) {
+            ok = false;
+            // Re-mark so the next flush retries it
+            taskENTER_CRITICAL(&s_lock);
+            setting_t *st = find(pending[i].key);
+            if (st) st->dirty = true;
+            taskEXIT_CRITICAL(&s_lock);
+        }
+    }
+    if (!storage_manager_commit()) ok = false;
+    ESP_LOGD(TAG, "Flushed %d settings", n);
+    return ok;
+}
+
+int storage_settings_dirty_count(void) {
+    int n = 0;
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < STORAGE_SETTINGS_MAX; i++) {
+        if (s_settings[i].used && s_settings[i].dirty) n++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return n;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Write-behind settings cache for small, frequently changing values
+ * (brightness, lamp state, last animation...).
+ *
+ * Reads are served from RAM. Writes only update RAM and mark the key dirty;
+ * a debounced flush writes all dirty keys in one NVS commit once writes
+ * have been quiet for the flush delay. Pending values are also flushed from
+ * an esp_restart() shutdown handler.
+ */
+
+#define STORAGE_SETTINGS_NS           "settings"
+#define STORAGE_SETTINGS_MAX          16
+#define STORAGE_SETTINGS_DEFAULT_DELAY_MS 5000
+
+/**
+ * Create the flush timer and register the shutdown hook.
+ * @param flush_delay_ms quiet time before dirty keys are written (0 = default)
+ */
+bool storage_settings_init(uint32_t flush_delay_ms);
+
+/** Change the debounce delay at runtime */
+void storage_settings_set_flush_delay(uint32_t flush_delay_ms);
+
+/**
+ * Cached read. The first read of a key loads it from NVS (or uses `def`
+ * if it was never stored); later reads never touch flash.
+ */
+int32_t storage_settings_get(const char *key, int32_t def);
+
+/** Cached write; no flash access unless the value actually changed and the delay expires */
+bool storage_settings_set(const char *key, int32_t value);
+
+/** Write all dirty keys now (blocking). Safe to call from any task. */
+bool storage_settings_flush(void);
+
+/** Number of keys waiting to be flushed */
+int storage_settings_dirty_count(void);
+
+#ifdef __cplusplus
+}
+#endif
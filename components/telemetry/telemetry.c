@@ -0,0 +1,202 @@
+#include "telemetry.h"
+#include "event_dispatcher.h"
+#include "alarm_manager.h"
+#include "neopixel_driver.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "telemetry";
+
+#define TELEMETRY_RING_LEN  CONFIG_TELEMETRY_RING_LEN
+#define TELEMETRY_PREV_LEN  32      // tasks whose run-time counter we remember
+
+/* Run-time counter at the previous sample, per task, for CPU deltas */
+typedef struct {
+    TaskHandle_t h;
+    uint32_t runtime;
+} prev_runtime_t;
+
+static telemetry_sample_t s_ring[TELEMETRY_RING_LEN];
+static int s_head = 0;              // next slot to write
+static int s_count = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static dispatch_timer_t s_timer = DISPATCH_TIMER_INVALID;
+
+static prev_runtime_t s_prev[TELEMETRY_PREV_LEN];
+static int s_prev_count = 0;
+static uint32_t s_prev_total = 0;
+
+static uint32_t prev_runtime(TaskHandle_t h, bool *found) {
+    for (int i = 0; i < s_prev_count; i++) {
+        if (s_prev[i].h == h) { *found = true; return s_prev[i].runtime; }
+    }
+    *found = false;
+    return 0;
+}
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+/* Fill sample->tasks from uxTaskGetSystemState(); keeps the tasks with the
+ * least stack headroom when there are more than TELEMETRY_MAX_TASKS. */
+static void sample_tasks(telemetry_sample_t *s) {
+    UBaseType_t n = uxTaskGetNumberOfTasks() + 2;   // room for tasks created meanwhile
+    TaskStatus_t *st = malloc(n * sizeof(TaskStatus_t));
+    if (!st) return;
+    uint32_t total = 0;
+    n = uxTaskGetSystemState(st, n, &total);
+    s->tasks_total = (uint16_t)n;
+
+    // Total CPU capacity over the interval is wall time on every core
+    const uint32_t total_delta = (total - s_prev_total) * portNUM_PROCESSORS;
+    for (UBaseType_t i = 0; i < n; i++) {
+        bool known;
+        uint32_t prev = prev_runtime(st[i].xHandle, &known);
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        uint32_t delta = st[i].ulRunTimeCounter - prev;
+#else
+        uint32_t delta = 0;
+        (void)prev;
+#endif
+        telemetry_task_t t = {
+            .cpu_permille = (known && total_delta)
+                            ? (uint16_t)((uint64_t)delta * 1000U / total_delta) : 0,
+            .stack_free = (uint16_t)(st[i].usStackHighWaterMark * sizeof(StackType_t)),
+        };
+        strncpy(t.name, st[i].pcTaskName, TELEMETRY_NAME_LEN - 1);
+
+        // Insert sorted by stack headroom, dropping the roomiest when full
+        int pos = s->task_count;
+        while (pos > 0 && s->tasks[pos - 1].stack_free > t.stack_free) pos--;
+        if (pos >= TELEMETRY_MAX_TASKS) continue;
+        int last = s->task_count < TELEMETRY_MAX_TASKS ? s->task_count : TELEMETRY_MAX_TASKS - 1;
+        memmove(&s->tasks[pos + 1], &s->tasks[pos], (last - pos) * sizeof(t));
+        s->tasks[pos] = t;
+        if (s->task_count < TELEMETRY_MAX_TASKS) s->task_count++;
+    }
+
+    s_prev_count = 0;
+    for (UBaseType_t i = 0; i < n && s_prev_count < TELEMETRY_PREV_LEN; i++) {
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        s_prev[s_prev_count++] = (prev_runtime_t){ st[i].xHandle, st[i].ulRunTimeCounter };
+#else
+        s_prev[s_prev_count++] = (prev_runtime_t){ st[i].xHandle, 0 };
+#endif
+    }
+    s_prev_total = total;
+    free(st);
+}
+#else
+static void sample_tasks(telemetry_sample_t *s) {
+    (void)s;    // needs CONFIG_FREERTOS_USE_TRACE_FACILITY
+}
+#endif
+
+void telemetry_sample_now(void) {
+    static telemetry_sample_t s;    // too big for the dispatcher stack
+    memset(&s, 0, sizeof(s));
+    s.uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    s.heap_free = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    s.heap_min = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    s.heap_largest = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    s.heap_frag_pct = telemetry_frag_pct(s.heap_free, s.heap_largest);
+
+    neopixel_driver_stats_t led;
+    neopixel_get_stats(&led);
+    s.led_frames = led.frames;
+    s.led_errors = led.errors;
+    s.led_max_show_us = led.max_show_us;
+
+    alarm_stats_t al;
+    alarm_manager_get_stats(&al);
+    s.alarm_fired = al.fired;
+    s.alarm_missed = al.missed;
+    s.dispatch_dropped = event_dispatcher_dropped();
+
+    sample_tasks(&s);
+
+    taskENTER_CRITICAL(&s_lock);
+    s_ring[s_head] = s;
+    s_head = (s_head + 1) % TELEMETRY_RING_LEN;
+    if (s_count < TELEMETRY_RING_LEN) s_count++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static void sample_cb(void *arg) {
+    (void)arg;
+    telemetry_sample_now();
+#if CONFIG_TELEMETRY_LOG_SAMPLES
+    telemetry_log_dump();
+#endif
+}
+
+bool telemetry_start(uint32_t period_s) {
+    if (s_timer != DISPATCH_TIMER_INVALID) return true;
+    if (period_s == 0) period_s = CONFIG_TELEMETRY_PERIOD_S;
+    if (!event_dispatcher_init()) return false;
+    s_timer = event_dispatcher_timer_create(sample_cb, NULL, "telemetry");
+    if (s_timer == DISPATCH_TIMER_INVALID) return false;
+#if !CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    ESP_LOGW(TAG, "FreeRTOS run-time stats disabled; per-task CPU will read 0");
+#endif
+    // First sample right away so the CPU baseline exists
+    return event_dispatcher_timer_start(s_timer, 0, period_s * 1000U);
+}
+
+int telemetry_count(void) {
+    return s_count;
+}
+
+bool telemetry_get(int age, telemetry_sample_t *out) {
+    if (!out || age < 0) return false;
+    bool ok = false;
+    taskENTER_CRITICAL(&s_lock);
+    if (age < s_count) {
+        *out = s_ring[(s_head - 1 - age + TELEMETRY_RING_LEN) % TELEMETRY_RING_LEN];
+        ok = true;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return ok;
+}
+
+void telemetry_log_dump(void) {
+    static telemetry_sample_t s;
+    if (!telemetry_get(0, &s)) {
+        ESP_LOGI(TAG, "no samples yet");
+        return;
+    }
+    ESP_LOGI(TAG, "uptime %us  heap free %u min %u largest %u (frag %u%%)",
+             (unsigned)s.uptime_s, (unsigned)s.heap_free, (unsigned)s.heap_min,
+             (unsigned)s.heap_largest, (unsigned)s.heap_frag_pct);
+    ESP_LOGI(TAG, "led frames %u errors %u max show %u us | alarms fired %u missed %u | dispatch dropped %u",
+             (unsigned)s.led_frames, (unsigned)s.led_errors, (unsigned)s.led_max_show_us,
+             (unsigned)s.alarm_fired, (unsigned)s.alarm_missed, (unsigned)s.dispatch_dropped);
+    ESP_LOGI(TAG, "%-16s %6s %10s", "task", "cpu%", "stack_free");
+    for (int i = 0; i < s.task_count; i++) {
+        ESP_LOGI(TAG, "%-16s %3u.%u %10u", s.tasks[i].name,
+                 s.tasks[i].cpu_permille / 10, s.tasks[i].cpu_permille % 10,
+                 (unsigned)s.tasks[i].stack_free);
+    }
+    if (s.tasks_total > s.task_count) {
+        ESP_LOGI(TAG, "(%u more tasks with more stack headroom)",
+                 (unsigned)(s.tasks_total - s.task_count));
+    }
+
+    telemetry_sample_t old;
+    if (telemetry_get(s_count - 1, &old) && s_count > 1) {
+        ESP_LOGI(TAG, "heap over %u samples: free %d B, largest %d B",
+                 (unsigned)s_count, (int)(s.heap_free - old.heap_free),
+                 (int)(s.heap_largest - old.heap_largest));
+    }
+}
+
+int telemetry_snapshot_json(char *buf, size_t len) {
+    static telemetry_sample_t snap[TELEMETRY_RING_LEN];
+    int n = 0;
+    while (n < TELEMETRY_RING_LEN && telemetry_get(n, &snap[n])) n++;
+    return telemetry_format_json(buf, len, snap, n);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Periodic runtime telemetry: per-task CPU share and stack headroom, heap and
+ * fragmentation, LED driver / alarm / dispatcher counters. Samples go into a
+ * fixed ring (no allocation after start) and can be dumped to the log or
+ * served as a JSON snapshot. */
+
+#define TELEMETRY_MAX_TASKS   16
+#define TELEMETRY_NAME_LEN    16
+
+typedef struct {
+    char name[TELEMETRY_NAME_LEN];
+    uint16_t cpu_permille;      // share of total CPU time since the previous sample
+    uint16_t stack_free;        // high-water headroom, bytes
+} telemetry_task_t;
+
+typedef struct {
+    uint32_t uptime_s;
+    uint32_t heap_free;
+    uint32_t heap_min;          // lowest free heap since boot
+    uint32_t heap_largest;      // largest allocatable block
+    uint8_t  heap_frag_pct;     // 100 - largest * 100 / free
+    uint8_t  task_count;        // entries in tasks[]
+    uint16_t tasks_total;       // tasks that existed (may exceed TELEMETRY_MAX_TASKS)
+    uint32_t led_frames;
+    uint32_t led_errors;
+    uint32_t led_max_show_us;
+    uint32_t alarm_fired;
+    uint32_t alarm_missed;
+    uint32_t dispatch_dropped;
+    telemetry_task_t tasks[TELEMETRY_MAX_TASKS];
+} telemetry_sample_t;
+
+/**
+ * Start periodic sampling on the event dispatcher.
+ * @param period_s  0 = CONFIG_TELEMETRY_PERIOD_S
+ */
+bool telemetry_start(uint32_t period_s);
+
+/** Take a sample now (also done by the periodic timer) */
+void telemetry_sample_now(void);
+
+/** Number of samples held in the ring */
+int telemetry_count(void);
+
+/**
+ * Copy a sample out of the ring (the compact binary form).
+ * @param age  0 = latest, 1 = the one before, ...
+ */
+bool telemetry_get(int age, telemetry_sample_t *out);
+
+/** Log the latest sample as a task table plus the heap trend over the ring */
+void telemetry_log_dump(void);
+
+/**
+ * JSON snapshot: the latest sample in full plus a heap history row per
+ * older sample.
+ * @return length written (excluding NUL), or -1 if it did not fit
+ */
+int telemetry_snapshot_json(char *buf, size_t len);
+
+/* Pure formatter behind telemetry_snapshot_json(); samples[0] is the latest */
+int telemetry_format_json(char *buf, size_t len, const telemetry_sample_t *samples, int n);
+
+/* 100 - largest * 100 / free, clamped to 0..100 */
+uint8_t telemetry_frag_pct(uint32_t free_bytes, uint32_t largest_block);
+
+#ifdef __cplusplus
+}
+#endif
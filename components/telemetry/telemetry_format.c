@@ -0,0 +1,58 @@
+#include "telemetry.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+/* Bounded appender: remembers overflow instead of truncating silently */
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t pos;
+    bool overflow;
+} out_t;
+
+static void out_printf(out_t *o, const char *fmt, ...) {
+    if (o->overflow) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(o->buf + o->pos, o->len - o->pos, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= o->len - o->pos) o->overflow = true;
+    else o->pos += (size_t)n;
+}
+
+uint8_t telemetry_frag_pct(uint32_t free_bytes, uint32_t largest_block) {
+    if (free_bytes == 0 || largest_block >= free_bytes) return 0;
+    return (uint8_t)(100U - (uint32_t)((uint64_t)largest_block * 100U / free_bytes));
+}
+
+int telemetry_format_json(char *buf, size_t len, const telemetry_sample_t *samples, int n) {
+    out_t o = { buf, len, 0, len == 0 };
+    if (n <= 0) {
+        out_printf(&o, "{}");
+        return o.overflow ? -1 : (int)o.pos;
+    }
+    const telemetry_sample_t *s = &samples[0];
+    out_printf(&o, "{\"uptime\":%u,\"heap\":{\"free\":%u,\"min\":%u,\"largest\":%u,\"frag\":%u},"
+                   "\"led\":{\"frames\":%u,\"errors\":%u,\"max_show_us\":%u},"
+                   "\"alarm\":{\"fired\":%u,\"missed\":%u},\"dispatch_dropped\":%u,"
+                   "\"tasks_total\":%u,\"tasks\":[",
+               (unsigned)s->uptime_s, (unsigned)s->heap_free, (unsigned)s->heap_min,
+               (unsigned)s->heap_largest, (unsigned)s->heap_frag_pct,
+               (unsigned)s->led_frames, (unsigned)s->led_errors, (unsigned)s->led_max_show_us,
+               (unsigned)s->alarm_fired, (unsigned)s->alarm_missed,
+               (unsigned)s->dispatch_dropped, (unsigned)s->tasks_total);
+    // [name, cpu per mille, stack headroom bytes]; names are FreeRTOS task names (no escaping needed)
+    for (int i = 0; i < s->task_count && i < TELEMETRY_MAX_TASKS; i++) {
+        out_printf(&o, "%s[\"%.*s\",%u,%u]", i ? "," : "", TELEMETRY_NAME_LEN,
+                   s->tasks[i].name, (unsigned)s->tasks[i].cpu_permille,
+                   (unsigned)s->tasks[i].stack_free);
+    }
+    // [uptime, heap free, largest block] for older samples, newest first
+    out_printf(&o, "],\"history\":[");
+    for (int i = 1; i < n; i++) {
+        out_printf(&o, "%s[%u,%u,%u]", i > 1 ? "," : "", (unsigned)samples[i].uptime_s,
+                   (unsigned)samples[i].heap_free, (unsigned)samples[i].heap_largest);
+    }
+    out_printf(&o, "]}");
+    return o.overflow ? -1 : (int)o.pos;
+}
@@ -1,33 +1,214 @@
-
 #include "time_manager.h"
+#include "time_tz.h"
+#include "storage_manager.h"
+#include "trace.h"
 #include "esp_sntp.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_private/esp_clk.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "time_manager";
+
+#define TIME_VALID_EPOCH   1700000000     // anything earlier is an unset clock
+#define TIME_RTC_MAGIC     0x54494D45u    // "TIME"
+#define TIME_NVS_NS        "time"
+#define TIME_NVS_KEY       "last_sync"
+#define TIME_SLEW_POLL_MS  1000           // how often to check a smooth sync for completion
+
+/* Survives soft resets (panic, WDT, esp_restart) but not power loss */
+typedef struct {
+    uint32_t magic;
+    int64_t epoch_us;       // wall clock at the reference point
+    uint64_t rtc_us;        // RTC counter at the same point
+    uint32_t check;         // magic ^ low/high words, guards against garbage
+} time_rtc_record_t;
+
+static RTC_NOINIT_ATTR time_rtc_record_t s_rtc_record;
 
 static time_sync_cb_t s_cb = NULL;
 static void *s_user_data = NULL;
+static time_quality_t s_quality = TIME_QUALITY_NONE;
+static TimerHandle_t s_slew_timer = NULL;
 
-static void time_sync_notification_cb(struct timeval *tv) {
+static tz_cache_t s_tz_cache;
+static portMUX_TYPE s_tz_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t rtc_record_check(const time_rtc_record_t *r) {
+    return r->magic ^ (uint32_t)r->epoch_us ^ (uint32_t)(r->epoch_us >> 32) ^
+           (uint32_t)r->rtc_us ^ (uint32_t)(r->rtc_us >> 32);
+}
+
+static bool rtc_record_valid(void) {
+    return s_rtc_record.magic == TIME_RTC_MAGIC &&
+           s_rtc_record.check == rtc_record_check(&s_rtc_record);
+}
+
+/* Remember "wall clock X at RTC counter Y" in RTC memory and X in NVS */
+static void save_reference(bool to_nvs) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    s_rtc_record.magic = TIME_RTC_MAGIC;
+    s_rtc_record.epoch_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    s_rtc_record.rtc_us = esp_clk_rtc_time();
+    s_rtc_record.check = rtc_record_check(&s_rtc_record);
+    if (to_nvs) {
+        int64_t epoch = tv.tv_sec;
+        storage_manager_set_blob_ns(TIME_NVS_NS, TIME_NVS_KEY, &epoch, sizeof(epoch));
+    }
+}
+
+static void shutdown_handler(void) {
+    // Keep the NVS copy fresh across a restart; the RTC record covers the rest
+    if (s_quality >= TIME_QUALITY_RTC) save_reference(true);
+}
+
+/* The clock now holds SNTP time: only called once any smooth adjustment is done */
+static void sync_completed(void) {
+    if (s_quality != TIME_QUALITY_SYNCED) {
+        ESP_LOGI(TAG, "SNTP sync (clock was %s)",
+                 s_quality == TIME_QUALITY_NONE ? "unset" : "estimated");
+    }
+    s_quality = TIME_QUALITY_SYNCED;
+    save_reference(true);
     if (s_cb) s_cb(s_user_data);
 }
 
+static void slew_timer_cb(TimerHandle_t xTimer) {
+    if (sntp_get_sync_status() == SNTP_SYNC_STATUS_IN_PROGRESS) return;
+    xTimerStop(xTimer, 0);
+    sync_completed();
+}
+
+static void time_sync_notification_cb(struct timeval *tv) {
+    TRACE_INSTANT("sntp_sync", s_quality);
+    // In smooth mode the callback comes when adjtime() starts, not when the clock
+    // gets there: keep the current quality until the slew is over
+    if (sntp_get_sync_status() != SNTP_SYNC_STATUS_IN_PROGRESS) {
+        sync_completed();
+        return;
+    }
+    ESP_LOGI(TAG, "SNTP sync started, slewing the clock");
+    if (!s_slew_timer) {
+        s_slew_timer = xTimerCreate("time_slew", pdMS_TO_TICKS(TIME_SLEW_POLL_MS),
+                                    pdTRUE, NULL, slew_timer_cb);
+    }
+    if (s_slew_timer && xTimerStart(s_slew_timer, 0) == pdPASS) return;
+    sync_completed();   // cannot poll: better early than never
+}
+
+static void set_clock_us(int64_t epoch_us) {
+    struct timeval tv = {
+        .tv_sec = (time_t)(epoch_us / 1000000),
+        .tv_usec = (suseconds_t)(epoch_us % 1000000)
+    };
+    settimeofday(&tv, NULL);
+}
+
+time_quality_t time_manager_restore(void) {
+    esp_register_shutdown_handler(shutdown_handler);
+
+    time_t now = time(NULL);
+    if (now >= TIME_VALID_EPOCH) {
+        // The IDF keeps system time across soft resets by itself
+        s_quality = TIME_QUALITY_RTC;
+    } else if (esp_reset_reason() != ESP_RST_POWERON && rtc_record_valid()) {
+        uint64_t rtc_now = esp_clk_rtc_time();
+        int64_t elapsed = (int64_t)(rtc_now - s_rtc_record.rtc_us);
+        if (rtc_now >= s_rtc_record.rtc_us) {
+            set_clock_us(s_rtc_record.epoch_us + elapsed);
+            s_quality = TIME_QUALITY_RTC;
+        }
+    }
+
+    if (s_quality == TIME_QUALITY_NONE) {
+        int64_t epoch = 0;
+        size_t len = 0;
+        if (storage_manager_get_blob_ns(TIME_NVS_NS, TIME_NVS_KEY, &epoch, sizeof(epoch), &len) &&
+            len == sizeof(epoch) && epoch >= TIME_VALID_EPOCH) {
+            set_clock_us(epoch * 1000000);
+            s_quality = TIME_QUALITY_STALE;
+        }
+    }
+
+    if (s_quality != TIME_QUALITY_NONE) {
+        save_reference(false);   // new RTC reference for the next soft reset
+        char buf[32];
+        time_t t = time(NULL);
+        struct tm tm;
+        localtime_r(&t, &tm);
+        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+        ESP_LOGI(TAG, "Restored %s clock: %s",
+                 s_quality == TIME_QUALITY_RTC ? "RTC" : "stale NVS", buf);
+    }
+    return s_quality;
+}
+
+time_quality_t time_manager_get_quality(void) {
+    return s_quality;
+}
+
+void time_manager_set_timezone(const char *tz) {
+    setenv("TZ", tz, 1);
+    tzset();
+    taskENTER_CRITICAL(&s_tz_lock);
+    tz_cache_invalidate(&s_tz_cache);
+    taskEXIT_CRITICAL(&s_tz_lock);
+}
+
 void time_manager_init(const char *ntp_server, const char *tz,
                        time_sync_cb_t cb, void *user_data) {
     s_cb = cb;
     s_user_data = user_data;
 
+    // With an RTC-carried clock already running, slew into the SNTP time instead
+    // of stepping (the IDF still steps when the error exceeds ~35 minutes). A
+    // stale NVS clock is off by the whole power-off time: step it.
+    sntp_set_sync_mode(s_quality >= TIME_QUALITY_RTC ? SNTP_SYNC_MODE_SMOOTH
+                                                     : SNTP_SYNC_MODE_IMMED);
     esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
     esp_sntp_setservername(0, (char*)ntp_server);
     sntp_set_time_sync_notification_cb(time_sync_notification_cb);
     esp_sntp_init();
 
-    setenv("TZ", tz, 1);
-    tzset();
+    time_manager_set_timezone(tz);
 }
 
 bool time_manager_get_local_time(struct tm *out) {
     time_t now; time(&now);
     if (now < 1000) return false;
-    localtime_r(&now, out);
+
+    tz_cache_t c;
+    taskENTER_CRITICAL(&s_tz_lock);
+    c = s_tz_cache;
+    taskEXIT_CRITICAL(&s_tz_lock);
+
+    if (c.valid && now >= c.valid_from && now < c.valid_until) {
+        tz_break_down(now, c.offset_s, c.isdst, out);
+        return true;
+    }
+    // Slow path (once per DST period or clock step): refresh outside the lock
+    tz_cache_localtime(&c, now, out);
+    taskENTER_CRITICAL(&s_tz_lock);
+    s_tz_cache = c;
+    taskEXIT_CRITICAL(&s_tz_lock);
     return true;
 }
+
+int32_t time_manager_get_utc_offset(void) {
+    struct tm tm;
+    if (!time_manager_get_local_time(&tm)) return tz_utc_offset_at(time(NULL), NULL);
+    taskENTER_CRITICAL(&s_tz_lock);
+    int32_t off = s_tz_cache.offset_s;
+    taskEXIT_CRITICAL(&s_tz_lock);
+    return off;
+}
+
+time_t time_manager_next_occurrence(time_t after, int wday, int hour, int minute, int second) {
+    return tz_next_local_occurrence(after, wday, hour, minute, second);
+}
@@ -1,10 +1,51 @@
-
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 typedef void (*time_sync_cb_t)(void *user_data);
 
+/* How trustworthy the system clock currently is */
+typedef enum {
+    TIME_QUALITY_NONE,      // no idea; local time unavailable
+    TIME_QUALITY_STALE,     // restored from NVS after power loss: off by the power-off duration
+    TIME_QUALITY_RTC,       // carried across a soft reset by the RTC: off by RTC drift only
+    TIME_QUALITY_SYNCED     // SNTP synced this boot
+} time_quality_t;
+
+/**
+ * Fast start: restore an estimated clock before Wi-Fi/SNTP are up.
+ * Uses the RTC-memory record (soft resets) or the last time saved in NVS
+ * (power cycles). Call after storage_manager_init(), before alarms.
+ * When SNTP later syncs, the clock is slewed rather than stepped if the
+ * error is small.
+ * @return quality of the restored clock
+ */
+time_quality_t time_manager_restore(void);
+
+time_quality_t time_manager_get_quality(void);
+
 void time_manager_init(const char *ntp_server, const char *tz,
                        time_sync_cb_t cb, void *user_data);
+
+/** Set the POSIX TZ rule (also done by time_manager_init) and drop the offset cache */
+void time_manager_set_timezone(const char *tz);
+
+/**
+ * Local time. Uses a cached UTC offset that stays valid until the next DST
+ * transition, so the common path is an addition plus date arithmetic.
+ * @return false until the clock has been set
+ */
 bool time_manager_get_local_time(struct tm *out);
+
+/** Current local-minus-UTC offset in seconds */
+int32_t time_manager_get_utc_offset(void);
+
+/**
+ * Next instant strictly after `after` when the local clock reads
+ * hour:minute:second on weekday `wday` (0 = Sunday, -1 = every day).
+ * Spring-forward gaps fire shifted forward by the gap; fall-back overlaps
+ * fire once (first occurrence). See tz_next_local_occurrence().
+ * @return (time_t)-1 on invalid arguments
+ */
+time_t time_manager_next_occurrence(time_t after, int wday, int hour, int minute, int second);
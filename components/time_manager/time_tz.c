@@ -0,0 +1,134 @@
+#include "time_tz.h"
+
+#define DAY_S               86400
+#define TZ_SCAN_STEP_S      (6 * 3600)          // transitions are months apart
+#define TZ_HORIZON_S        (400 * DAY_S)       // look ahead a bit over a year
+
+/* Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm) */
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int *y, unsigned *m, unsigned *d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = (int)((int64_t)yoe + era * 400 + (*m <= 2));
+}
+
+/* Seconds since the epoch of a broken-down time read as if it were UTC */
+static int64_t tm_as_utc(const struct tm *tm) {
+    int64_t days = days_from_civil(tm->tm_year + 1900, (unsigned)tm->tm_mon + 1, (unsigned)tm->tm_mday);
+    return days * DAY_S + tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec;
+}
+
+int32_t tz_utc_offset_at(time_t t, int *isdst) {
+    struct tm lt;
+    localtime_r(&t, &lt);
+    if (isdst) *isdst = lt.tm_isdst > 0;
+    return (int32_t)(tm_as_utc(&lt) - (int64_t)t);
+}
+
+time_t tz_next_transition(time_t from, time_t horizon_s) {
+    const int32_t off0 = tz_utc_offset_at(from, NULL);
+    time_t lo = from;
+    for (time_t step = from + TZ_SCAN_STEP_S; step <= from + horizon_s; step += TZ_SCAN_STEP_S) {
+        if (tz_utc_offset_at(step, NULL) != off0) {
+            // Offset changes somewhere in (lo, step]: bisect to the exact second
+            time_t hi = step;
+            while (hi - lo > 1) {
+                time_t mid = lo + (hi - lo) / 2;
+                if (tz_utc_offset_at(mid, NULL) == off0) lo = mid;
+                else hi = mid;
+            }
+            return hi;
+        }
+        lo = step;
+    }
+    return (time_t)-1;
+}
+
+void tz_cache_invalidate(tz_cache_t *c) {
+    c->valid = false;
+}
+
+void tz_break_down(time_t t, int32_t offset_s, int isdst, struct tm *out) {
+    int64_t local = (int64_t)t + offset_s;
+    int64_t days = local / DAY_S;
+    int64_t secs = local % DAY_S;
+    if (secs < 0) { secs += DAY_S; days--; }
+
+    int y; unsigned m, d;
+    civil_from_days(days, &y, &m, &d);
+    out->tm_year = y - 1900;
+    out->tm_mon = (int)m - 1;
+    out->tm_mday = (int)d;
+    out->tm_hour = (int)(secs / 3600);
+    out->tm_min = (int)((secs / 60) % 60);
+    out->tm_sec = (int)(secs % 60);
+    out->tm_wday = (int)((days % 7 + 11) % 7);   // 1970-01-01 was a Thursday
+    out->tm_yday = (int)(days - days_from_civil(y, 1, 1));
+    out->tm_isdst = isdst;
+}
+
+void tz_cache_localtime(tz_cache_t *c, time_t now, struct tm *out) {
+    if (!c->valid || now < c->valid_from || now >= c->valid_until) {
+        c->offset_s = tz_utc_offset_at(now, &c->isdst);
+        time_t next = tz_next_transition(now, TZ_HORIZON_S);
+        c->valid_from = now;
+        c->valid_until = (next == (time_t)-1) ? now + TZ_HORIZON_S : next;
+        c->valid = true;
+    }
+    tz_break_down(now, c->offset_s, c->isdst, out);
+}
+
+time_t tz_next_local_occurrence(time_t after, int wday, int hour, int minute, int second) {
+    if (wday < -1 || wday > 6 || hour < 0 || hour > 23 ||
+        minute < 0 || minute > 59 || second < 0 || second > 59) {
+        return (time_t)-1;
+    }
+
+    struct tm lt;
+    tz_break_down(after, tz_utc_offset_at(after, NULL), 0, &lt);
+    const int64_t today = days_from_civil(lt.tm_year + 1900, (unsigned)lt.tm_mon + 1, (unsigned)lt.tm_mday);
+    const int wall_s = hour * 3600 + minute * 60 + second;
+
+    // Start one day back: "after" may be early on a local day whose target
+    // already maps to a later UTC instant. Eight days covers a full week.
+    for (int d = -1; d <= 8; d++) {
+        const int64_t day = today + d;
+        if (wday >= 0 && (int)((day % 7 + 11) % 7) != wday) continue;
+
+        const int64_t wall = day * DAY_S + wall_s;     // local wall time as pseudo-UTC
+        // Offsets on either side of any transition near this wall time
+        const int32_t off_before = tz_utc_offset_at((time_t)(wall - DAY_S), NULL);
+        const int32_t off_after = tz_utc_offset_at((time_t)(wall + DAY_S), NULL);
+        const time_t t_before = (time_t)(wall - off_before);
+        const time_t t_after = (time_t)(wall - off_after);
+        const bool ok_before = tz_utc_offset_at(t_before, NULL) == off_before;
+        const bool ok_after = tz_utc_offset_at(t_after, NULL) == off_after;
+
+        time_t cand[2];
+        int n = 0;
+        if (ok_before) cand[n++] = t_before;
+        if (ok_after && (!ok_before || t_after != t_before)) cand[n++] = t_after;
+        if (n == 0) cand[n++] = t_before;   // gap: use the pre-transition offset
+
+        // Overlap: keep only the earlier instant so the alarm fires once
+        time_t best = cand[0];
+        if (n == 2 && cand[1] < best) best = cand[1];
+        if (best > after) return best;
+        // The earlier occurrence has passed; never return the repeated one
+    }
+    return (time_t)-1;
+}
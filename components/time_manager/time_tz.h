@@ -0,0 +1,61 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UTC-offset cache and DST-aware wall-clock arithmetic.
+ * Only depends on libc (localtime_r with the current TZ), so it can be
+ * exercised on the host with any POSIX TZ string.
+ */
+
+typedef struct {
+    time_t valid_from;      // offset below is valid for [valid_from, valid_until)
+    time_t valid_until;     // next DST transition (or a horizon if there is none)
+    int32_t offset_s;       // local - UTC, seconds
+    int isdst;
+    bool valid;
+} tz_cache_t;
+
+/** Local-minus-UTC offset in effect at instant t (slow path: localtime_r) */
+int32_t tz_utc_offset_at(time_t t, int *isdst);
+
+/**
+ * First instant in (from, from + horizon_s] whose UTC offset differs from the
+ * offset at `from`, or (time_t)-1 if none.
+ */
+time_t tz_next_transition(time_t from, time_t horizon_s);
+
+/** Drop the cache (after TZ changes) */
+void tz_cache_invalidate(tz_cache_t *c);
+
+/**
+ * Local time for `now`. Inside the cached window this is a single addition
+ * plus civil-date arithmetic; the cache is refreshed when `now` leaves it.
+ */
+void tz_cache_localtime(tz_cache_t *c, time_t now, struct tm *out);
+
+/** UTC instant -> broken-down time at a fixed offset (no TZ lookup) */
+void tz_break_down(time_t t, int32_t offset_s, int isdst, struct tm *out);
+
+/**
+ * Next instant strictly after `after` at which the local wall clock reads
+ * hour:minute:second on weekday `wday` (0 = Sunday, -1 = any day).
+ *
+ * DST handling:
+ *  - gap (wall time does not exist, e.g. 02:30 on spring-forward day): the
+ *    time is interpreted with the offset before the gap, i.e. it fires shifted
+ *    forward by the gap length (02:30 -> 03:30), as RFC 5545 specifies;
+ *  - overlap (wall time happens twice on fall-back day): only the first
+ *    occurrence is returned, so an alarm fires once.
+ * @return (time_t)-1 if the arguments are invalid
+ */
+time_t tz_next_local_occurrence(time_t after, int wday, int hour, int minute, int second);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,114 @@
+#include "trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if CONFIG_TRACE_ENABLE
+
+_Static_assert((CONFIG_TRACE_RING_LEN & (CONFIG_TRACE_RING_LEN - 1)) == 0,
+               "CONFIG_TRACE_RING_LEN must be a power of two");
+
+#define TRACE_TID_ISR       0
+#define TRACE_TID_EXITED    999     // tasks deleted since they recorded
+#define TRACE_LINE_LEN      192
+
+static trace_slot_t s_slots[CONFIG_TRACE_RING_LEN];
+/* Statically initialized so events can be recorded from the first instruction */
+static trace_ring_t s_ring = { .slots = s_slots, .mask = CONFIG_TRACE_RING_LEN - 1 };
+
+typedef struct {
+    trace_write_fn_t write;
+    void *ctx;
+    TaskStatus_t *tasks;
+    UBaseType_t task_count;
+    bool first;
+    char line[TRACE_LINE_LEN];      // [0] is the separating comma
+} dump_t;
+
+void IRAM_ATTR trace_record(const char *name, trace_phase_t phase, uint32_t arg) {
+    const bool isr = xPortInIsrContext();
+    const trace_event_t ev = {
+        .ts_us = esp_timer_get_time(),
+        .name = name,
+        .task = isr ? NULL : xTaskGetCurrentTaskHandle(),
+        .arg = arg,
+        .phase = (uint8_t)phase,
+        .core = (uint8_t)xPortGetCoreID(),
+    };
+    trace_ring_push(&s_ring, &ev);
+}
+
+void trace_clear(void) {
+    trace_ring_clear(&s_ring);
+}
+
+/* One array element from d->line + 1 (len from a trace_format_* call) */
+static bool put(dump_t *d, int len) {
+    if (len < 0) return true;       // cannot happen with static names; skip rather than fail
+    const bool first = d->first;
+    d->first = false;
+    return first ? d->write(d->line + 1, (size_t)len, d->ctx)
+                 : d->write(d->line, (size_t)len + 1, d->ctx);
+}
+
+static uint32_t tid_of(const dump_t *d, const void *task) {
+    if (!task) return TRACE_TID_ISR;
+    for (UBaseType_t i = 0; i < d->task_count; i++) {
+        if (d->tasks[i].xHandle == task) return (uint32_t)i + 1;
+    }
+    return TRACE_TID_EXITED;
+}
+
+static bool dump_event(const trace_event_t *ev, void *ctx) {
+    dump_t *d = ctx;
+    return put(d, trace_format_event(d->line + 1, sizeof(d->line) - 1, ev, tid_of(d, ev->task)));
+}
+
+bool trace_dump(trace_write_fn_t write, void *ctx) {
+    static dump_t d;                // too big for the httpd stack
+    d = (dump_t){ .write = write, .ctx = ctx, .first = true };
+    d.line[0] = ',';
+
+    // Thread names come from the live task list: tids are positions in it
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    UBaseType_t n = uxTaskGetNumberOfTasks() + 2;   // room for tasks created meanwhile
+    d.tasks = malloc(n * sizeof(TaskStatus_t));
+    if (d.tasks) d.task_count = uxTaskGetSystemState(d.tasks, n, NULL);
+#endif
+    int len = snprintf(d.line, sizeof(d.line),
+                       "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%u},\"traceEvents\":[",
+                       (unsigned)trace_ring_dropped(&s_ring));
+    bool ok = write(d.line, (size_t)len, ctx);
+    d.line[0] = ',';
+    ok = ok && put(&d, trace_format_thread(d.line + 1, sizeof(d.line) - 1, TRACE_TID_ISR, "ISR"));
+    for (UBaseType_t i = 0; ok && i < d.task_count; i++) {
+        ok = put(&d, trace_format_thread(d.line + 1, sizeof(d.line) - 1, (uint32_t)i + 1,
+                                         d.tasks[i].pcTaskName));
+    }
+    ok = ok && put(&d, trace_format_thread(d.line + 1, sizeof(d.line) - 1, TRACE_TID_EXITED,
+                                           "(exited)"));
+    ok = ok && trace_ring_read(&s_ring, dump_event, &d);
+    ok = ok && write("]}", 2, ctx);
+    free(d.tasks);
+    return ok;
+}
+
+#else
+
+void trace_record(const char *name, trace_phase_t phase, uint32_t arg) {
+    (void)name; (void)phase; (void)arg;
+}
+
+void trace_clear(void) {
+}
+
+bool trace_dump(trace_write_fn_t write, void *ctx) {
+    (void)write; (void)ctx;
+    return false;
+}
+
+#endif
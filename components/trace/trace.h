@@ -0,0 +1,56 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "trace_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event trace for end-to-end latencies: begin/end/instant events with
+ * microsecond timestamps in a fixed lock-free ring (trace_ring.h), safe to
+ * record from ISRs, timer callbacks and tasks. Dumped as Chrome trace JSON
+ * (chrome://tracing, ui.perfetto.dev; tools/trace_latency.py).
+ * Names must be string literals: only the pointer is stored. */
+
+typedef enum {
+    TRACE_PH_BEGIN = 'B',
+    TRACE_PH_END = 'E',
+    TRACE_PH_INSTANT = 'i',
+} trace_phase_t;
+
+#if CONFIG_TRACE_ENABLE
+#define TRACE_BEGIN(name, arg)    trace_record((name), TRACE_PH_BEGIN, (uint32_t)(arg))
+#define TRACE_END(name, arg)      trace_record((name), TRACE_PH_END, (uint32_t)(arg))
+#define TRACE_INSTANT(name, arg)  trace_record((name), TRACE_PH_INSTANT, (uint32_t)(arg))
+#else
+#define TRACE_BEGIN(name, arg)    ((void)0)
+#define TRACE_END(name, arg)      ((void)0)
+#define TRACE_INSTANT(name, arg)  ((void)0)
+#endif
+
+/** Stamp and store one event; the ring is static, so this works from boot */
+void trace_record(const char *name, trace_phase_t phase, uint32_t arg);
+
+/** Forget the events recorded so far, e.g. right before a measurement */
+void trace_clear(void);
+
+typedef bool (*trace_write_fn_t)(const char *data, size_t len, void *ctx);
+
+/**
+ * Stream the ring as Chrome trace JSON through write(), a few hundred bytes
+ * at a time. Not reentrant (one dump at a time).
+ * @return false if write() failed or tracing is disabled
+ */
+bool trace_dump(trace_write_fn_t write, void *ctx);
+
+/* Pure formatters behind trace_dump(); each returns the length written
+ * (excluding NUL), or -1 if it did not fit */
+int trace_format_thread(char *buf, size_t len, uint32_t tid, const char *name);
+int trace_format_event(char *buf, size_t len, const trace_event_t *ev, uint32_t tid);
+
+#ifdef __cplusplus
+}
+#endif
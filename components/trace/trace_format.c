@@ -0,0 +1,20 @@
+#include "trace.h"
+#include <stdio.h>
+
+static int fit(int n, size_t len) {
+    return n < 0 || (size_t)n >= len ? -1 : n;
+}
+
+int trace_format_thread(char *buf, size_t len, uint32_t tid, const char *name) {
+    return fit(snprintf(buf, len, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                                  "\"args\":{\"name\":\"%s\"}}", (unsigned)tid, name), len);
+}
+
+/* Chrome wants timestamps in us; instants are scoped to their thread */
+int trace_format_event(char *buf, size_t len, const trace_event_t *ev, uint32_t tid) {
+    return fit(snprintf(buf, len, "{\"name\":\"%s\",\"ph\":\"%c\",%s\"ts\":%lld,\"pid\":1,"
+                                  "\"tid\":%u,\"args\":{\"arg\":%u,\"core\":%u}}",
+                        ev->name, (char)ev->phase, ev->phase == TRACE_PH_INSTANT ? "\"s\":\"t\"," : "",
+                        (long long)ev->ts_us, (unsigned)tid, (unsigned)ev->arg, (unsigned)ev->core),
+               len);
+}
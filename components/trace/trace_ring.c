@@ -0,0 +1,42 @@
+#include "trace_ring.h"
+#include <string.h>
+
+void trace_ring_init(trace_ring_t *r, trace_slot_t *slots, uint32_t len) {
+    memset(slots, 0, sizeof(*slots) * len);
+    r->slots = slots;
+    r->mask = len - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->start, 0);
+}
+
+/* Oldest index still in the ring, given the current head */
+static uint32_t first_index(trace_ring_t *r, uint32_t head) {
+    const uint32_t start = atomic_load_explicit(&r->start, memory_order_relaxed);
+    const uint32_t len = r->mask + 1;
+    return head - start > len ? head - len : start;
+}
+
+bool trace_ring_read(trace_ring_t *r, bool (*visit)(const trace_event_t *ev, void *ctx),
+                     void *ctx) {
+    const uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    for (uint32_t n = first_index(r, head); n != head; n++) {
+        trace_slot_t *s = &r->slots[n & r->mask];
+        const uint32_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (seq != n + 1) continue;         // not published yet, or already lapped
+        const trace_event_t ev = s->ev;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&s->seq, memory_order_relaxed) != seq) continue;
+        if (!visit(&ev, ctx)) return false;
+    }
+    return true;
+}
+
+uint32_t trace_ring_dropped(trace_ring_t *r) {
+    const uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    return first_index(r, head) - atomic_load_explicit(&r->start, memory_order_relaxed);
+}
+
+void trace_ring_clear(trace_ring_t *r) {
+    atomic_store_explicit(&r->start, atomic_load_explicit(&r->head, memory_order_relaxed),
+                          memory_order_relaxed);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Multi-writer, lock-free event ring. Writers claim a slot with one atomic
+ * increment and publish it with a release store of its sequence number, so
+ * recording never blocks or disables interrupts and works from ISRs on either
+ * core. The oldest events are overwritten. Readers copy a slot and re-check
+ * its sequence, dropping slots that were being (re)written meanwhile. Only a writer
+ * lapped by the whole ring in the middle of its own few stores could tear.
+ */
+
+typedef struct {
+    int64_t ts_us;
+    const char *name;           // static string; not copied
+    const void *task;           // recording task, NULL in ISR context
+    uint32_t arg;
+    uint8_t phase;              // trace_phase_t
+    uint8_t core;
+} trace_event_t;
+
+typedef struct {
+    _Atomic uint32_t seq;       // write index + 1 once published, 0 while being written
+    trace_event_t ev;
+} trace_slot_t;
+
+typedef struct {
+    trace_slot_t *slots;
+    uint32_t mask;              // slot count - 1; the count is a power of two
+    _Atomic uint32_t head;      // events ever recorded
+    _Atomic uint32_t start;     // first index a reader reports (trace_ring_clear)
+} trace_ring_t;
+
+/** Clear slots and bind them, for rings not initialized statically like trace.c's
+ *  @param len  power of two */
+void trace_ring_init(trace_ring_t *r, trace_slot_t *slots, uint32_t len);
+
+/* Inline so ISR callers keep the whole path in IRAM */
+static inline void trace_ring_push(trace_ring_t *r, const trace_event_t *ev) {
+    const uint32_t n = atomic_fetch_add_explicit(&r->head, 1, memory_order_relaxed);
+    trace_slot_t *s = &r->slots[n & r->mask];
+    atomic_store_explicit(&s->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);      // readers see 0 before the new fields
+    s->ev = *ev;
+    atomic_store_explicit(&s->seq, n + 1, memory_order_release);
+}
+
+/**
+ * Visit the retained events oldest first. Events recorded during the walk
+ * may or may not be included; torn slots are skipped, never reported.
+ * @return false if visit() returned false (the walk stopped there)
+ */
+bool trace_ring_read(trace_ring_t *r, bool (*visit)(const trace_event_t *ev, void *ctx),
+                     void *ctx);
+
+/** Events overwritten before they could be read (since the last clear) */
+uint32_t trace_ring_dropped(trace_ring_t *r);
+
+/** Forget everything recorded so far */
+void trace_ring_clear(trace_ring_t *r);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,10 +5,18 @@
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "esp_netif.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "sdkconfig.h"
 #include <string.h>
 
 #define WIFI_KEY "wifi_creds"
-#define WIFI_CONNECT_RETRIES 5
+#define WIFI_FAST_KEY "wifi_fast"
+#define WIFI_FAST_VERSION 1
+#define WIFI_CONNECT_RETRIES 5           // failures before the portal opens alongside STA
+#define WIFI_BACKOFF_BASE_MS 1000
+#define WIFI_BACKOFF_MAX_MS  (5 * 60 * 1000)
 
 static const char *TAG = "wifi_manager";
 
@@ -17,16 +25,39 @@ typedef struct {
     char pass[64];
 } wifi_credentials_t;
 
+/* Last good association, used to skip the scan (and DHCP) on the next boot */
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t has_ip;
+    uint32_t ip, netmask, gw, dns;
+} wifi_fast_record_t;
+
 static wifi_manager_cb_t s_callback = NULL;
 static void *s_user_data = NULL;
 static bool s_connected = false;
 static int s_retry_count = 0;
 static httpd_handle_t s_httpd = NULL;
+static esp_netif_t *s_sta_netif = NULL;
+static esp_netif_t *s_ap_netif = NULL;
+static esp_timer_handle_t s_retry_timer = NULL;
+static bool s_portal_active = false;
+static wifi_fast_record_t s_fast = {0};
+static bool s_fast_attempt = false;     // current connect uses the cached BSSID/channel
+static bool s_static_ip = false;        // DHCP skipped in favour of the cached lease
+static int64_t s_connect_start_us = 0;
 
-static void start_captive_portal(void);
+static void start_captive_portal(bool keep_sta);
+static void stop_captive_portal(void);
 
 static bool wifi_manager_load_credentials(wifi_credentials_t *out) {
-    size_t len = sizeof(*out);
+    size_t len = 0;
+    if (!storage_manager_get_blob_size(WIFI_KEY, &len)) return false;
+    if (len != sizeof(*out)) {
+        ESP_LOGW(TAG, "Stored credentials have unexpected size %u", (unsigned)len);
+        return false;
+    }
     return storage_manager_get_blob(WIFI_KEY, out, len, NULL);
 }
 
@@ -39,6 +70,66 @@ bool wifi_manager_set_credentials(const char *ssid, const char *pass) {
 
 bool wifi_manager_is_connected(void) { return s_connected; }
 
+static bool load_fast_record(wifi_fast_record_t *out) {
+    size_t len = 0;
+    return storage_manager_get_blob(WIFI_FAST_KEY, out, sizeof(*out), &len) &&
+           len == sizeof(*out) && out->version == WIFI_FAST_VERSION && out->channel != 0;
+}
+
+/* Snapshot the association that just worked; only writes flash when it changed */
+static void save_fast_record(const esp_netif_ip_info_t *ip) {
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return;
+    wifi_fast_record_t rec = { .version = WIFI_FAST_VERSION, .channel = ap.primary };
+    memcpy(rec.bssid, ap.bssid, sizeof(rec.bssid));
+#if CONFIG_WIFI_MANAGER_CACHE_IP
+    esp_netif_dns_info_t dns = {0};
+    esp_netif_get_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+    rec.has_ip = 1;
+    rec.ip = ip->ip.addr;
+    rec.netmask = ip->netmask.addr;
+    rec.gw = ip->gw.addr;
+    rec.dns = dns.ip.u_addr.ip4.addr;
+#endif
+    if (memcmp(&rec, &s_fast, sizeof(rec)) == 0) return;
+    s_fast = rec;
+    storage_manager_set_blob(WIFI_FAST_KEY, &rec, sizeof(rec));
+    ESP_LOGI(TAG, "Cached AP " MACSTR " on channel %d", MAC2STR(rec.bssid), rec.channel);
+}
+
+#if CONFIG_WIFI_MANAGER_CACHE_IP
+static void apply_static_ip(const wifi_fast_record_t *rec) {
+    esp_netif_ip_info_t ip = {
+        .ip = { .addr = rec->ip }, .netmask = { .addr = rec->netmask }, .gw = { .addr = rec->gw }
+    };
+    esp_netif_dns_info_t dns = {0};
+    dns.ip.u_addr.ip4.addr = rec->dns;
+    esp_netif_dhcpc_stop(s_sta_netif);
+    if (esp_netif_set_ip_info(s_sta_netif, &ip) == ESP_OK) {
+        esp_netif_set_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+        s_static_ip = true;
+    } else {
+        esp_netif_dhcpc_start(s_sta_netif);
+    }
+}
+#endif
+
+/* The cached AP didn't answer: forget the shortcut and do a normal scan + DHCP */
+static void fall_back_to_full_scan(void) {
+    wifi_config_t cfg;
+    esp_wifi_get_config(WIFI_IF_STA, &cfg);
+    cfg.sta.bssid_set = false;
+    cfg.sta.channel = 0;
+    cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    if (s_static_ip) {
+        esp_netif_dhcpc_start(s_sta_netif);
+        s_static_ip = false;
+    }
+    s_fast_attempt = false;
+    ESP_LOGW(TAG, "Fast connect failed, falling back to full scan");
+}
+
 static esp_err_t root_get_handler(httpd_req_t *req) {
     const char resp[] =
         "<!DOCTYPE html><html><body>"
@@ -70,8 +161,11 @@ static esp_err_t connect_post_handler(httpd_req_t *req) {
 static httpd_uri_t uri_root = { .uri = "/", .method = HTTP_GET, .handler = root_get_handler };
 static httpd_uri_t uri_connect = { .uri = "/connect", .method = HTTP_POST, .handler = connect_post_handler };
 
-static void start_captive_portal(void) {
-    ESP_LOGI(TAG, "Starting AP + Captive Portal");
+/* Portal runs as AP-only with no credentials, or APSTA while STA keeps retrying */
+static void start_captive_portal(bool keep_sta) {
+    if (s_portal_active) return;
+    s_portal_active = true;
+    ESP_LOGI(TAG, "Starting %s + Captive Portal", keep_sta ? "AP (STA retrying)" : "AP");
     wifi_config_t ap_config = {
         .ap = {
             .ssid = "ESP32_Config",
@@ -81,34 +175,87 @@ static void start_captive_portal(void) {
             .authmode = WIFI_AUTH_OPEN
         },
     };
-    esp_netif_create_default_wifi_ap();
-    esp_wifi_set_mode(WIFI_MODE_AP);
+    if (!s_ap_netif) s_ap_netif = esp_netif_create_default_wifi_ap();
+    esp_wifi_set_mode(keep_sta ? WIFI_MODE_APSTA : WIFI_MODE_AP);
     esp_wifi_set_config(WIFI_IF_AP, &ap_config);
     esp_wifi_start();
     if (s_callback) s_callback(WIFI_EVENT_AP_STARTED, s_user_data);
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.task_priority = CONFIG_WIFI_MANAGER_PORTAL_TASK_PRIORITY;
+    config.core_id = CONFIG_WIFI_MANAGER_PORTAL_TASK_CORE < 0 ? tskNO_AFFINITY
+                                                              : CONFIG_WIFI_MANAGER_PORTAL_TASK_CORE;
     if (httpd_start(&s_httpd, &config) == ESP_OK) {
         httpd_register_uri_handler(s_httpd, &uri_root);
         httpd_register_uri_handler(s_httpd, &uri_connect);
     }
 }
 
+static void stop_captive_portal(void) {
+    if (!s_portal_active) return;
+    s_portal_active = false;
+    if (s_httpd) {
+        httpd_stop(s_httpd);
+        s_httpd = NULL;
+    }
+    esp_wifi_set_mode(WIFI_MODE_STA);
+    ESP_LOGI(TAG, "Station reconnected, captive portal stopped");
+    if (s_callback) s_callback(WIFI_EVENT_AP_STOPPED, s_user_data);
+}
+
+/* base * 2^n capped at max, then +/-25% jitter so a room of clocks doesn't
+   hammer the router in lockstep after it reboots */
+static uint32_t backoff_delay_ms(int attempt) {
+    uint32_t delay = WIFI_BACKOFF_MAX_MS;
+    if (attempt < 16) {
+        uint32_t d = (uint32_t)WIFI_BACKOFF_BASE_MS << attempt;
+        if (d < delay) delay = d;
+    }
+    uint32_t jitter = delay / 4;
+    return delay - jitter + esp_random() % (2 * jitter + 1);
+}
+
+static void retry_timer_cb(void *arg) {
+    if (!s_connected) esp_wifi_connect();
+}
+
+static void schedule_retry(void) {
+    uint32_t delay = backoff_delay_ms(s_retry_count);
+    s_retry_count++;
+    ESP_LOGI(TAG, "Reconnect attempt %d in %u ms", s_retry_count, (unsigned)delay);
+    esp_timer_stop(s_retry_timer);
+    esp_timer_start_once(s_retry_timer, (uint64_t)delay * 1000);
+}
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         s_connected = false;
-        if (s_retry_count < WIFI_CONNECT_RETRIES) {
-            s_retry_count++;
+        if (s_fast_attempt) {
+            fall_back_to_full_scan();   // doesn't count against the retry budget
             esp_wifi_connect();
         } else {
-            start_captive_portal();
+            // Never give up on the station; past the threshold also let a user fix it
+            if (s_retry_count >= WIFI_CONNECT_RETRIES) start_captive_portal(true);
+            schedule_retry();
         }
         if (s_callback) s_callback(WIFI_EVENT_DISCONNECTED, s_user_data);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        const ip_event_got_ip_t *got = (const ip_event_got_ip_t *)event_data;
         s_connected = true;
         s_retry_count = 0;
+        if (s_connect_start_us) {
+            ESP_LOGI(TAG, "Got IP " IPSTR " in %d ms (%s%s)", IP2STR(&got->ip_info.ip),
+                     (int)((esp_timer_get_time() - s_connect_start_us) / 1000),
+                     s_fast_attempt ? "fast connect" : "full scan",
+                     s_static_ip ? ", cached IP" : "");
+            s_connect_start_us = 0;
+        }
+        s_fast_attempt = false;
+        esp_timer_stop(s_retry_timer);
+        stop_captive_portal();
+        save_fast_record(&got->ip_info);
         if (s_callback) s_callback(WIFI_EVENT_GOT_IP, s_user_data);
     }
 }
@@ -117,22 +264,38 @@ void wifi_manager_init(wifi_manager_cb_t cb, void *user_data) {
     s_callback = cb; s_user_data = user_data;
     esp_netif_init();
     esp_event_loop_create_default();
-    esp_netif_create_default_wifi_sta();
+    s_sta_netif = esp_netif_create_default_wifi_sta();
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     esp_wifi_init(&cfg);
     esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, NULL);
     esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL, NULL);
+    const esp_timer_create_args_t retry_args = { .callback = retry_timer_cb, .name = "wifi_retry" };
+    esp_timer_create(&retry_args, &s_retry_timer);
 
     wifi_credentials_t creds = {0};
     wifi_config_t wifi_config = {0};
     if (wifi_manager_load_credentials(&creds)) {
         strncpy((char*)wifi_config.sta.ssid, creds.ssid, sizeof(wifi_config.sta.ssid));
         strncpy((char*)wifi_config.sta.password, creds.pass, sizeof(wifi_config.sta.password));
+#if CONFIG_WIFI_MANAGER_FAST_CONNECT
+        if (load_fast_record(&s_fast)) {
+            // Associate straight to the last AP on its channel: no scan
+            memcpy(wifi_config.sta.bssid, s_fast.bssid, sizeof(s_fast.bssid));
+            wifi_config.sta.bssid_set = true;
+            wifi_config.sta.channel = s_fast.channel;
+            wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+            s_fast_attempt = true;
+#if CONFIG_WIFI_MANAGER_CACHE_IP
+            if (s_fast.has_ip) apply_static_ip(&s_fast);
+#endif
+        }
+#endif
+        s_connect_start_us = esp_timer_get_time();
         esp_wifi_set_mode(WIFI_MODE_STA);
         esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
         esp_wifi_start();
     } else {
-        start_captive_portal();
+        start_captive_portal(false);
     }
 }
 
@@ -7,7 +7,8 @@ typedef enum {
     WIFI_EVENT_CONNECTED,
     WIFI_EVENT_DISCONNECTED,
     WIFI_EVENT_GOT_IP,
-    WIFI_EVENT_AP_STARTED
+    WIFI_EVENT_AP_STARTED,
+    WIFI_EVENT_AP_STOPPED       // portal closed after the station reconnected
 } wifi_manager_event_t;
 
 typedef void (*wifi_manager_cb_t)(wifi_manager_event_t event, void *user_data);
@@ -0,0 +1,152 @@
+#include "benchmark.h"
+#include "sim.h"
+#include "storage_manager.h"
+#include "storage_backend.h"
+#include "storage_settings.h"
+#include "time_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Benchmark runner: times the hot paths (components/benchmark) on the host,
+ * or reads results captured from a device log, and checks them against a
+ * baseline. Exits 1 when any case is slower than baseline * (1 + threshold).
+ *
+ *   color_alarm_bench [--filter S] [--scale N] [--batches N]
+ *                     [--results device.log] [--baseline FILE] [--threshold PCT]
+ *                     [--write-baseline FILE]
+ *
+ * Baselines are JSON lines in the same format as the results and only mean
+ * something on the machine (or device) they were recorded on.
+ */
+
+#define HOST_SCALE          50      // the host is far faster than the ESP32; keep batches measurable
+#define HOST_BATCHES        10
+#define DEFAULT_THRESHOLD   50.0    // percent; shared hosts drift by a third between runs
+#define BENCH_EPOCH         1704714240      // 2024-01-08 11:44:00 UTC
+#define BENCH_TZ            "EST5EDT,M3.2.0/2,M11.1.0/2"
+
+static int64_t host_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int load_results(const char *path, benchmark_result_t *out, int max) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    char line[256];
+    int n = 0;
+    while (n < max && fgets(line, sizeof(line), f)) {
+        if (benchmark_parse_json(line, &out[n])) n++;
+    }
+    fclose(f);
+    return n;
+}
+
+static bool write_results(const char *path, const benchmark_result_t *r, int n) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[BENCHMARK_JSON_LEN];
+    for (int i = 0; i < n; i++) {
+        if (benchmark_format_json(&r[i], line, sizeof(line)) > 0) fprintf(f, "%s\n", line);
+    }
+    return fclose(f) == 0;
+}
+
+/* Returns the number of regressions */
+static int check(const benchmark_result_t *res, int n, const benchmark_result_t *base, int nb,
+                 double threshold, bool report_missing) {
+    int failed = 0;
+    printf("%-24s %12s %12s %8s\n", "case", "baseline ns", "now ns", "delta");
+    for (int i = 0; i < n; i++) {
+        const benchmark_result_t *b = NULL;
+        for (int j = 0; j < nb && !b; j++) {
+            if (strcmp(base[j].name, res[i].name) == 0) b = &base[j];
+        }
+        if (!b || b->ns_per_op <= 0) {
+            printf("%-24s %12s %12.1f %8s\n", res[i].name, "-", res[i].ns_per_op, "new");
+            continue;
+        }
+        const double delta = (res[i].ns_per_op / b->ns_per_op - 1.0) * 100.0;
+        const bool regressed = delta > threshold;
+        failed += regressed;
+        printf("%-24s %12.1f %12.1f %+7.1f%%%s\n", res[i].name, b->ns_per_op, res[i].ns_per_op,
+               delta, regressed ? "  REGRESSED" : "");
+    }
+    for (int j = 0; j < nb && report_missing; j++) {
+        bool seen = false;
+        for (int i = 0; i < n && !seen; i++) seen = strcmp(base[j].name, res[i].name) == 0;
+        if (!seen) printf("%-24s %12.1f %12s %8s\n", base[j].name, base[j].ns_per_op, "-", "missing");
+    }
+    return failed;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--filter S] [--scale N] [--batches N] [--results FILE]\n"
+                    "       [--baseline FILE] [--threshold PCT] [--write-baseline FILE]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    benchmark_config_t cfg = { .clock = host_clock_ns, .scale = HOST_SCALE, .batches = HOST_BATCHES };
+    const char *results_path = NULL, *baseline_path = NULL, *write_path = NULL;
+    double threshold = DEFAULT_THRESHOLD;
+    for (int i = 1; i < argc; i++) {
+        const bool has_arg = i + 1 < argc;
+        if (strcmp(argv[i], "--filter") == 0 && has_arg) cfg.filter = argv[++i];
+        else if (strcmp(argv[i], "--scale") == 0 && has_arg) cfg.scale = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--batches") == 0 && has_arg) cfg.batches = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--results") == 0 && has_arg) results_path = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && has_arg) baseline_path = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && has_arg) threshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--write-baseline") == 0 && has_arg) write_path = argv[++i];
+        else usage(argv[0]);
+    }
+
+    benchmark_result_t res[BENCHMARK_MAX_CASES];
+    int n;
+    if (results_path) {
+        n = load_results(results_path, res, BENCHMARK_MAX_CASES);
+        if (n < 0) return 1;
+    } else {
+        // Same setup the firmware has by the time the clock is valid, minus flash
+        sim_rtos_init();
+        sim_set_boot_epoch(BENCH_EPOCH);
+        storage_manager_init_with_backend(storage_backend_mem());
+        storage_settings_init(0);
+        time_manager_set_timezone(BENCH_TZ);
+        n = benchmark_run(&cfg, res, BENCHMARK_MAX_CASES);
+        char line[BENCHMARK_JSON_LEN];
+        for (int i = 0; i < n; i++) {
+            if (benchmark_format_json(&res[i], line, sizeof(line)) > 0) printf("%s\n", line);
+        }
+    }
+    if (n == 0) {
+        fprintf(stderr, "no benchmark results\n");
+        return 1;
+    }
+
+    if (write_path && !write_results(write_path, res, n)) return 1;
+
+    int failed = 0;
+    if (baseline_path) {
+        benchmark_result_t base[BENCHMARK_MAX_CASES];
+        const int nb = load_results(baseline_path, base, BENCHMARK_MAX_CASES);
+        if (nb < 0) return 1;
+        failed = check(res, n, base, nb, threshold, !cfg.filter);
+        printf("%d of %d cases regressed more than %.0f%%\n", failed, n, threshold);
+    }
+    fflush(stdout);
+    // Task threads are parked inside the scheduler; don't wait for them
+    _exit(failed ? 1 : 0);
+}
@@ -0,0 +1,157 @@
+#include "anim_clip.h"
+#include "anim_kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Clip renderer: runs the firmware's own effect kernels (anim_kernels.c) frame
+ * by frame and writes the result as a clip image for the clips partition.
+ *
+ *   color_alarm_clipgen [--leds N] [-o clips.bin] [clip ...]
+ *
+ * With no names every clip below is rendered. Flash the image with
+ *   parttool.py write_partition --partition-name clips --input clips.bin
+ */
+
+#define DEFAULT_LEDS    32
+#define FRAME_MS        20          // the render task's cadence
+#define MAX_LEDS        1024
+#define MAX_CLIP_BYTES  (1024 * 1024)   // size of the clips partition
+
+typedef struct {
+    const char *name;
+    uint8_t channels;
+    uint16_t flags;
+    uint32_t frames;
+    /* Render frame k into px (RGB or RGBW as channels) */
+    void (*render)(uint8_t *px, const neopixel_format_t *fmt, int leds, uint32_t k);
+} clip_recipe_t;
+
+/* The alarm's wake animation: one uniform 12 s hue cycle, looped */
+#define WAKE_CYCLE_MS   12000
+
+static void render_wake_rainbow(uint8_t *px, const neopixel_format_t *fmt, int leds, uint32_t k) {
+    const uint32_t t = k * FRAME_MS;
+    const float base_h = (float)(t % WAKE_CYCLE_MS) / (float)WAKE_CYCLE_MS * 360.0f;
+    anim_rainbow_frame(px, fmt, NULL, leds, base_h, false, 255, 255);
+}
+
+/* Sunrise: chained fades from black through red and orange to warm white */
+typedef struct {
+    uint32_t ms;
+    uint8_t rgbw[4];
+} sunrise_step_t;
+
+static const sunrise_step_t s_sunrise[] = {
+    { 20000, {  60,   4,  0,   0 } },
+    { 20000, { 255,  80,  0,  40 } },
+    { 20000, { 255, 120, 20, 255 } },
+};
+#define SUNRISE_STEPS   (sizeof(s_sunrise) / sizeof(s_sunrise[0]))
+
+static void render_sunrise(uint8_t *px, const neopixel_format_t *fmt, int leds, uint32_t k) {
+    static uint8_t start[MAX_LEDS * 4];
+    uint32_t t = (k + 1) * FRAME_MS;        // like the fade mode: step, then draw
+    for (size_t s = 0; s < SUNRISE_STEPS; s++) {
+        if (t <= s_sunrise[s].ms || s + 1 == SUNRISE_STEPS) {
+            // Each leg fades from the previous leg's target
+            if (s == 0) memset(start, 0, (size_t)leds * fmt->bpp);
+            else fmt->fill(start, leds, s_sunrise[s - 1].rgbw[0], s_sunrise[s - 1].rgbw[1],
+                           s_sunrise[s - 1].rgbw[2], s_sunrise[s - 1].rgbw[3]);
+            float u = (float)t / (float)s_sunrise[s].ms;
+            anim_fade_frame(px, start, fmt, leds, s_sunrise[s].rgbw, u > 1.0f ? 1.0f : u);
+            return;
+        }
+        t -= s_sunrise[s].ms;
+    }
+}
+
+static const clip_recipe_t s_recipes[] = {
+    { "wake_rainbow", 3, ANIM_CLIP_FLAG_LOOP, WAKE_CYCLE_MS / FRAME_MS, render_wake_rainbow },
+    { "sunrise", 4, 0, 60000 / FRAME_MS, render_sunrise },
+};
+#define RECIPES (sizeof(s_recipes) / sizeof(s_recipes[0]))
+
+static uint8_t s_image[MAX_CLIP_BYTES];
+
+/* Append one rendered clip at off; returns its size, 0 if it does not fit */
+static size_t render_clip(const clip_recipe_t *r, int leds, size_t off) {
+    static uint8_t frames[2][MAX_LEDS * 4];
+    const neopixel_format_t *fmt =
+        neopixel_format(r->channels == 4 ? NEOPIXEL_ORDER_RGBW : NEOPIXEL_ORDER_RGB);
+    size_t o = off + ANIM_CLIP_HEADER_LEN;
+    for (uint32_t k = 0; k < r->frames; k++) {
+        uint8_t *cur = frames[k & 1];
+        const uint8_t *prev = k ? frames[(k - 1) & 1] : NULL;
+        r->render(cur, fmt, leds, k);
+        const size_t n = anim_clip_encode_frame(s_image + o, sizeof(s_image) - o, prev, cur,
+                                                leds, r->channels);
+        if (n == 0) return 0;
+        o += n;
+    }
+    anim_clip_info_t info = {
+        .channels = r->channels, .leds = (uint16_t)leds, .frame_ms = FRAME_MS,
+        .flags = r->flags, .frames = r->frames,
+        .data_len = (uint32_t)(o - off - ANIM_CLIP_HEADER_LEN),
+    };
+    snprintf(info.name, sizeof(info.name), "%s", r->name);
+    anim_clip_write_header(s_image + off, &info);
+    return o - off;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--leds N] [-o clips.bin] [clip ...]\nclips:", argv0);
+    for (size_t i = 0; i < RECIPES; i++) fprintf(stderr, " %s", s_recipes[i].name);
+    fputc('\n', stderr);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    int leds = DEFAULT_LEDS;
+    const char *out_path = "clips.bin";
+    const char *names[RECIPES];
+    size_t n_names = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--leds") == 0 && i + 1 < argc) leds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (argv[i][0] != '-' && n_names < RECIPES) names[n_names++] = argv[i];
+        else usage(argv[0]);
+    }
+    if (leds <= 0 || leds > MAX_LEDS) usage(argv[0]);
+
+    size_t off = 0;
+    for (size_t i = 0; i < RECIPES; i++) {
+        const clip_recipe_t *r = &s_recipes[i];
+        bool wanted = n_names == 0;
+        for (size_t j = 0; j < n_names && !wanted; j++) wanted = strcmp(names[j], r->name) == 0;
+        if (!wanted) continue;
+        const size_t n = render_clip(r, leds, off);
+        if (n == 0) {
+            fprintf(stderr, "%s: image larger than %d bytes\n", r->name, MAX_CLIP_BYTES);
+            return 1;
+        }
+        const size_t raw = (size_t)r->frames * leds * r->channels;
+        printf("%-16s %5u frames x %u ms, %7zu bytes (raw %zu, %.1f%%)\n", r->name,
+               (unsigned)r->frames, FRAME_MS, n, raw, 100.0 * (double)n / (double)raw);
+        off += n;
+    }
+    for (size_t j = 0; j < n_names; j++) {
+        bool known = false;
+        for (size_t i = 0; i < RECIPES && !known; i++) known = strcmp(names[j], s_recipes[i].name) == 0;
+        if (!known) usage(argv[0]);
+    }
+
+    FILE *f = fopen(out_path, "wb");
+    if (!f) {
+        perror(out_path);
+        return 1;
+    }
+    const bool ok = fwrite(s_image, 1, off, f) == off;
+    if (fclose(f) != 0 || !ok) {
+        perror(out_path);
+        return 1;
+    }
+    printf("%s: %zu bytes\n", out_path, off);
+    return 0;
+}
@@ -0,0 +1,419 @@
+#include "esp_http_server.h"
+#include "sim.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Host stand-in for esp_http_server: one server, no sockets. Requests from
+ * the scenario or a test are queued to an "httpd" task that runs the matching
+ * handler, as the device's server task does, so handlers and httpd_queue_work()
+ * jobs never run concurrently. Responses are captured into the client's
+ * sim_http_response_t; WebSocket frames pushed with httpd_ws_send_frame_async()
+ * into its sim_ws_client_t. Each HTTP request gets a session for its duration
+ * (Connection: close); a WebSocket keeps its session until the client closes. */
+
+static const char *TAG = "httpd";
+
+#define HTTPD_JOB_QUEUE_LEN 8
+#define HTTPD_FD_BASE       54      // first lwIP socket number on the device
+
+typedef enum { JOB_REQUEST, JOB_WS_OPEN, JOB_WS_FRAME, JOB_WS_CLOSE, JOB_WORK } job_kind_t;
+
+/* A request as received: the method, URI and body (or WebSocket frame) */
+typedef struct {
+    httpd_req_t req;
+    int fd;
+    sim_http_response_t *resp;
+    sim_ws_client_t *ws;
+    char *body;
+    size_t body_len;
+    size_t body_off;
+    bool sent;                  // the handler sent (part of) a response
+} request_t;
+
+typedef struct {
+    job_kind_t kind;
+    request_t *r;
+    httpd_work_fn_t fn;
+    void *arg;
+} job_t;
+
+typedef struct {
+    bool used;
+    sim_ws_client_t *ws;        // NULL: plain HTTP
+    const httpd_uri_t *uri;
+} session_t;
+
+static struct {
+    bool running;
+    httpd_config_t config;
+    QueueHandle_t jobs;
+    TaskHandle_t task;
+    httpd_uri_t *uris;
+    int n_uris;
+    session_t *sessions;        // config.max_open_sockets of them
+} s_server;
+
+static sim_http_response_t s_ws_resp;      // where WebSocket handlers' HTTP replies go
+
+/* ---- Sessions ---- */
+
+static int session_open(sim_ws_client_t *ws, const httpd_uri_t *uri) {
+    for (int i = 0; i < s_server.config.max_open_sockets; i++) {
+        session_t *s = &s_server.sessions[i];
+        if (!s->used) {
+            *s = (session_t){ .used = true, .ws = ws, .uri = uri };
+            return HTTPD_FD_BASE + i;
+        }
+    }
+    return -1;
+}
+
+static session_t *session_get(int fd) {
+    int i = fd - HTTPD_FD_BASE;
+    if (!s_server.running || i < 0 || i >= s_server.config.max_open_sockets) return NULL;
+    return s_server.sessions[i].used ? &s_server.sessions[i] : NULL;
+}
+
+static void session_close(int fd) {
+    session_t *s = session_get(fd);
+    if (!s) return;
+    if (s->ws) s->ws->open = false;
+    s->used = false;
+}
+
+/* ---- Dispatch (httpd task) ---- */
+
+static size_t path_len(const char *uri) {
+    const char *q = strchr(uri, '?');
+    return q ? (size_t)(q - uri) : strlen(uri);
+}
+
+/* Handler for the request's path and method; *path_found tells 404 from 405 */
+static const httpd_uri_t *find_handler(const char *uri, int method, bool *path_found) {
+    size_t n = path_len(uri);
+    *path_found = false;
+    for (int i = 0; i < s_server.n_uris; i++) {
+        const httpd_uri_t *u = &s_server.uris[i];
+        if (strlen(u->uri) != n || strncmp(u->uri, uri, n) != 0) continue;
+        *path_found = true;
+        if ((int)u->method == method) return u;
+    }
+    return NULL;
+}
+
+static void handle_request(request_t *r) {
+    sim_http_response_t *resp = r->resp;
+    bool path_found;
+    const httpd_uri_t *u = find_handler(r->req.uri, r->req.method, &path_found);
+    r->fd = session_open(NULL, u);
+    if (r->fd < 0) {
+        resp->status = 0;       // no socket left: connection refused
+    } else if (!u || u->is_websocket) {
+        httpd_resp_send_err(&r->req, path_found ? HTTPD_405_METHOD_NOT_ALLOWED : HTTPD_404_NOT_FOUND,
+                            NULL);
+    } else {
+        r->req.user_ctx = u->user_ctx;
+        if (u->handler(&r->req) != ESP_OK) {
+            // The server closes the socket; an unsent response never arrives
+            if (!r->sent) resp->status = 0;
+        }
+    }
+    session_close(r->fd);
+    resp->done = true;
+}
+
+static void handle_ws_open(request_t *r) {
+    sim_ws_client_t *c = r->ws;
+    bool path_found;
+    const httpd_uri_t *u = find_handler(r->req.uri, HTTP_GET, &path_found);
+    if (!u || !u->is_websocket) {
+        ESP_LOGW(TAG, "No WebSocket handler for %s", r->req.uri);
+        return;
+    }
+    int fd = session_open(c, u);
+    if (fd < 0) return;
+    c->fd = fd;
+    c->open = true;
+    r->req.user_ctx = u->user_ctx;
+    if (u->handler(&r->req) != ESP_OK) session_close(fd);
+}
+
+static void handle_ws_frame(request_t *r) {
+    session_t *s = session_get(r->ws->fd);
+    if (!s || s->ws != r->ws) return;
+    r->req.method = 0;          // anything but HTTP_GET: a data frame, not the handshake
+    r->req.user_ctx = s->uri->user_ctx;
+    if (s->uri->handler(&r->req) != ESP_OK) session_close(r->ws->fd);
+}
+
+static void request_free(request_t *r) {
+    if (!r) return;
+    free(r->body);
+    free(r);
+}
+
+static void httpd_task(void *arg) {
+    (void)arg;
+    job_t job;
+    for (;;) {
+        if (!xQueueReceive(s_server.jobs, &job, portMAX_DELAY)) continue;
+        switch (job.kind) {
+            case JOB_REQUEST:  handle_request(job.r); break;
+            case JOB_WS_OPEN:  handle_ws_open(job.r); break;
+            case JOB_WS_FRAME: handle_ws_frame(job.r); break;
+            case JOB_WS_CLOSE:
+                if (session_get(job.r->ws->fd)) session_close(job.r->ws->fd);
+                break;
+            case JOB_WORK:     job.fn(job.arg); break;
+        }
+        request_free(job.r);
+    }
+}
+
+/* ---- Server ---- */
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config) {
+    if (!handle || !config) return ESP_ERR_INVALID_ARG;
+    if (s_server.running) return ESP_ERR_INVALID_STATE;     // one server is all the firmware runs
+    s_server.config = *config;
+    s_server.uris = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    s_server.sessions = calloc(config->max_open_sockets, sizeof(session_t));
+    s_server.jobs = xQueueCreate(HTTPD_JOB_QUEUE_LEN, sizeof(job_t));
+    if (!s_server.uris || !s_server.sessions || !s_server.jobs ||
+        xTaskCreatePinnedToCore(httpd_task, "httpd", config->stack_size, NULL,
+                                config->task_priority, &s_server.task,
+                                config->core_id) != pdPASS) {
+        free(s_server.uris);
+        free(s_server.sessions);
+        if (s_server.jobs) vQueueDelete(s_server.jobs);
+        s_server.uris = NULL;
+        s_server.sessions = NULL;
+        s_server.jobs = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    s_server.n_uris = 0;
+    s_server.running = true;
+    *handle = &s_server;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+    if (handle != &s_server || !s_server.running) return ESP_ERR_INVALID_ARG;
+    vTaskDelete(s_server.task);
+    for (int fd = HTTPD_FD_BASE; fd < HTTPD_FD_BASE + s_server.config.max_open_sockets; fd++) {
+        session_close(fd);
+    }
+    job_t job;
+    while (xQueueReceive(s_server.jobs, &job, 0)) {
+        if (job.kind == JOB_REQUEST) {
+            job.r->resp->status = 0;        // dropped with the server
+            job.r->resp->done = true;
+        }
+        request_free(job.r);
+    }
+    vQueueDelete(s_server.jobs);
+    free(s_server.uris);
+    free(s_server.sessions);
+    memset(&s_server, 0, sizeof(s_server));
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri) {
+    if (handle != &s_server || !uri) return ESP_ERR_INVALID_ARG;
+    bool path_found;
+    if (find_handler(uri->uri, uri->method, &path_found)) return ESP_ERR_INVALID_STATE;
+    if (s_server.n_uris == s_server.config.max_uri_handlers) return ESP_ERR_NO_MEM;
+    s_server.uris[s_server.n_uris++] = *uri;
+    return ESP_OK;
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg) {
+    if (handle != &s_server || !s_server.running || !work) return ESP_ERR_INVALID_ARG;
+    job_t job = { .kind = JOB_WORK, .fn = work, .arg = arg };
+    return xQueueSend(s_server.jobs, &job, 0) == pdTRUE ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds) {
+    if (handle != &s_server || !s_server.running || !fds || !client_fds) return ESP_ERR_INVALID_ARG;
+    size_t n = 0;
+    for (int i = 0; i < s_server.config.max_open_sockets; i++) {
+        if (!s_server.sessions[i].used) continue;
+        if (n == *fds) return ESP_ERR_INVALID_ARG;
+        client_fds[n++] = HTTPD_FD_BASE + i;
+    }
+    *fds = n;
+    return ESP_OK;
+}
+
+/* ---- Requests and responses (handlers) ---- */
+
+static request_t *req_state(httpd_req_t *r) {
+    return r->aux;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status) {
+    req_state(r)->resp->status = atoi(status);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type) {
+    sim_http_response_t *resp = req_state(r)->resp;
+    snprintf(resp->type, sizeof(resp->type), "%s", type);
+    return ESP_OK;
+}
+
+static void resp_append(sim_http_response_t *resp, const char *buf, size_t len) {
+    size_t room = sizeof(resp->body) - 1 - resp->len;
+    if (len > room) {
+        len = room;
+        resp->truncated = true;
+    }
+    memcpy(resp->body + resp->len, buf, len);
+    resp->len += len;
+    resp->body[resp->len] = '\0';
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t len) {
+    request_t *q = req_state(r);
+    q->sent = true;
+    if (!q->resp->type[0]) httpd_resp_set_type(r, "text/html");
+    if (buf) resp_append(q->resp, buf, len == HTTPD_RESP_USE_STRLEN ? strlen(buf) : (size_t)len);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t len) {
+    return httpd_resp_send(r, buf, len);
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t *r, const char *str) {
+    return httpd_resp_send(r, str, HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *r, httpd_err_code_t error, const char *msg) {
+    static const struct { int status; const char *text; } errs[] = {
+        [HTTPD_400_BAD_REQUEST]           = { 400, "Bad request" },
+        [HTTPD_404_NOT_FOUND]             = { 404, "This URI does not exist" },
+        [HTTPD_405_METHOD_NOT_ALLOWED]    = { 405, "Request method for this URI is not handled by server" },
+        [HTTPD_500_INTERNAL_SERVER_ERROR] = { 500, "Server has encountered an unexpected error" },
+    };
+    req_state(r)->resp->status = errs[error].status;
+    httpd_resp_set_type(r, "text/html");
+    return httpd_resp_sendstr(r, msg ? msg : errs[error].text);
+}
+
+esp_err_t httpd_resp_send_500(httpd_req_t *r) {
+    return httpd_resp_send_err(r, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+}
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t len) {
+    request_t *q = req_state(r);
+    size_t left = q->body_len - q->body_off;
+    if (len > left) len = left;
+    memcpy(buf, q->body + q->body_off, len);
+    q->body_off += len;
+    return (int)len;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf, size_t len) {
+    const char *q = strchr(r->uri, '?');
+    if (!q) return ESP_ERR_NOT_FOUND;
+    if (!buf || len == 0) return ESP_ERR_INVALID_ARG;
+    snprintf(buf, len, "%s", q + 1);
+    return strlen(q + 1) < len ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/* ---- WebSocket (handlers) ---- */
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *r, httpd_ws_frame_t *frame, size_t max_len) {
+    request_t *q = req_state(r);
+    if (!q->ws || r->method == HTTP_GET) return ESP_ERR_INVALID_STATE;     // no frame in a handshake
+    frame->final = true;
+    frame->fragmented = false;
+    frame->type = HTTPD_WS_TYPE_BINARY;
+    frame->len = q->body_len;
+    if (max_len == 0) return ESP_OK;                                        // length only
+    if (max_len < q->body_len) return ESP_ERR_INVALID_SIZE;
+    if (!frame->payload) return ESP_ERR_INVALID_ARG;
+    memcpy(frame->payload, q->body, q->body_len);
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t handle, int fd, httpd_ws_frame_t *frame) {
+    session_t *s = session_get(fd);
+    if (handle != &s_server || !s || !s->ws || !frame) return ESP_ERR_INVALID_ARG;
+    sim_ws_client_t *c = s->ws;
+    c->len = frame->len < sizeof(c->data) ? frame->len : sizeof(c->data);
+    memcpy(c->data, frame->payload, c->len);
+    c->frames++;
+    return ESP_OK;
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t handle, int fd) {
+    session_t *s = session_get(fd);
+    if (handle != &s_server || !s) return HTTPD_WS_CLIENT_INVALID;
+    return s->ws ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_HTTP;
+}
+
+/* ---- Client side (scenario / tests) ---- */
+
+static bool post_job(job_kind_t kind, const char *uri, int method, const void *body,
+                     size_t body_len, sim_http_response_t *resp, sim_ws_client_t *ws) {
+    if (!s_server.running) return false;
+    request_t *r = calloc(1, sizeof(*r));
+    if (!r) return false;
+    r->req.handle = &s_server;
+    r->req.method = method;
+    r->req.aux = r;
+    snprintf(r->req.uri, sizeof(r->req.uri), "%s", uri ? uri : "");
+    r->resp = resp ? resp : &s_ws_resp;
+    r->ws = ws;
+    r->fd = -1;
+    if (body_len) {
+        r->body = malloc(body_len);
+        if (!r->body) { free(r); return false; }
+        memcpy(r->body, body, body_len);
+        r->body_len = body_len;
+        r->req.content_len = body_len;
+    }
+    job_t job = { .kind = kind, .r = r };
+    if (xQueueSend(s_server.jobs, &job, 0) != pdTRUE) {
+        request_free(r);
+        return false;
+    }
+    return true;
+}
+
+bool sim_http_request(const char *method, const char *uri, const char *body,
+                      sim_http_response_t *resp) {
+    static const struct { const char *name; int method; } methods[] = {
+        { "GET", HTTP_GET }, { "POST", HTTP_POST }, { "PUT", HTTP_PUT },
+        { "DELETE", HTTP_DELETE }, { "HEAD", HTTP_HEAD },
+    };
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strcmp(method, methods[i].name) != 0) continue;
+        memset(resp, 0, sizeof(*resp));
+        resp->status = 200;
+        return post_job(JOB_REQUEST, uri, methods[i].method, body, body ? strlen(body) : 0,
+                        resp, NULL);
+    }
+    return false;
+}
+
+bool sim_ws_open(const char *uri, sim_ws_client_t *c) {
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+    return post_job(JOB_WS_OPEN, uri, HTTP_GET, NULL, 0, NULL, c);
+}
+
+bool sim_ws_send(sim_ws_client_t *c, const uint8_t *data, size_t len) {
+    return c->open && post_job(JOB_WS_FRAME, NULL, 0, data, len, NULL, c);
+}
+
+void sim_ws_close(sim_ws_client_t *c) {
+    if (c->open) post_job(JOB_WS_CLOSE, NULL, 0, NULL, 0, NULL, c);
+}
@@ -0,0 +1,3 @@
+#pragma once
+#include "esp_err.h"
+/* wifi_manager.h includes this; the host Wi-Fi stand-in needs nothing from it */
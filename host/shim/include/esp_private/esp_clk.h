@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+/** RTC counter in us; on the host it runs with simulated time */
+uint64_t esp_clk_rtc_time(void);
@@ -0,0 +1,16 @@
+#pragma once
+#include <sys/time.h>
+
+typedef enum { SNTP_SYNC_MODE_IMMED, SNTP_SYNC_MODE_SMOOTH } sntp_sync_mode_t;
+typedef enum { SNTP_SYNC_STATUS_RESET, SNTP_SYNC_STATUS_COMPLETED, SNTP_SYNC_STATUS_IN_PROGRESS } sntp_sync_status_t;
+typedef enum { SNTP_OPMODE_POLL, SNTP_OPMODE_LISTENONLY } sntp_operatingmode_t;
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+/* Sync events come from the scenario ("sntp" command), not the network */
+void sntp_set_sync_mode(sntp_sync_mode_t mode);
+void esp_sntp_setoperatingmode(sntp_operatingmode_t mode);
+void esp_sntp_setservername(unsigned char idx, const char *server);
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t cb);
+void esp_sntp_init(void);
+/** COMPLETED once after each sync (reads reset it), never IN_PROGRESS: syncs are steps */
+sntp_sync_status_t sntp_get_sync_status(void);
@@ -0,0 +1,17 @@
+#pragma once
+#include "esp_err.h"
+
+typedef enum {
+    ESP_RST_UNKNOWN,
+    ESP_RST_POWERON,
+    ESP_RST_EXT,
+    ESP_RST_SW,
+    ESP_RST_PANIC,
+} esp_reset_reason_t;
+
+typedef void (*shutdown_handler_t)(void);
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle);
+esp_reset_reason_t esp_reset_reason(void);
+/** Runs the shutdown handlers and ends the simulation */
+void esp_restart(void) __attribute__((noreturn));
@@ -0,0 +1,25 @@
+#pragma once
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Simulated time since boot (us); advances only while every task is blocked */
+int64_t esp_timer_get_time(void);
+
+/* Callbacks run in the simulated timer service task rather than a separate
+ * esp_timer task, at the timer service tick resolution (sim_hal.c). */
+typedef struct sim_esp_timer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out);
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout_us);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t period_us);
+esp_err_t esp_timer_stop(esp_timer_handle_t t);
+esp_err_t esp_timer_delete(esp_timer_handle_t t);
+bool esp_timer_is_active(esp_timer_handle_t t);
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+/* Host FreeRTOS: tasks are threads, but only one runs at a time and simulated
+ * time advances only when every task is blocked (see host/shim/sim_rtos.c).
+ * Single core, priority scheduling, preemption at API calls. */
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define portMAX_DELAY        ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ   CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS   (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define configMAX_TASK_NAME_LEN 16
+#define portNUM_PROCESSORS   1
+#define tskNO_AFFINITY       0x7fffffff
+
+/* Only one task runs at a time, so critical sections need no lock */
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define taskENTER_CRITICAL(mux)        ((void)(mux))
+#define taskEXIT_CRITICAL(mux)         ((void)(mux))
+#define taskENTER_CRITICAL_ISR(mux)    ((void)(mux))
+#define taskEXIT_CRITICAL_ISR(mux)     ((void)(mux))
+#define portENTER_CRITICAL(mux)        ((void)(mux))
+#define portEXIT_CRITICAL(mux)         ((void)(mux))
+#define portYIELD_FROM_ISR(...)        ((void)0)
+
+/** True on the scheduler thread, where ISRs and scenario events run */
+BaseType_t xPortInIsrContext(void);
+static inline BaseType_t xPortGetCoreID(void) { return 0; }
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *p);
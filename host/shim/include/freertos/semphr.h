@@ -0,0 +1,13 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+/* Mutexes only (plain and recursive); priority inheritance is not modelled */
+typedef struct sim_mutex *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+void vSemaphoreDelete(SemaphoreHandle_t m);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t m, TickType_t ticks);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t m);
@@ -0,0 +1,18 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+/* Callbacks run in the simulated timer service task ("Tmr Svc", priority 1) */
+typedef struct sim_timer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t t);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *id, TimerCallbackFunction_t cb);
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t ticks);
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t ticks);
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t ticks);
+BaseType_t xTimerChangePeriod(TimerHandle_t t, TickType_t period, TickType_t ticks);
+BaseType_t xTimerDelete(TimerHandle_t t, TickType_t ticks);
+BaseType_t xTimerIsTimerActive(TimerHandle_t t);
+void vTimerSetReloadMode(TimerHandle_t t, UBaseType_t auto_reload);
+TickType_t xTimerGetExpiryTime(TimerHandle_t t);
+void *pvTimerGetTimerID(TimerHandle_t t);
@@ -0,0 +1,7 @@
+#pragma once
+/* The host build links the POSIX socket API directly */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
@@ -0,0 +1,42 @@
+#pragma once
+/* Host simulator configuration: the device defaults from sdkconfig.defaults and
+ * the components' Kconfig, minus what the simulator cannot model (PM, Wi-Fi). */
+
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_FREERTOS_HZ 100
+#define CONFIG_FREERTOS_USE_TRACE_FACILITY 1
+#define CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS 0
+
+#define CONFIG_STORAGE_MANAGER_BACKEND_FILE 1
+#define CONFIG_STORAGE_MANAGER_FILE_PATH "color_alarm_storage.bin"
+#define CONFIG_STORAGE_MANAGER_BENCH_ON_BOOT 0
+#define CONFIG_BENCHMARK_ON_BOOT 0
+
+#define CONFIG_NEOPIXEL_CAP_SLEW_PER_S 400
+#define CONFIG_NEOPIXEL_STRIP_WS2812 1
+#define CONFIG_NEOPIXEL_STRIP_ORDER_GRBW 1
+#define CONFIG_NEOPIXEL_RENDER_TASK_PRIORITY 10
+#define CONFIG_NEOPIXEL_RENDER_TASK_CORE 1
+#define CONFIG_EVENT_DISPATCHER_TASK_PRIORITY 8
+#define CONFIG_EVENT_DISPATCHER_TASK_CORE 1
+#define CONFIG_NEOPIXEL_STREAM_PORT 4048
+#define CONFIG_NEOPIXEL_STREAM_TIMEOUT_MS 2500
+#define CONFIG_NEOPIXEL_CLIP_PARTITION "clips"
+#define CONFIG_NEOPIXEL_CLIP_DEFAULT "wake_rainbow"
+#define CONFIG_NEOPIXEL_LAYOUT_LINE 1
+
+#define CONFIG_POT_MANAGER_CONTINUOUS 0
+#define CONFIG_POT_MANAGER_IDLE_PERIOD_MS 1000
+
+#define CONFIG_TELEMETRY_PERIOD_S 60
+#define CONFIG_TELEMETRY_RING_LEN 8
+#define CONFIG_TELEMETRY_LOG_SAMPLES 0
+
+#define CONFIG_TRACE_ENABLE 1
+#define CONFIG_TRACE_RING_LEN 4096      // Kconfig maximum; holds the wake_alarm scenario
+
+#define CONFIG_CONTROL_API_PORT 8080
+#define CONFIG_CONTROL_API_TASK_PRIORITY 5
+#define CONFIG_CONTROL_API_TASK_CORE 0
+#define CONFIG_CONTROL_API_PREVIEW_FPS 10
+#define CONFIG_CONTROL_API_PREVIEW_MAX_LEDS 256
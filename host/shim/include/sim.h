@@ -0,0 +1,88 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Simulator control, used by the scenario runner (host/sim_main.c). Everything
+ * here runs on the scheduler thread while no simulated task is running. */
+
+/* ---- Scheduler / clock (sim_rtos.c) ---- */
+
+void sim_rtos_init(void);
+/** Run tasks and advance simulated time up to t_us (time since boot) */
+void sim_run_until(int64_t t_us);
+int64_t sim_now_us(void);
+/** Run fn(arg) in the "sys_evt" task, like an esp_event handler */
+bool sim_post_event(void (*fn)(void *arg), void *arg);
+/** Log every task's state (for "tasks" in a scenario) */
+void sim_dump_tasks(void);
+
+/* ---- Peripherals and services (sim_hal.c) ---- */
+
+/** Drive an input pin; fires its ISR if the change matches the interrupt type */
+void sim_gpio_set_level(int pin, int level);
+int sim_gpio_get_level(int pin);
+void sim_adc_set(int channel, int raw);
+
+/** Wall clock at boot, seconds since the epoch (0 = unset, as after power-on) */
+void sim_set_boot_epoch(int64_t epoch_s);
+/** Deliver an SNTP sync to epoch_s (in the sys_evt task) */
+void sim_sntp_sync(int64_t epoch_s);
+
+typedef struct {
+    uint32_t frames;
+    uint32_t timing_errors;     // high/low times outside the WS2812 windows
+    int64_t last_us;            // simulated time of the latest frame
+    size_t len;                 // bytes in the latest frame
+    uint8_t data[4 * 1024];     // latest frame as sent (wire order, cap applied;
+                                //  raw SPI bytes for APA102 strips)
+} sim_rmt_capture_t;
+
+const sim_rmt_capture_t *sim_rmt_capture(void);
+/** Append every decoded frame to this file as "t_us,hexbytes" (NULL = off) */
+bool sim_rmt_trace_open(const char *path);
+
+/** Back a data partition (e.g. "clips") with a file's contents, padded with
+ *  0xFF like erased flash; only one partition is simulated */
+bool sim_partition_load(const char *label, const char *path);
+
+/** Run shutdown handlers (settings flush etc.) as esp_restart() would */
+void sim_run_shutdown_handlers(void);
+
+/* ---- Wi-Fi (wifi_manager_host.c) ---- */
+
+void sim_wifi_connect(void);
+void sim_wifi_disconnect(void);
+void sim_wifi_portal(void);
+
+/* ---- Control API client (httpd_host.c) ---- */
+
+typedef struct {
+    bool done;                  // the handler returned (set in the httpd task)
+    int status;                 // 200, 400, ...; 0 if the server dropped the connection
+    char type[32];
+    bool truncated;             // the body did not fit
+    size_t len;
+    char body[16 * 1024];       // all chunks, NUL-terminated
+} sim_http_response_t;
+
+/** Queue "GET"/"POST"/"DELETE" uri (with its ?query) and a form body (or NULL)
+ *  to the running server. The handler runs in the httpd task, so resp must
+ *  stay valid until a sim_run_until() has set resp->done. */
+bool sim_http_request(const char *method, const char *uri, const char *body,
+                      sim_http_response_t *resp);
+
+typedef struct {
+    int fd;                     // set once the handshake has been handled
+    bool open;
+    uint32_t frames;            // frames the server pushed
+    size_t len;
+    uint8_t data[4 * 1024];     // the latest of them (truncated to fit)
+} sim_ws_client_t;
+
+/** Open a WebSocket to uri (the handler sees the handshake as a GET); c must
+ *  outlive the connection */
+bool sim_ws_open(const char *uri, sim_ws_client_t *c);
+/** Send a binary frame from the client to the URI's handler */
+bool sim_ws_send(sim_ws_client_t *c, const uint8_t *data, size_t len);
+void sim_ws_close(sim_ws_client_t *c);
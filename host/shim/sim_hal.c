@@ -0,0 +1,574 @@
+#include "sim.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_sleep.h"
+#include "esp_pm.h"
+#include "esp_heap_caps.h"
+#include "esp_sntp.h"
+#include "esp_partition.h"
+#include "esp_private/esp_clk.h"
+#include "driver/gpio.h"
+#include "driver/adc.h"
+#include "driver/rmt.h"
+#include "driver/spi_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+/* Peripherals and services for the host simulator. Inputs come from the
+ * scenario (sim_*), outputs are logged or captured; all timing is simulated. */
+
+static const char *TAG = "sim";
+
+/* ---- Log / errors ---- */
+
+void sim_log(char level, const char *tag, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    printf("%c (%lld) %s: ", level, (long long)(sim_now_us() / 1000), tag);
+    vprintf(fmt, ap);
+    putchar('\n');
+    va_end(ap);
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "ESP_ERR_?";
+    }
+}
+
+void sim_abort(const char *what, const char *expr, int code) {
+    fprintf(stderr, "sim abort at %lld ms: %s: %s (%d)\n",
+            (long long)(sim_now_us() / 1000), what, expr, code);
+    fflush(stdout);
+    abort();
+}
+
+/* ---- Clocks ---- */
+
+static int64_t s_epoch_offset_us = 0;     // wall clock = offset + time since boot
+
+int64_t esp_timer_get_time(void) {
+    return sim_now_us();
+}
+
+/* esp_timer on the simulated software timers: same one-shot/periodic
+ * semantics, rounded up to whole ticks. */
+struct sim_esp_timer {
+    TimerHandle_t timer;
+    esp_timer_cb_t cb;
+    void *arg;
+};
+
+static void esp_timer_trampoline(TimerHandle_t timer) {
+    struct sim_esp_timer *t = pvTimerGetTimerID(timer);
+    t->cb(t->arg);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+    if (!args || !args->callback || !out) return ESP_ERR_INVALID_ARG;
+    struct sim_esp_timer *t = calloc(1, sizeof(*t));
+    if (!t) return ESP_ERR_NO_MEM;
+    t->cb = args->callback;
+    t->arg = args->arg;
+    t->timer = xTimerCreate(args->name, 1, pdFALSE, t, esp_timer_trampoline);
+    if (!t->timer) { free(t); return ESP_ERR_NO_MEM; }
+    *out = t;
+    return ESP_OK;
+}
+
+static esp_err_t esp_timer_start(esp_timer_handle_t t, uint64_t us, bool periodic) {
+    if (xTimerIsTimerActive(t->timer)) return ESP_ERR_INVALID_STATE;
+    const uint64_t tick_us = 1000000 / configTICK_RATE_HZ;
+    TickType_t ticks = (TickType_t)((us + tick_us - 1) / tick_us);
+    vTimerSetReloadMode(t->timer, periodic);
+    return xTimerChangePeriod(t->timer, ticks ? ticks : 1, 0) == pdPASS ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout_us) {
+    return esp_timer_start(t, timeout_us, false);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t period_us) {
+    return esp_timer_start(t, period_us, true);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+    if (!xTimerIsTimerActive(t->timer)) return ESP_ERR_INVALID_STATE;
+    xTimerStop(t->timer, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t t) {
+    if (xTimerIsTimerActive(t->timer)) return ESP_ERR_INVALID_STATE;
+    xTimerDelete(t->timer, 0);
+    free(t);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t t) {
+    return xTimerIsTimerActive(t->timer);
+}
+
+uint64_t esp_clk_rtc_time(void) {
+    return (uint64_t)sim_now_us();
+}
+
+void sim_set_boot_epoch(int64_t epoch_s) {
+    s_epoch_offset_us = epoch_s * 1000000 - sim_now_us();
+}
+
+/* These replace the libc versions for the firmware (the executable's
+ * definitions win at link time), so the wall clock follows simulated time. */
+int gettimeofday(struct timeval *tv, void *tz) {
+    (void)tz;
+    int64_t us = s_epoch_offset_us + sim_now_us();
+    tv->tv_sec = (time_t)(us / 1000000);
+    tv->tv_usec = (suseconds_t)(us % 1000000);
+    return 0;
+}
+
+int settimeofday(const struct timeval *tv, const struct timezone *tz) {
+    (void)tz;
+    if (tv) s_epoch_offset_us = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec - sim_now_us();
+    return 0;
+}
+
+time_t time(time_t *out) {
+    time_t t = (time_t)((s_epoch_offset_us + sim_now_us()) / 1000000);
+    if (out) *out = t;
+    return t;
+}
+
+/* ---- System ---- */
+
+#define MAX_SHUTDOWN_HANDLERS 8
+static shutdown_handler_t s_shutdown[MAX_SHUTDOWN_HANDLERS];
+static int s_shutdown_count = 0;
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle) {
+    if (s_shutdown_count >= MAX_SHUTDOWN_HANDLERS) return ESP_ERR_NO_MEM;
+    s_shutdown[s_shutdown_count++] = handle;
+    return ESP_OK;
+}
+
+void sim_run_shutdown_handlers(void) {
+    for (int i = s_shutdown_count - 1; i >= 0; i--) s_shutdown[i]();
+}
+
+esp_reset_reason_t esp_reset_reason(void) {
+    return ESP_RST_POWERON;
+}
+
+void esp_restart(void) {
+    ESP_LOGI(TAG, "esp_restart(): running shutdown handlers and ending the simulation");
+    sim_run_shutdown_handlers();
+    fflush(stdout);
+    exit(0);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    (void)caps;
+    return 200 * 1024;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    (void)caps;
+    return 180 * 1024;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    (void)caps;
+    return 110 * 1024;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+void heap_caps_free(void *ptr) {
+    free(ptr);
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void) {
+    return ESP_OK;
+}
+
+struct sim_pm_lock {
+    int held;
+};
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char *name,
+                             esp_pm_lock_handle_t *out_handle) {
+    (void)type; (void)arg; (void)name;
+    *out_handle = calloc(1, sizeof(struct sim_pm_lock));
+    return *out_handle ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    handle->held++;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    if (handle->held == 0) return ESP_ERR_INVALID_STATE;
+    handle->held--;
+    return ESP_OK;
+}
+
+/* ---- SNTP ---- */
+
+static sntp_sync_time_cb_t s_sntp_cb = NULL;
+static sntp_sync_mode_t s_sntp_mode = SNTP_SYNC_MODE_IMMED;
+static bool s_sntp_running = false;
+static sntp_sync_status_t s_sntp_status = SNTP_SYNC_STATUS_RESET;
+
+void sntp_set_sync_mode(sntp_sync_mode_t mode) { s_sntp_mode = mode; }
+void esp_sntp_setoperatingmode(sntp_operatingmode_t mode) { (void)mode; }
+void esp_sntp_setservername(unsigned char idx, const char *server) { (void)idx; (void)server; }
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t cb) { s_sntp_cb = cb; }
+void esp_sntp_init(void) { s_sntp_running = true; }
+
+sntp_sync_status_t sntp_get_sync_status(void) {
+    sntp_sync_status_t st = s_sntp_status;
+    if (st == SNTP_SYNC_STATUS_COMPLETED) s_sntp_status = SNTP_SYNC_STATUS_RESET;
+    return st;
+}
+
+static void sntp_sync_event(void *arg) {
+    int64_t epoch_s = (int64_t)(intptr_t)arg;
+    if (!s_sntp_running) {
+        ESP_LOGW(TAG, "SNTP not started yet, dropping sync");
+        return;
+    }
+    // Smooth mode is applied as a step: the firmware only sees the callback
+    struct timeval tv = { .tv_sec = (time_t)epoch_s, .tv_usec = 0 };
+    settimeofday(&tv, NULL);
+    s_sntp_status = SNTP_SYNC_STATUS_COMPLETED;
+    ESP_LOGI(TAG, "SNTP sync (%s) to %lld", s_sntp_mode == SNTP_SYNC_MODE_SMOOTH ? "smooth" : "immediate",
+             (long long)epoch_s);
+    if (s_sntp_cb) s_sntp_cb(&tv);
+}
+
+void sim_sntp_sync(int64_t epoch_s) {
+    sim_post_event(sntp_sync_event, (void *)(intptr_t)epoch_s);
+}
+
+/* ---- GPIO ---- */
+
+typedef struct {
+    int level;
+    gpio_int_type_t intr;
+    gpio_isr_t isr;
+    void *arg;
+} sim_pin_t;
+
+static sim_pin_t s_pins[GPIO_PIN_COUNT];
+
+static bool pin_ok(gpio_num_t pin) {
+    return pin >= 0 && pin < GPIO_PIN_COUNT;
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg) {
+    for (int pin = 0; pin < GPIO_PIN_COUNT; pin++) {
+        if (!(cfg->pin_bit_mask & (1ULL << pin))) continue;
+        s_pins[pin].intr = cfg->intr_type;
+        // An unconnected input idles at its pull
+        if (cfg->pull_up_en) s_pins[pin].level = 1;
+        else if (cfg->pull_down_en) s_pins[pin].level = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int flags) {
+    (void)flags;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void *arg) {
+    if (!pin_ok(pin)) return ESP_ERR_INVALID_ARG;
+    s_pins[pin].isr = handler;
+    s_pins[pin].arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t pin) {
+    if (!pin_ok(pin)) return ESP_ERR_INVALID_ARG;
+    s_pins[pin].isr = NULL;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin) {
+    return pin_ok(pin) ? s_pins[pin].level : 0;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) {
+    if (!pin_ok(pin)) return ESP_ERR_INVALID_ARG;
+    s_pins[pin].level = level ? 1 : 0;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type) {
+    if (!pin_ok(pin)) return ESP_ERR_INVALID_ARG;
+    s_pins[pin].intr = type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type) {
+    (void)type;
+    return pin_ok(pin) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t pin) {
+    return pin_ok(pin) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static bool intr_matches(gpio_int_type_t type, int from, int to) {
+    switch (type) {
+        case GPIO_INTR_POSEDGE:    return !from && to;
+        case GPIO_INTR_NEGEDGE:    return from && !to;
+        case GPIO_INTR_ANYEDGE:    return from != to;
+        case GPIO_INTR_LOW_LEVEL:  return !to;
+        case GPIO_INTR_HIGH_LEVEL: return to;
+        default:                   return false;
+    }
+}
+
+void sim_gpio_set_level(int pin, int level) {
+    if (!pin_ok(pin)) return;
+    sim_pin_t *p = &s_pins[pin];
+    const int from = p->level;
+    p->level = level ? 1 : 0;
+    // Runs on the scheduler thread between tasks, i.e. in "ISR context"
+    if (p->isr && from != p->level && intr_matches(p->intr, from, p->level)) p->isr(p->arg);
+}
+
+int sim_gpio_get_level(int pin) {
+    return gpio_get_level(pin);
+}
+
+/* ---- ADC ---- */
+
+static int s_adc[ADC1_CHANNEL_MAX];
+
+esp_err_t adc1_config_width(adc_bits_width_t width) {
+    (void)width;
+    return ESP_OK;
+}
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t chan, adc_atten_t atten) {
+    (void)atten;
+    return (chan >= 0 && chan < ADC1_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int adc1_get_raw(adc1_channel_t chan) {
+    return (chan >= 0 && chan < ADC1_CHANNEL_MAX) ? s_adc[chan] : -1;
+}
+
+void sim_adc_set(int channel, int raw) {
+    if (channel < 0 || channel >= ADC1_CHANNEL_MAX) return;
+    s_adc[channel] = raw < 0 ? 0 : raw > 4095 ? 4095 : raw;
+}
+
+/* ---- RMT: decode the waveform back into bytes ---- */
+
+#define APB_HZ     80000000
+/* WS2812 windows (ns): a 1 bit is high 550..850 ns, a 0 bit 200..500 ns, and
+ * every bit period must stay under 2 us; a low of >= 50 us is the latch. */
+#define T1H_MIN 550
+#define T1H_MAX 850
+#define T0H_MIN 200
+#define T0H_MAX 500
+#define TBIT_MAX 2000
+#define RESET_MIN 50000
+
+static uint32_t s_rmt_ns_per_tick[RMT_CHANNEL_MAX];
+static bool s_rmt_installed[RMT_CHANNEL_MAX];
+static sim_rmt_capture_t s_capture;
+static FILE *s_trace = NULL;
+
+static void capture_frame(void) {
+    s_capture.frames++;
+    s_capture.last_us = sim_now_us();
+    if (s_trace) {
+        fprintf(s_trace, "%lld,", (long long)s_capture.last_us);
+        for (size_t i = 0; i < s_capture.len; i++) fprintf(s_trace, "%02x", s_capture.data[i]);
+        fputc('\n', s_trace);
+    }
+}
+
+esp_err_t rmt_config(const rmt_config_t *cfg) {
+    if (cfg->channel >= RMT_CHANNEL_MAX || cfg->clk_div == 0) return ESP_ERR_INVALID_ARG;
+    s_rmt_ns_per_tick[cfg->channel] = 1000000000U / (APB_HZ / cfg->clk_div);
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_flags) {
+    (void)rx_buf_size; (void)intr_flags;
+    if (channel >= RMT_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    if (s_rmt_installed[channel]) return ESP_ERR_INVALID_STATE;
+    s_rmt_installed[channel] = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+    if (channel >= RMT_CHANNEL_MAX || !s_rmt_installed[channel]) return ESP_ERR_INVALID_STATE;
+    s_rmt_installed[channel] = false;
+    return ESP_OK;
+}
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *items, int n, bool wait) {
+    (void)wait;
+    if (channel >= RMT_CHANNEL_MAX || !s_rmt_installed[channel]) return ESP_ERR_INVALID_STATE;
+    const uint32_t ns = s_rmt_ns_per_tick[channel];
+    size_t len = 0;
+    int bits = 0;
+    uint8_t byte = 0;
+    for (int i = 0; i < n; i++) {
+        const uint32_t high = items[i].level0 ? items[i].duration0 * ns : 0;
+        const uint32_t low = items[i].level0 ? items[i].duration1 * ns : items[i].duration0 * ns;
+        if (!items[i].level0) {
+            if (low < RESET_MIN) s_capture.timing_errors++;     // only the latch is all-low
+            continue;
+        }
+        bool one = high >= T1H_MIN && high <= T1H_MAX;
+        bool zero = high >= T0H_MIN && high <= T0H_MAX;
+        if ((!one && !zero) || high + low > TBIT_MAX) s_capture.timing_errors++;
+        byte = (uint8_t)(byte << 1 | (one ? 1 : 0));
+        if (++bits == 8) {
+            if (len < sizeof(s_capture.data)) s_capture.data[len++] = byte;
+            bits = 0;
+            byte = 0;
+        }
+    }
+    if (bits) s_capture.timing_errors++;    // partial byte
+    s_capture.len = len;
+    capture_frame();
+    return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t ticks) {
+    (void)ticks;
+    return channel < RMT_CHANNEL_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+/* ---- SPI (APA102 strips): bytes are captured as sent ---- */
+
+struct spi_device_t {
+    spi_host_device_t host;
+};
+
+static bool s_spi_bus[SPI_HOST_MAX];
+static struct spi_device_t s_spi_dev[SPI_HOST_MAX];
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *cfg, spi_dma_chan_t dma) {
+    (void)cfg; (void)dma;
+    if (host >= SPI_HOST_MAX) return ESP_ERR_INVALID_ARG;
+    if (s_spi_bus[host]) return ESP_ERR_INVALID_STATE;
+    s_spi_bus[host] = true;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host) {
+    if (host >= SPI_HOST_MAX || !s_spi_bus[host]) return ESP_ERR_INVALID_STATE;
+    s_spi_bus[host] = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *cfg,
+                             spi_device_handle_t *handle) {
+    if (host >= SPI_HOST_MAX || !cfg || !handle) return ESP_ERR_INVALID_ARG;
+    if (!s_spi_bus[host]) return ESP_ERR_INVALID_STATE;
+    s_spi_dev[host].host = host;
+    *handle = &s_spi_dev[host];
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *t) {
+    if (!handle || !t || (t->length && !t->tx_buffer)) return ESP_ERR_INVALID_ARG;
+    size_t len = t->length / 8;
+    if (len > sizeof(s_capture.data)) len = sizeof(s_capture.data);
+    memcpy(s_capture.data, t->tx_buffer, len);
+    s_capture.len = len;
+    capture_frame();
+    return ESP_OK;
+}
+
+/* ---- Partitions ---- */
+
+#define PARTITION_ALIGN 0x10000     // mapped in 64 KB MMU pages
+
+static esp_partition_t s_partition;
+static uint8_t *s_partition_data = NULL;
+
+bool sim_partition_load(const char *label, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    const long len = ftell(f);
+    rewind(f);
+    const size_t size = ((size_t)len + PARTITION_ALIGN - 1) / PARTITION_ALIGN * PARTITION_ALIGN;
+    uint8_t *data = (uint8_t *)malloc(size ? size : PARTITION_ALIGN);
+    bool ok = data && fread(data, 1, (size_t)len, f) == (size_t)len;
+    fclose(f);
+    if (!ok) {
+        free(data);
+        return false;
+    }
+    memset(data + len, 0xFF, size - (size_t)len);
+    free(s_partition_data);
+    s_partition_data = data;
+    s_partition = (esp_partition_t){ .type = ESP_PARTITION_TYPE_DATA, .subtype = 0x40,
+                                     .address = 0x190000, .size = (uint32_t)size };
+    snprintf(s_partition.label, sizeof(s_partition.label), "%s", label);
+    return true;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char *label) {
+    if (!s_partition_data || type != s_partition.type) return NULL;
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != s_partition.subtype) return NULL;
+    if (label && strcmp(label, s_partition.label) != 0) return NULL;
+    return &s_partition;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle) {
+    (void)memory;
+    if (partition != &s_partition || offset + size > s_partition.size) return ESP_ERR_INVALID_ARG;
+    *out_ptr = s_partition_data + offset;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+    (void)handle;
+}
+
+const sim_rmt_capture_t *sim_rmt_capture(void) {
+    return &s_capture;
+}
+
+bool sim_rmt_trace_open(const char *path) {
+    if (s_trace) fclose(s_trace);
+    s_trace = path ? fopen(path, "w") : NULL;
+    return !path || s_trace;
+}
@@ -0,0 +1,606 @@
+#include "sim.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Deterministic FreeRTOS stand-in on simulated time.
+ *
+ * Every task is a pthread, but only the thread holding s_lock runs: the
+ * scheduler (the process's main thread) hands the lock to the highest-priority
+ * ready task and waits until it blocks. When nothing is ready, simulated time
+ * jumps straight to the earliest deadline, so hours of idle firmware take
+ * microseconds. A task that readies a higher-priority one is preempted at that
+ * API call; ISRs and scenario events only run between tasks.
+ */
+
+static const char *TAG = "sim_rtos";
+
+#define TICK_US        (1000000 / configTICK_RATE_HZ)
+#define NEVER          INT64_MAX
+#define SPIN_LIMIT     1000000     // task switches without time advancing
+
+typedef enum { ST_READY, ST_BLOCKED, ST_DELETED } task_state_t;
+typedef enum { W_NONE, W_DELAY, W_NOTIFY, W_RECV, W_SEND, W_MUTEX } wait_kind_t;
+
+struct sim_task {
+    char name[configMAX_TASK_NAME_LEN];
+    TaskFunction_t fn;
+    void *arg;
+    UBaseType_t prio;
+    uint32_t stack;
+    UBaseType_t number;
+    task_state_t state;
+    int64_t ready_seq;          // FIFO among equal priorities
+    wait_kind_t wait;
+    void *wait_obj;
+    int64_t wake_us;
+    bool timed_out;
+    uint32_t notify;
+    bool run;                   // the scheduler handed this task the lock
+    pthread_cond_t cv;
+    pthread_t thread;
+    struct sim_task *next;
+};
+
+struct sim_queue {
+    UBaseType_t len, item_size, count, head;
+    uint8_t *buf;
+};
+
+struct sim_mutex {
+    struct sim_task *owner;
+    UBaseType_t depth;
+    bool recursive;
+};
+
+struct sim_timer {
+    char name[configMAX_TASK_NAME_LEN];
+    TickType_t period;
+    bool reload;
+    bool active;
+    int64_t due_us;
+    void *id;
+    TimerCallbackFunction_t cb;
+    bool deleted;
+    struct sim_timer *next;
+};
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_sched_cv = PTHREAD_COND_INITIALIZER;
+static struct sim_task *s_current = NULL;     // NULL: scheduler/ISR context
+static struct sim_task *s_tasks = NULL;       // creation order
+static struct sim_task **s_tasks_tail = &s_tasks;
+static struct sim_timer *s_timers = NULL;
+static struct sim_task *s_timer_task = NULL;
+static QueueHandle_t s_evt_queue = NULL;
+static int64_t s_now_us = 0;
+static int64_t s_seq = 0;
+static int64_t s_front_seq = 0;
+static UBaseType_t s_task_count = 0;
+
+typedef struct {
+    void (*fn)(void *arg);
+    void *arg;
+} sim_event_t;
+
+/* ---- Core switching ---- */
+
+static void make_ready(struct sim_task *t) {
+    t->state = ST_READY;
+    t->wait = W_NONE;
+    t->wait_obj = NULL;
+    t->ready_seq = ++s_seq;
+}
+
+/* Give the lock back to the scheduler and sleep until resumed */
+static void suspend_current(void) {
+    struct sim_task *t = s_current;
+    t->run = false;
+    s_current = NULL;
+    pthread_cond_signal(&s_sched_cv);
+    while (!t->run) pthread_cond_wait(&t->cv, &s_lock);
+}
+
+/* A task readied 'woken': preempt the caller if woken outranks it */
+static void preempt_check(struct sim_task *woken) {
+    if (!woken || !s_current || woken->prio <= s_current->prio) return;
+    s_current->state = ST_READY;
+    s_current->ready_seq = --s_front_seq;     // resumes ahead of its peers
+    suspend_current();
+}
+
+static int64_t ticks_to_deadline(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) return NEVER;
+    return (s_now_us / TICK_US + (int64_t)ticks) * TICK_US;
+}
+
+/* Block the calling task; true if woken by an event rather than the timeout */
+static bool block_current(wait_kind_t wait, void *obj, int64_t wake_us) {
+    struct sim_task *t = s_current;
+    if (!t) sim_abort("blocking call outside a task", wait == W_DELAY ? "delay" : "wait", 0);
+    t->state = ST_BLOCKED;
+    t->wait = wait;
+    t->wait_obj = obj;
+    t->wake_us = wake_us;
+    t->timed_out = false;
+    suspend_current();
+    return !t->timed_out;
+}
+
+/* Highest-priority task blocked on (wait, obj), first-blocked among equals */
+static struct sim_task *waiter(wait_kind_t wait, void *obj) {
+    struct sim_task *best = NULL;
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        if (t->state == ST_BLOCKED && t->wait == wait && t->wait_obj == obj &&
+            (!best || t->prio > best->prio)) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+static void *task_thread(void *p) {
+    struct sim_task *t = p;
+    pthread_mutex_lock(&s_lock);
+    while (!t->run) pthread_cond_wait(&t->cv, &s_lock);
+    t->fn(t->arg);
+    // Returning from a task function is an error on FreeRTOS; treat it as vTaskDelete(NULL)
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+static struct sim_task *pick_ready(void) {
+    struct sim_task *best = NULL;
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        if (t->state != ST_READY) continue;
+        if (!best || t->prio > best->prio ||
+            (t->prio == best->prio && t->ready_seq < best->ready_seq)) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+static void switch_to(struct sim_task *t) {
+    s_current = t;
+    t->run = true;
+    pthread_cond_signal(&t->cv);
+    while (s_current) pthread_cond_wait(&s_sched_cv, &s_lock);
+}
+
+void sim_run_until(int64_t t_us) {
+    uint32_t spins = 0;
+    int64_t spin_at = s_now_us;
+    for (;;) {
+        struct sim_task *t = pick_ready();
+        if (t) {
+            if (s_now_us != spin_at) { spin_at = s_now_us; spins = 0; }
+            if (++spins > SPIN_LIMIT) sim_abort("task never blocks", t->name, (int)t->number);
+            switch_to(t);
+            continue;
+        }
+        int64_t next = NEVER;
+        for (struct sim_task *b = s_tasks; b; b = b->next) {
+            if (b->state == ST_BLOCKED && b->wake_us < next) next = b->wake_us;
+        }
+        if (next > t_us) {
+            if (t_us > s_now_us) s_now_us = t_us;
+            return;
+        }
+        if (next > s_now_us) s_now_us = next;
+        for (struct sim_task *b = s_tasks; b; b = b->next) {
+            if (b->state == ST_BLOCKED && b->wake_us <= s_now_us) {
+                b->timed_out = true;
+                make_ready(b);
+            }
+        }
+    }
+}
+
+int64_t sim_now_us(void) {
+    return s_now_us;
+}
+
+/* ---- Tasks ---- */
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t prio, TaskHandle_t *out) {
+    struct sim_task *t = calloc(1, sizeof(*t));
+    if (!t) return pdFAIL;
+    strncpy(t->name, name ? name : "", sizeof(t->name) - 1);
+    t->fn = fn;
+    t->arg = arg;
+    t->prio = prio;
+    t->stack = stack_depth;
+    t->number = ++s_task_count;
+    pthread_cond_init(&t->cv, NULL);
+    make_ready(t);
+    *s_tasks_tail = t;
+    s_tasks_tail = &t->next;
+    if (pthread_create(&t->thread, NULL, task_thread, t) != 0) {
+        sim_abort("pthread_create", t->name, 0);
+    }
+    pthread_detach(t->thread);
+    if (out) *out = t;
+    preempt_check(t);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *out,
+                                   BaseType_t core) {
+    (void)core;     // single simulated core
+    return xTaskCreate(fn, name, stack_depth, arg, prio, out);
+}
+
+void vTaskDelete(TaskHandle_t t) {
+    if (!t) t = s_current;
+    if (!t) return;
+    t->state = ST_DELETED;
+    if (t == s_current) {
+        s_current = NULL;
+        pthread_cond_signal(&s_sched_cv);
+        pthread_mutex_unlock(&s_lock);
+        pthread_exit(NULL);
+    }
+    // Another task's thread stays parked in suspend_current() for good
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        s_current->state = ST_READY;
+        s_current->ready_seq = ++s_seq;     // behind its peers: a yield
+        suspend_current();
+        return;
+    }
+    block_current(W_DELAY, NULL, ticks_to_deadline(ticks));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *prev_wake, TickType_t increment) {
+    const TickType_t wake = *prev_wake + increment;
+    *prev_wake = wake;
+    const TickType_t now = (TickType_t)(s_now_us / TICK_US);
+    if ((int32_t)(wake - now) <= 0) return pdFALSE;      // already late: no delay
+    block_current(W_DELAY, NULL, (int64_t)wake * TICK_US);
+    return pdTRUE;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(s_now_us / TICK_US);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return s_current;
+}
+
+BaseType_t xPortInIsrContext(void) {
+    return s_current == NULL;
+}
+
+TaskHandle_t xTaskGetHandle(const char *name) {
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        if (t->state != ST_DELETED && strcmp(t->name, name) == 0) return t;
+    }
+    return NULL;
+}
+
+char *pcTaskGetName(TaskHandle_t t) {
+    if (!t) t = s_current;
+    return t ? t->name : NULL;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    struct sim_task *t = s_current;
+    if (t->notify == 0 && ticks != 0) {
+        block_current(W_NOTIFY, NULL, ticks_to_deadline(ticks));
+    }
+    uint32_t v = t->notify;
+    if (v) t->notify = clear_on_exit ? 0 : v - 1;
+    return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t) {
+    t->notify++;
+    if (t->state == ST_BLOCKED && t->wait == W_NOTIFY) {
+        make_ready(t);
+        preempt_check(t);
+    }
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken) {
+    t->notify++;
+    if (t->state == ST_BLOCKED && t->wait == W_NOTIFY) {
+        make_ready(t);
+        if (woken) *woken = pdTRUE;
+    }
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    UBaseType_t n = 0;
+    for (struct sim_task *t = s_tasks; t; t = t->next) n += t->state != ST_DELETED;
+    return n;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *out, UBaseType_t max, uint32_t *total_runtime) {
+    if (uxTaskGetNumberOfTasks() > max) return 0;
+    UBaseType_t n = 0;
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        if (t->state == ST_DELETED) continue;
+        out[n++] = (TaskStatus_t){
+            .xHandle = t,
+            .pcTaskName = t->name,
+            .xTaskNumber = t->number,
+            .eCurrentState = t == s_current ? eRunning
+                             : t->state == ST_READY ? eReady : eBlocked,
+            .uxCurrentPriority = t->prio,
+            .uxBasePriority = t->prio,
+            .usStackHighWaterMark = t->stack,
+        };
+    }
+    if (total_runtime) *total_runtime = (uint32_t)s_now_us;
+    return n;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t t) {
+    if (!t) t = s_current;
+    return t ? t->stack : 0;
+}
+
+void sim_dump_tasks(void) {
+    static const char *const states[] = { "ready", "blocked", "deleted" };
+    static const char *const waits[] = { "", "delay", "notify", "queue", "queue-full", "mutex" };
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        if (t->state == ST_DELETED) continue;
+        char wake[32] = "";
+        if (t->state == ST_BLOCKED && t->wake_us != NEVER) {
+            snprintf(wake, sizeof(wake), " until %lld ms", (long long)(t->wake_us / 1000));
+        }
+        ESP_LOGI(TAG, "%-16s prio %2u %s %s%s", t->name, t->prio, states[t->state],
+                 waits[t->wait], wake);
+    }
+}
+
+/* ---- Queues ---- */
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct sim_queue *q = calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->buf = calloc(length, item_size);
+    if (!q->buf) { free(q); return NULL; }
+    q->len = length;
+    q->item_size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    if (!q) return;
+    free(q->buf);
+    free(q);
+}
+
+static bool queue_put(QueueHandle_t q, const void *item) {
+    if (q->count == q->len) return false;
+    memcpy(q->buf + ((q->head + q->count) % q->len) * q->item_size, item, q->item_size);
+    q->count++;
+    return true;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) {
+    const int64_t deadline = ticks_to_deadline(ticks);
+    while (!queue_put(q, item)) {
+        if (ticks == 0 || !s_current || !block_current(W_SEND, q, deadline)) return pdFALSE;
+    }
+    struct sim_task *w = waiter(W_RECV, q);
+    if (w) {
+        make_ready(w);
+        preempt_check(w);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken) {
+    if (!queue_put(q, item)) return pdFALSE;
+    struct sim_task *w = waiter(W_RECV, q);
+    if (w) {
+        make_ready(w);
+        if (woken) *woken = pdTRUE;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *out, TickType_t ticks) {
+    const int64_t deadline = ticks_to_deadline(ticks);
+    while (q->count == 0) {
+        if (ticks == 0 || !s_current || !block_current(W_RECV, q, deadline)) return pdFALSE;
+    }
+    memcpy(out, q->buf + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->len;
+    q->count--;
+    struct sim_task *w = waiter(W_SEND, q);
+    if (w) {
+        make_ready(w);
+        preempt_check(w);
+    }
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    return q->count;
+}
+
+/* ---- Mutexes ---- */
+
+static SemaphoreHandle_t mutex_create(bool recursive) {
+    struct sim_mutex *m = calloc(1, sizeof(*m));
+    if (m) m->recursive = recursive;
+    return m;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return mutex_create(false); }
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) { return mutex_create(true); }
+void vSemaphoreDelete(SemaphoreHandle_t m) { free(m); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t ticks) {
+    const int64_t deadline = ticks_to_deadline(ticks);
+    // Scheduler-context callers (owner NULL) may take a free mutex but never wait
+    while (m->depth && !(m->recursive && m->owner == s_current)) {
+        if (ticks == 0 || !s_current || !block_current(W_MUTEX, m, deadline)) return pdFALSE;
+    }
+    m->owner = s_current;
+    m->depth++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+    if (m->depth == 0 || m->owner != s_current) return pdFALSE;
+    if (--m->depth) return pdTRUE;
+    m->owner = NULL;
+    struct sim_task *w = waiter(W_MUTEX, m);
+    if (w) {
+        make_ready(w);
+        preempt_check(w);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t m, TickType_t ticks) {
+    return xSemaphoreTake(m, ticks);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t m) {
+    return xSemaphoreGive(m);
+}
+
+/* ---- Software timers ---- */
+
+static void timer_service_wake(void) {
+    if (s_timer_task && s_timer_task->state == ST_BLOCKED) {
+        make_ready(s_timer_task);
+        preempt_check(s_timer_task);
+    }
+}
+
+static struct sim_timer *next_due_timer(void) {
+    struct sim_timer *best = NULL;
+    for (struct sim_timer *t = s_timers; t; t = t->next) {
+        if (t->active && !t->deleted && (!best || t->due_us < best->due_us)) best = t;
+    }
+    return best;
+}
+
+static void timer_service_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        struct sim_timer *t = next_due_timer();
+        if (!t || t->due_us > s_now_us) {
+            block_current(W_DELAY, NULL, t ? t->due_us : NEVER);
+            continue;
+        }
+        if (t->reload) t->due_us += (int64_t)t->period * TICK_US;
+        else t->active = false;
+        t->cb(t);
+    }
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *id, TimerCallbackFunction_t cb) {
+    if (period == 0 || !cb) return NULL;
+    struct sim_timer *t = calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    strncpy(t->name, name ? name : "", sizeof(t->name) - 1);
+    t->period = period;
+    t->reload = auto_reload;
+    t->id = id;
+    t->cb = cb;
+    t->next = s_timers;
+    s_timers = t;
+    return t;
+}
+
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t ticks) {
+    (void)ticks;
+    t->active = true;
+    t->due_us = ticks_to_deadline(t->period);
+    timer_service_wake();
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t ticks) {
+    return xTimerStart(t, ticks);
+}
+
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t ticks) {
+    (void)ticks;
+    t->active = false;
+    return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t t, TickType_t period, TickType_t ticks) {
+    if (period == 0) return pdFAIL;
+    t->period = period;
+    return xTimerStart(t, ticks);
+}
+
+BaseType_t xTimerDelete(TimerHandle_t t, TickType_t ticks) {
+    (void)ticks;
+    t->active = false;
+    t->deleted = true;      // kept on the list: callers may still hold the handle
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t t) {
+    return t->active;
+}
+
+void vTimerSetReloadMode(TimerHandle_t t, UBaseType_t auto_reload) {
+    t->reload = auto_reload;
+}
+
+TickType_t xTimerGetExpiryTime(TimerHandle_t t) {
+    return (TickType_t)(t->due_us / TICK_US);
+}
+
+void *pvTimerGetTimerID(TimerHandle_t t) {
+    return t->id;
+}
+
+/* ---- Event task: scenario events run here, like esp_event handlers ---- */
+
+static void event_task(void *arg) {
+    (void)arg;
+    sim_event_t ev;
+    for (;;) {
+        if (xQueueReceive(s_evt_queue, &ev, portMAX_DELAY)) ev.fn(ev.arg);
+    }
+}
+
+bool sim_post_event(void (*fn)(void *arg), void *arg) {
+    sim_event_t ev = { fn, arg };
+    return xQueueSend(s_evt_queue, &ev, 0) == pdTRUE;
+}
+
+void *pvPortMalloc(size_t size) {
+    return malloc(size);
+}
+
+void vPortFree(void *p) {
+    free(p);
+}
+
+void sim_rtos_init(void) {
+    pthread_mutex_lock(&s_lock);    // held by the scheduler whenever no task runs
+    // Same names and priorities as the IDF system tasks they stand in for
+    xTaskCreate(timer_service_task, "Tmr Svc", 2048, NULL, 1, &s_timer_task);
+    s_evt_queue = xQueueCreate(32, sizeof(sim_event_t));
+    xTaskCreate(event_task, "sys_evt", 2304, NULL, 20, NULL);
+}
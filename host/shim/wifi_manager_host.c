@@ -0,0 +1,71 @@
+#include "wifi_manager.h"
+#include "sim.h"
+#include "esp_log.h"
+#include <string.h>
+
+/* Host stand-in for wifi_manager: no radio, the scenario decides when the
+ * station connects, drops or falls back to the portal. Events are delivered
+ * from the sys_evt task, as the esp_event loop does on the device. */
+
+static const char *TAG = "wifi_manager";
+
+static wifi_manager_cb_t s_cb = NULL;
+static void *s_user = NULL;
+static bool s_connected = false;
+static bool s_portal = false;
+static char s_ssid[33] = "sim-ssid";
+
+static void emit(wifi_manager_event_t ev) {
+    if (s_cb) s_cb(ev, s_user);
+}
+
+void wifi_manager_init(wifi_manager_cb_t cb, void *user_data) {
+    s_cb = cb;
+    s_user = user_data;
+    ESP_LOGI(TAG, "Simulated Wi-Fi (SSID '%s'); waiting for the scenario", s_ssid);
+}
+
+bool wifi_manager_set_credentials(const char *ssid, const char *pass) {
+    (void)pass;
+    if (!ssid || strlen(ssid) >= sizeof(s_ssid)) return false;
+    strcpy(s_ssid, ssid);
+    return true;
+}
+
+bool wifi_manager_is_connected(void) {
+    return s_connected;
+}
+
+static void connect_event(void *arg) {
+    (void)arg;
+    if (s_connected) return;
+    s_connected = true;
+    emit(WIFI_EVENT_CONNECTED);
+    emit(WIFI_EVENT_GOT_IP);
+    if (s_portal) {
+        s_portal = false;
+        emit(WIFI_EVENT_AP_STOPPED);
+    }
+}
+
+static void disconnect_event(void *arg) {
+    (void)arg;
+    if (!s_connected) return;
+    s_connected = false;
+    emit(WIFI_EVENT_DISCONNECTED);
+}
+
+static void portal_event(void *arg) {
+    (void)arg;
+    if (s_portal) return;
+    s_portal = true;
+    emit(WIFI_EVENT_AP_STARTED);
+}
+
+void wifi_disconnect(void) {
+    disconnect_event(NULL);
+}
+
+void sim_wifi_connect(void) { sim_post_event(connect_event, NULL); }
+void sim_wifi_disconnect(void) { sim_post_event(disconnect_event, NULL); }
+void sim_wifi_portal(void) { sim_post_event(portal_event, NULL); }
@@ -0,0 +1,328 @@
+#include "sim.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Host simulator entry point: boots the real app_main() on simulated time and
+ * replays a scenario of timed inputs against it.
+ *
+ *   color_alarm_sim [--fresh] [--epoch 2024-01-08T11:40:00Z] [--trace frames.csv]
+ *                   [--clips clips.bin] [--events trace.json] scenario.txt
+ *
+ * --clips backs the clips partition with an image from color_alarm_clipgen.
+ * --events writes the event trace (components/trace) as Chrome trace JSON at
+ * the end of the run, with simulated timestamps.
+ *
+ * Scenario lines are "<time> <command> [args]"; time is since boot (500, 2s,
+ * 7m, 1h) or relative to the previous line (+250, +3s). '#' starts a comment.
+ *
+ *   wifi connect | disconnect | portal
+ *   sntp <epoch | YYYY-MM-DDTHH:MM:SSZ>
+ *   gpio <pin> <level>
+ *   press <pin> <ms> [bounces]       active level for ms, optional contact bounce
+ *   adc <channel> <raw 0..4095>
+ *   frame | tasks | telemetry        log the LED output / task states / telemetry
+ *   shutdown                          run shutdown handlers (flushes) and stop
+ *   end                               stop
+ */
+
+static const char *TAG = "sim";
+
+#define MAX_EVENTS      1024
+#define BOUNCE_US       700         // spacing of injected contact bounces
+#define MAIN_TASK_PRIO  1           // same as the IDF main task
+#define MAIN_TASK_STACK 3584
+
+typedef enum {
+    EV_WIFI, EV_SNTP, EV_GPIO, EV_PRESS, EV_ADC, EV_FRAME, EV_TASKS,
+    EV_TELEMETRY, EV_SHUTDOWN, EV_END
+} ev_kind_t;
+
+typedef struct {
+    int64_t t_us;
+    int seq;                // file order among events at the same time
+    ev_kind_t kind;
+    int a, b, c;
+    int64_t epoch;
+    char word[16];
+} sim_event_t;
+
+static sim_event_t s_events[MAX_EVENTS];
+static int s_event_count = 0;
+static int s_seq = 0;
+
+extern void app_main(void);
+
+static void main_task(void *arg) {
+    (void)arg;
+    app_main();
+}
+
+static bool parse_time(const char *s, int64_t prev_us, int64_t *out) {
+    bool rel = *s == '+';
+    if (rel) s++;
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s) return false;
+    double scale = 1000;                                // ms by default
+    if (strcmp(end, "s") == 0) scale = 1e6;
+    else if (strcmp(end, "m") == 0) scale = 60e6;
+    else if (strcmp(end, "h") == 0) scale = 3600e6;
+    else if (*end && strcmp(end, "ms") != 0) return false;
+    *out = (rel ? prev_us : 0) + (int64_t)(v * scale);
+    return true;
+}
+
+static bool parse_epoch(const char *s, int64_t *out) {
+    struct tm tm = {0};
+    char z = 0;
+    if (sscanf(s, "%d-%d-%dT%d:%d:%d%c", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &z) == 7 && z == 'Z') {
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        *out = (int64_t)timegm(&tm);
+        return true;
+    }
+    char *end;
+    long long v = strtoll(s, &end, 10);
+    if (end == s || *end) return false;
+    *out = v;
+    return true;
+}
+
+static bool add_event(sim_event_t ev) {
+    if (s_event_count >= MAX_EVENTS) return false;
+    ev.seq = s_seq++;
+    s_events[s_event_count++] = ev;
+    return true;
+}
+
+static bool parse_line(char *line, int64_t *prev_us) {
+    char *hash = strchr(line, '#');
+    if (hash) *hash = '\0';
+    char *tok[5] = {0};
+    int n = 0;
+    for (char *p = strtok(line, " \t\r\n"); p && n < 5; p = strtok(NULL, " \t\r\n")) tok[n++] = p;
+    if (n == 0) return true;
+    if (n < 2) return false;
+
+    sim_event_t ev = {0};
+    if (!parse_time(tok[0], *prev_us, &ev.t_us)) return false;
+    *prev_us = ev.t_us;
+    const char *cmd = tok[1];
+    if (strcmp(cmd, "wifi") == 0 && n == 3) {
+        ev.kind = EV_WIFI;
+        snprintf(ev.word, sizeof(ev.word), "%s", tok[2]);
+    } else if (strcmp(cmd, "sntp") == 0 && n == 3) {
+        ev.kind = EV_SNTP;
+        if (!parse_epoch(tok[2], &ev.epoch)) return false;
+    } else if (strcmp(cmd, "gpio") == 0 && n == 4) {
+        ev.kind = EV_GPIO;
+        ev.a = atoi(tok[2]);
+        ev.b = atoi(tok[3]);
+    } else if (strcmp(cmd, "press") == 0 && (n == 4 || n == 5)) {
+        ev.kind = EV_PRESS;
+        ev.a = atoi(tok[2]);
+        ev.b = atoi(tok[3]);
+        ev.c = n == 5 ? atoi(tok[4]) : 0;
+    } else if (strcmp(cmd, "adc") == 0 && n == 4) {
+        ev.kind = EV_ADC;
+        ev.a = atoi(tok[2]);
+        ev.b = atoi(tok[3]);
+    } else if (strcmp(cmd, "frame") == 0) {
+        ev.kind = EV_FRAME;
+    } else if (strcmp(cmd, "tasks") == 0) {
+        ev.kind = EV_TASKS;
+    } else if (strcmp(cmd, "telemetry") == 0) {
+        ev.kind = EV_TELEMETRY;
+    } else if (strcmp(cmd, "shutdown") == 0) {
+        ev.kind = EV_SHUTDOWN;
+    } else if (strcmp(cmd, "end") == 0) {
+        ev.kind = EV_END;
+    } else {
+        return false;
+    }
+    return add_event(ev);
+}
+
+/* Earliest pending event (time, then file order); -1 when none are left */
+static int next_event(void) {
+    int best = -1;
+    for (int i = 0; i < s_event_count; i++) {
+        const sim_event_t *e = &s_events[i];
+        if (best < 0 || e->t_us < s_events[best].t_us ||
+            (e->t_us == s_events[best].t_us && e->seq < s_events[best].seq)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void log_frame(void) {
+    const sim_rmt_capture_t *c = sim_rmt_capture();
+    char hex[3 * 8 + 1] = "";
+    for (size_t i = 0; i < c->len && i < 8; i++) {
+        snprintf(hex + 3 * i, sizeof(hex) - 3 * i, "%02x ", c->data[i]);
+    }
+    unsigned sum = 0;
+    for (size_t i = 0; i < c->len; i++) sum += c->data[i];
+    ESP_LOGI(TAG, "frame #%u at %lld ms: %u bytes, first %s| mean %u, timing errors %u",
+             (unsigned)c->frames, (long long)(c->last_us / 1000), (unsigned)c->len, hex,
+             c->len ? sum / (unsigned)c->len : 0, (unsigned)c->timing_errors);
+}
+
+/* Returns false when the run should stop */
+static bool fire(const sim_event_t *e) {
+    switch (e->kind) {
+        case EV_WIFI:
+            if (strcmp(e->word, "connect") == 0) sim_wifi_connect();
+            else if (strcmp(e->word, "disconnect") == 0) sim_wifi_disconnect();
+            else if (strcmp(e->word, "portal") == 0) sim_wifi_portal();
+            break;
+        case EV_SNTP:
+            sim_sntp_sync(e->epoch);
+            break;
+        case EV_GPIO:
+            sim_gpio_set_level(e->a, e->b);
+            break;
+        case EV_PRESS: {
+            // Press = leave the idle level; bounces chatter before it settles
+            const int idle = sim_gpio_get_level(e->a);
+            sim_event_t edge = { .kind = EV_GPIO, .a = e->a };
+            for (int i = 0; i < 2 * e->c; i++) {
+                edge.t_us = e->t_us + (int64_t)i * BOUNCE_US;
+                edge.b = (i % 2 == 0) ? !idle : idle;
+                add_event(edge);
+            }
+            edge.t_us = e->t_us + (int64_t)2 * e->c * BOUNCE_US;
+            edge.b = !idle;
+            add_event(edge);
+            edge.t_us = e->t_us + (int64_t)e->b * 1000;
+            edge.b = idle;
+            add_event(edge);
+            break;
+        }
+        case EV_ADC:
+            sim_adc_set(e->a, e->b);
+            break;
+        case EV_FRAME:
+            log_frame();
+            break;
+        case EV_TASKS:
+            sim_dump_tasks();
+            break;
+        case EV_TELEMETRY:
+            telemetry_sample_now();
+            telemetry_log_dump();
+            break;
+        case EV_SHUTDOWN:
+            sim_run_shutdown_handlers();
+            return false;
+        case EV_END:
+            return false;
+    }
+    return true;
+}
+
+static bool write_file(const char *data, size_t len, void *ctx) {
+    return fwrite(data, 1, len, ctx) == len;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--fresh] [--epoch <epoch|ISO-UTC>] [--trace frames.csv]\n"
+                    "       [--clips clips.bin] [--events trace.json] scenario.txt\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *scenario = NULL;
+    const char *trace = NULL;
+    const char *clips = NULL;
+    const char *events = NULL;
+    int64_t boot_epoch = 0;
+    bool fresh = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fresh") == 0) fresh = true;
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) trace = argv[++i];
+        else if (strcmp(argv[i], "--clips") == 0 && i + 1 < argc) clips = argv[++i];
+        else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) events = argv[++i];
+        else if (strcmp(argv[i], "--epoch") == 0 && i + 1 < argc) {
+            if (!parse_epoch(argv[++i], &boot_epoch)) usage(argv[0]);
+        } else if (argv[i][0] != '-' && !scenario) scenario = argv[i];
+        else usage(argv[0]);
+    }
+    if (!scenario) usage(argv[0]);
+
+    FILE *f = fopen(scenario, "r");
+    if (!f) {
+        perror(scenario);
+        return 1;
+    }
+    char line[256];
+    int lineno = 0;
+    int64_t prev_us = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        if (!parse_line(line, &prev_us)) {
+            fprintf(stderr, "%s:%d: bad scenario line\n", scenario, lineno);
+            return 2;
+        }
+    }
+    fclose(f);
+
+    // Storage persists in a file like NVS across reboots; --fresh is a blank flash
+    if (fresh) unlink(CONFIG_STORAGE_MANAGER_FILE_PATH);
+    if (trace && !sim_rmt_trace_open(trace)) {
+        perror(trace);
+        return 1;
+    }
+    FILE *events_f = events ? fopen(events, "w") : NULL;
+    if (events && !events_f) {
+        perror(events);
+        return 1;
+    }
+    if (clips && !sim_partition_load(CONFIG_NEOPIXEL_CLIP_PARTITION, clips)) {
+        perror(clips);
+        return 1;
+    }
+
+    struct timespec real0;
+    clock_gettime(CLOCK_MONOTONIC, &real0);
+
+    sim_rtos_init();
+    sim_set_boot_epoch(boot_epoch);
+    xTaskCreate(main_task, "main", MAIN_TASK_STACK, NULL, MAIN_TASK_PRIO, NULL);
+
+    int i;
+    while ((i = next_event()) >= 0) {
+        sim_event_t e = s_events[i];
+        s_events[i] = s_events[--s_event_count];
+        sim_run_until(e.t_us);
+        if (!fire(&e)) break;
+    }
+    // No "end": let work already scheduled at the last event's time finish
+    sim_run_until(sim_now_us());
+
+    struct timespec real1;
+    clock_gettime(CLOCK_MONOTONIC, &real1);
+    const double real_ms = (real1.tv_sec - real0.tv_sec) * 1e3 + (real1.tv_nsec - real0.tv_nsec) / 1e6;
+    const sim_rmt_capture_t *c = sim_rmt_capture();
+    ESP_LOGI(TAG, "done: %.1f s simulated in %.1f ms, %u LED frames, %u timing errors",
+             sim_now_us() / 1e6, real_ms, (unsigned)c->frames, (unsigned)c->timing_errors);
+    sim_rmt_trace_open(NULL);
+    if (events_f && (!trace_dump(write_file, events_f) | (fclose(events_f) != 0))) {
+        fprintf(stderr, "%s: event trace not written (CONFIG_TRACE_ENABLE off?)\n", events);
+    }
+    fflush(stdout);
+    // Task threads are parked inside the scheduler; don't wait for them
+    _exit(c->timing_errors ? 1 : 0);
+}
@@ -0,0 +1,26 @@
+#pragma once
+/* Minimal checks for the host unit tests: report each failure, keep going,
+ * and make main() return non-zero so ctest marks the test failed. */
+#include <stdio.h>
+
+static int s_test_failures = 0;
+
+#define CHECK(cond) do {                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            s_test_failures++;                                                  \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ(a, b) do {                                                     \
+        long long a_ = (long long)(a), b_ = (long long)(b);                     \
+        if (a_ != b_) {                                                         \
+            fprintf(stderr, "%s:%d: %s == %s failed: %lld != %lld\n",           \
+                    __FILE__, __LINE__, #a, #b, a_, b_);                        \
+            s_test_failures++;                                                  \
+        }                                                                       \
+    } while (0)
+
+/** return TEST_RESULT(); at the end of main() */
+#define TEST_RESULT() \
+    (printf("%s: %s\n", __FILE__, s_test_failures ? "FAILED" : "ok"), s_test_failures != 0)
@@ -0,0 +1,183 @@
+/* DDP packet handling: header decoding, the length clamp, sequence gaps
+ * across the 15 -> 1 wrap, and pixel copies with misaligned offsets and
+ * clipping at the end of the strip. */
+#include "anim_ddp.h"
+#include "host_test.h"
+#include <string.h>
+
+#define TYPE_RGB8   0x0B    // C=0 R=0 TTT=1 (RGB) SSS=3 (8 bit)
+#define TYPE_RGBW8  0x1B    // TTT=3 (RGBW)
+
+static size_t packet(uint8_t *buf, uint8_t flags, uint8_t seq, uint8_t type,
+                     uint32_t offset, uint16_t len_field, const uint8_t *data, size_t data_len) {
+    buf[0] = flags;
+    buf[1] = seq;
+    buf[2] = type;
+    buf[3] = 1;
+    buf[4] = (uint8_t)(offset >> 24);
+    buf[5] = (uint8_t)(offset >> 16);
+    buf[6] = (uint8_t)(offset >> 8);
+    buf[7] = (uint8_t)offset;
+    buf[8] = (uint8_t)(len_field >> 8);
+    buf[9] = (uint8_t)len_field;
+    size_t hdr = (flags & DDP_FLAG_TIMECODE) ? DDP_HEADER_LEN + 4 : DDP_HEADER_LEN;
+    memset(buf + DDP_HEADER_LEN, 0xAA, hdr - DDP_HEADER_LEN);
+    if (data_len) memcpy(buf + hdr, data, data_len);
+    return hdr + data_len;
+}
+
+static void test_parse(void) {
+    uint8_t buf[64], data[12];
+    ddp_packet_t p;
+    for (int i = 0; i < 12; i++) data[i] = (uint8_t)(i + 1);
+
+    size_t n = packet(buf, DDP_FLAG_VER1 | DDP_FLAG_PUSH, 0x37, TYPE_RGB8, 0x01020304, 12, data, 12);
+    CHECK(ddp_parse(buf, n, &p));
+    CHECK_EQ(p.flags, DDP_FLAG_VER1 | DDP_FLAG_PUSH);
+    CHECK_EQ(p.seq, 7);                     // low nibble only
+    CHECK_EQ(p.type, TYPE_RGB8);
+    CHECK_EQ(p.offset, 0x01020304);
+    CHECK_EQ(p.len, 12);
+    CHECK(p.data == buf + DDP_HEADER_LEN);
+    CHECK_EQ(ddp_bytes_per_pixel(&p), 3);
+
+    // Length field larger than the datagram: clamped to what arrived
+    n = packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 0, 1000, data, 9);
+    CHECK(ddp_parse(buf, n, &p));
+    CHECK_EQ(p.len, 9);
+    // Smaller than the datagram: the field wins (trailing padding)
+    n = packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 0, 6, data, 12);
+    CHECK(ddp_parse(buf, n, &p));
+    CHECK_EQ(p.len, 6);
+
+    // Timecode adds 4 header bytes before the data
+    n = packet(buf, DDP_FLAG_VER1 | DDP_FLAG_TIMECODE, 1, TYPE_RGBW8, 0, 8, data, 8);
+    CHECK(ddp_parse(buf, n, &p));
+    CHECK(p.data == buf + DDP_HEADER_LEN + 4);
+    CHECK_EQ(p.len, 8);
+    CHECK_EQ(ddp_bytes_per_pixel(&p), 4);
+    CHECK(!ddp_parse(buf, DDP_HEADER_LEN + 3, &p));   // timecode cut short
+
+    // Not DDP v1, or shorter than a header
+    n = packet(buf, 0x80, 1, TYPE_RGB8, 0, 3, data, 3);
+    CHECK(!ddp_parse(buf, n, &p));
+    n = packet(buf, 0x00, 1, TYPE_RGB8, 0, 3, data, 3);
+    CHECK(!ddp_parse(buf, n, &p));
+    n = packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 0, 0, data, 0);
+    CHECK(ddp_parse(buf, n, &p));
+    CHECK_EQ(p.len, 0);
+    CHECK(!ddp_parse(buf, DDP_HEADER_LEN - 1, &p));
+}
+
+static void test_seq_gap(void) {
+    CHECK_EQ(ddp_seq_gap(1, 2), 0);
+    CHECK_EQ(ddp_seq_gap(1, 4), 2);
+    CHECK_EQ(ddp_seq_gap(15, 1), 0);        // wraps 15 -> 1, skipping 0
+    CHECK_EQ(ddp_seq_gap(14, 1), 1);        // 15 lost
+    CHECK_EQ(ddp_seq_gap(15, 2), 1);        // 1 lost
+    CHECK_EQ(ddp_seq_gap(2, 1), 13);        // everything but 1 and 2 lost
+    CHECK_EQ(ddp_seq_gap(5, 5), -1);        // duplicate
+    CHECK_EQ(ddp_seq_gap(0, 5), 0);         // unnumbered sender
+    CHECK_EQ(ddp_seq_gap(5, 0), 0);
+}
+
+#define LEDS    10
+#define GUARD   0xEE
+
+static void test_copy_pixels(void) {
+    const neopixel_format_t *grb = neopixel_format(NEOPIXEL_ORDER_GRB);
+    const neopixel_format_t *grbw = neopixel_format(NEOPIXEL_ORDER_GRBW);
+    uint8_t frame[LEDS * 4 + 8], buf[64], data[24];
+    ddp_packet_t p;
+    for (int i = 0; i < 24; i++) data[i] = (uint8_t)(i + 1);
+
+    // RGB into a GRB strip at pixel 2: reordered, nothing else touched
+    memset(frame, GUARD, sizeof(frame));
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 2 * 3, 6, data, 6);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 6, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grb, &p), 2);
+    const uint8_t want[] = { 2, 1, 3, 5, 4, 6 };
+    CHECK(memcmp(frame + 2 * 3, want, sizeof(want)) == 0);
+    CHECK_EQ(frame[2 * 3 - 1], GUARD);
+    CHECK_EQ(frame[4 * 3], GUARD);
+
+    // Offset not on a pixel boundary: dropped
+    memset(frame, GUARD, sizeof(frame));
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 4, 6, data, 6);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 6, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grb, &p), 0);
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGBW8, 6, 8, data, 8);   // 3-aligned, not 4
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 8, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grb, &p), 0);
+    CHECK_EQ(frame[0], GUARD);
+
+    // Runs past the end of the strip: clipped to the last LED
+    memset(frame, GUARD, sizeof(frame));
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 8 * 3, 15, data, 15);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 15, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grb, &p), 2);
+    CHECK_EQ(frame[LEDS * 3 - 1], 6);
+    CHECK_EQ(frame[LEDS * 3], GUARD);
+
+    // Starts past the end: nothing
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, LEDS * 3, 3, data, 3);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 3, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grb, &p), 0);
+    CHECK_EQ(frame[LEDS * 3], GUARD);
+
+    // A trailing partial pixel is ignored
+    memset(frame, GUARD, sizeof(frame));
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 0, 7, data, 7);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 7, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grb, &p), 2);
+    CHECK_EQ(frame[6], GUARD);
+
+    // A clamped length clips the copy to what actually arrived
+    memset(frame, GUARD, sizeof(frame));
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 0, 30, data, 9);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 9, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grb, &p), 3);
+    CHECK_EQ(frame[9], GUARD);
+
+    // RGBW into an RGBW strip keeps W; RGB into it clears W
+    memset(frame, GUARD, sizeof(frame));
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGBW8, 4, 8, data, 8);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 8, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grbw, &p), 2);
+    const uint8_t want_w[] = { 2, 1, 3, 4, 6, 5, 7, 8 };
+    CHECK(memcmp(frame + 4, want_w, sizeof(want_w)) == 0);
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGB8, 0, 3, data, 3);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 3, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grbw, &p), 1);
+    CHECK_EQ(frame[3], 0);
+
+    // RGBW into a GRB strip folds W into each channel (saturating)
+    const uint8_t rgbw[] = { 10, 20, 250, 10 };
+    memset(frame, GUARD, sizeof(frame));
+    packet(buf, DDP_FLAG_VER1, 1, TYPE_RGBW8, 0, 4, rgbw, 4);
+    CHECK(ddp_parse(buf, DDP_HEADER_LEN + 4, &p));
+    CHECK_EQ(ddp_copy_pixels(frame, LEDS, grb, &p), 1);
+    const uint8_t want_fold[] = { 30, 20, 255 };
+    CHECK(memcmp(frame, want_fold, sizeof(want_fold)) == 0);
+}
+
+static void test_reply(void) {
+    uint8_t buf[32], reply[DDP_HEADER_LEN];
+    ddp_packet_t p;
+    size_t n = packet(buf, DDP_FLAG_VER1 | DDP_FLAG_QUERY, 9, TYPE_RGB8, 0, 0, NULL, 0);
+    CHECK(ddp_parse(buf, n, &p));
+    ddp_build_reply(reply, &p);
+    CHECK_EQ(reply[0], DDP_FLAG_VER1 | DDP_FLAG_REPLY | DDP_FLAG_PUSH);
+    CHECK_EQ(reply[1], 9);
+    CHECK_EQ(reply[2], TYPE_RGB8);
+    CHECK_EQ(reply[3], 1);
+    CHECK_EQ(reply[8] | reply[9], 0);
+}
+
+int main(void) {
+    test_parse();
+    test_seq_gap();
+    test_copy_pixels();
+    test_reply();
+    return TEST_RESULT();
+}
@@ -0,0 +1,104 @@
+/* apa102_encode: frame layout, the 0xE0 | global marker and BGR wire order
+ * for every buffer order, the cap folded into the 5-bit global, and W on
+ * 3- and 4-byte buffers. */
+#include "neopixel_apa102.h"
+#include "host_test.h"
+#include <string.h>
+
+#define GUARD 0xEE
+
+static uint8_t s_out[256];
+
+/* One LED from a 3-byte GRB buffer; returns its 4 wire bytes */
+static const uint8_t *encode_one(uint8_t r, uint8_t g, uint8_t b, uint8_t cap) {
+    const uint8_t grb[3] = { g, r, b };
+    memset(s_out, GUARD, sizeof(s_out));
+    CHECK_EQ(apa102_encode(s_out, sizeof(s_out), grb, 1, neopixel_format(NEOPIXEL_ORDER_GRB), cap),
+             apa102_frame_len(1));
+    return s_out + 4;
+}
+
+static void check_led(const uint8_t *led, uint8_t marker, uint8_t b, uint8_t g, uint8_t r) {
+    CHECK_EQ(led[0], marker);
+    CHECK_EQ(led[1], b);
+    CHECK_EQ(led[2], g);
+    CHECK_EQ(led[3], r);
+}
+
+static void test_frame(void) {
+    // 4 start bytes, 4 per LED, an end frame of 4 bytes plus half a clock per LED
+    CHECK_EQ(apa102_frame_len(0), 8);
+    CHECK_EQ(apa102_frame_len(1), 13);
+    CHECK_EQ(apa102_frame_len(16), 73);
+    CHECK_EQ(apa102_frame_len(17), 78);
+    CHECK_EQ(apa102_frame_len(-3), 8);
+
+    uint8_t px[17 * 3];
+    memset(px, 0x40, sizeof(px));
+    memset(s_out, GUARD, sizeof(s_out));
+    const size_t n = apa102_encode(s_out, sizeof(s_out), px, 17, neopixel_format(NEOPIXEL_ORDER_RGB), 255);
+    CHECK_EQ(n, 78);
+    for (int i = 0; i < 4; i++) CHECK_EQ(s_out[i], 0);
+    for (int i = 0; i < 17; i++) CHECK_EQ(s_out[4 + i * 4] & 0xE0, 0xE0);
+    for (size_t i = 4 + 17 * 4; i < n; i++) CHECK_EQ(s_out[i], 0);
+    CHECK_EQ(s_out[n], GUARD);
+
+    // Too short by one byte: nothing written
+    memset(s_out, GUARD, sizeof(s_out));
+    CHECK_EQ(apa102_encode(s_out, n - 1, px, 17, neopixel_format(NEOPIXEL_ORDER_RGB), 255), 0);
+    CHECK_EQ(s_out[0], GUARD);
+    CHECK_EQ(apa102_encode(s_out, sizeof(s_out), px, 1, NULL, 255), 0);
+}
+
+static void test_orders(void) {
+    // The same color from every buffer layout comes out as B, G, R
+    for (int o = 0; o < NEOPIXEL_ORDER_COUNT; o++) {
+        const neopixel_format_t *fmt = neopixel_format((neopixel_order_t)o);
+        const uint8_t rgb[6] = { 10, 20, 30,  255, 128, 0 };
+        uint8_t px[8];
+        fmt->blit_rgb(px, rgb, 2);
+        memset(s_out, GUARD, sizeof(s_out));
+        CHECK_EQ(apa102_encode(s_out, sizeof(s_out), px, 2, fmt, 255), apa102_frame_len(2));
+        check_led(s_out + 4, 0xE4, 233, 155, 78);       // 30/255 ~ 233/255 * 4/31
+        check_led(s_out + 8, 0xFF, 0, 128, 255);
+    }
+}
+
+static void test_cap(void) {
+    // Full cap, full channel: global 31 and the channels as they are
+    check_led(encode_one(255, 128, 1, 255), 0xFF, 1, 128, 255);
+    // Dim pixels get a small global and channels scaled up to keep resolution
+    check_led(encode_one(8, 4, 2, 255), 0xE1, 62, 124, 248);
+    check_led(encode_one(40, 0, 0, 64), 0xE2, 0, 0, 156);      // 40 * 64/255 ~ 156 * 2/31
+    // The cap lands in the global: half brightness white
+    check_led(encode_one(255, 255, 255, 128), 0xF0, 248, 248, 248);
+    // Cap 0 and black still send a valid LED (global at least 1), all dark
+    check_led(encode_one(255, 255, 255, 0), 0xE1, 0, 0, 0);
+    check_led(encode_one(0, 0, 0, 255), 0xE1, 0, 0, 0);
+}
+
+static void test_white(void) {
+    // 3-byte orders fold W into R, G, B when the pixel is written...
+    const neopixel_format_t *brg = neopixel_format(NEOPIXEL_ORDER_BRG);
+    uint8_t px[4];
+    brg->fill(px, 1, 10, 20, 30, 100);
+    CHECK_EQ(apa102_encode(s_out, sizeof(s_out), px, 1, brg, 255), apa102_frame_len(1));
+    check_led(s_out + 4, 0xF0, 252, 233, 213);                  // as 110, 120, 130
+    brg->fill(px, 1, 200, 20, 30, 100);
+    apa102_encode(s_out, sizeof(s_out), px, 1, brg, 255);
+    check_led(s_out + 4, 0xFF, 130, 120, 255);                  // R saturates
+
+    // ...while on 4-byte buffers the encoder has no W LED to drive
+    const neopixel_format_t *grbw = neopixel_format(NEOPIXEL_ORDER_GRBW);
+    grbw->fill(px, 1, 10, 20, 30, 100);
+    apa102_encode(s_out, sizeof(s_out), px, 1, grbw, 255);
+    check_led(s_out + 4, 0xE4, 233, 155, 78);
+}
+
+int main(void) {
+    test_frame();
+    test_orders();
+    test_cap();
+    test_white();
+    return TEST_RESULT();
+}
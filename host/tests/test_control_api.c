@@ -0,0 +1,316 @@
+/* The control API end to end: form parsing and JSON formatting, then every
+ * handler driven by the stand-in client of the host httpd (shim/httpd_host.c),
+ * running in its own task on simulated time like the device's server. */
+#include "control_api.h"
+#include "control_format.h"
+#include "alarm_manager.h"
+#include "storage_manager.h"
+#include "storage_backend.h"
+#include "time_manager.h"
+#include "sim.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "host_test.h"
+#include <string.h>
+
+#define EPOCH 1767600000            // 2026-01-05T08:00:00Z, a Monday
+#define LEDS  4
+
+static neopixel_t s_strip;
+static sim_http_response_t s_resp;
+
+static struct {
+    int anim_calls;
+    neopixel_anim_mode_t mode;
+    uint8_t r, g, b;
+    int brightness_calls;
+    uint8_t brightness;
+    int elsewhere;          // hook calls not on the dispatcher task
+} s_hooked;
+
+static void check_task(void) {
+    if (strcmp(pcTaskGetName(NULL), "dispatch_task") != 0) s_hooked.elsewhere++;
+}
+
+static void hook_animation(neopixel_anim_mode_t mode, uint8_t r, uint8_t g, uint8_t b, void *user) {
+    check_task();
+    s_hooked.anim_calls++;
+    s_hooked.mode = mode;
+    s_hooked.r = r;
+    s_hooked.g = g;
+    s_hooked.b = b;
+}
+
+static void hook_brightness(uint8_t cap, void *user) {
+    check_task();
+    s_hooked.brightness_calls++;
+    s_hooked.brightness = cap;
+}
+
+static const control_api_hooks_t s_hooks = {
+    .start_animation = hook_animation,
+    .set_brightness = hook_brightness,
+};
+
+static void run_ms(int ms) {
+    sim_run_until(sim_now_us() + (int64_t)ms * 1000);
+}
+
+/* One request, answered before it returns */
+static const sim_http_response_t *request(const char *method, const char *uri, const char *body) {
+    CHECK(sim_http_request(method, uri, body, &s_resp));
+    run_ms(10);
+    CHECK(s_resp.done);
+    return &s_resp;
+}
+
+static bool has(const sim_http_response_t *r, const char *text) {
+    return strstr(r->body, text) != NULL;
+}
+
+static void test_form(void) {
+    char out[16];
+    int v;
+
+    CHECK(control_form_get("id=wake&hour=7", "id", out, sizeof(out)));
+    CHECK(strcmp(out, "wake") == 0);
+    CHECK(control_form_get("idx=1&id=a+b%21%zz", "id", out, sizeof(out)));   // not "idx"
+    CHECK(strcmp(out, "a b!%zz") == 0);                                        // bad escape kept
+    CHECK(control_form_get("id=&x=1", "id", out, sizeof(out)));
+    CHECK(out[0] == '\0');
+    CHECK(!control_form_get("hour=7", "id", out, sizeof(out)));
+    CHECK(!control_form_get("id=0123456789abcdef", "id", out, sizeof(out)));    // no room for NUL
+    CHECK(!control_form_get(NULL, "id", out, sizeof(out)));
+
+    CHECK(control_form_get_int("day=-1", "day", -1, 6, &v));
+    CHECK_EQ(v, -1);
+    CHECK(!control_form_get_int("day=7", "day", -1, 6, &v));
+    CHECK(!control_form_get_int("day=1x", "day", -1, 6, &v));
+    CHECK(!control_form_get_int("day=", "day", -1, 6, &v));
+
+    neopixel_anim_mode_t mode;
+    CHECK(control_parse_anim("rainbow_smooth", &mode));
+    CHECK_EQ(mode, NEOPIXEL_ANIM_RAINBOW_SMOOTH);
+    CHECK(strcmp(control_anim_name(mode), "rainbow_smooth") == 0);
+    CHECK(control_parse_anim("off", &mode));
+    CHECK_EQ(mode, NEOPIXEL_ANIM_NONE);
+    CHECK(!control_parse_anim("Rainbow", &mode));
+}
+
+static void test_format(void) {
+    char buf[64];
+    CHECK_EQ(control_format_result(buf, sizeof(buf), true, NULL), 11);
+    CHECK(strcmp(buf, "{\"ok\":true}") == 0);
+    control_format_result(buf, sizeof(buf), false, "a\"b\\c\n");
+    CHECK(strcmp(buf, "{\"ok\":false,\"msg\":\"a\\\"b\\\\c\\u000a\"}") == 0);
+    CHECK_EQ(control_format_result(buf, 12, true, NULL), 11);
+    CHECK_EQ(control_format_result(buf, 11, true, NULL), -1);      // no room for the NUL
+    CHECK(buf[0] == '\0');
+
+    // GRB on the wire, RGB in the frame; truncated to the whole LEDs that fit
+    const uint8_t grb[] = { 2, 1, 3,  5, 4, 6,  8, 7, 9 };
+    uint8_t frame[3 + 9];
+    CHECK_EQ(control_format_frame(frame, sizeof(frame), grb, 3, neopixel_format(NEOPIXEL_ORDER_GRB)), 12);
+    const uint8_t want[] = { 3, 3, 0,  1, 2, 3,  4, 5, 6,  7, 8, 9 };
+    CHECK(memcmp(frame, want, sizeof(want)) == 0);
+    CHECK_EQ(control_format_frame(frame, 3 + 8, grb, 3, neopixel_format(NEOPIXEL_ORDER_GRB)), 9);
+    CHECK_EQ(frame[1], 2);
+    CHECK_EQ(control_format_frame(frame, 2, grb, 3, neopixel_format(NEOPIXEL_ORDER_GRB)), 0);
+}
+
+static void test_status(void) {
+    const sim_http_response_t *r = request("GET", "/api/status", NULL);
+    CHECK_EQ(r->status, 200);
+    CHECK(strcmp(r->type, "application/json") == 0);
+    CHECK(has(r, "\"now\":1767600"));
+    CHECK(has(r, "\"jitter_hist\":["));
+
+    r = request("GET", "/api/telemetry", NULL);
+    CHECK_EQ(r->status, 200);
+    CHECK(r->body[0] == '{');
+
+    r = request("GET", "/api/trace", NULL);
+    CHECK_EQ(r->status, 200);
+    CHECK(has(r, "\"traceEvents\""));
+    CHECK(!r->truncated);
+    r = request("DELETE", "/api/trace", NULL);
+    CHECK(has(r, "{\"ok\":true}"));
+
+    CHECK_EQ(request("GET", "/api/nope", NULL)->status, 404);
+    CHECK_EQ(request("PUT", "/api/status", NULL)->status, 405);
+}
+
+static void test_alarms(void) {
+    const sim_http_response_t *r = request("POST", "/api/alarms", "id=wake&day=-1&hour=7&minute=30");
+    CHECK_EQ(r->status, 200);
+    CHECK(has(r, "{\"ok\":true}"));
+    r = request("POST", "/api/alarms", "id=we%22ek&day=6&hour=9&minute=0&second=15");
+    CHECK_EQ(r->status, 200);
+    CHECK_EQ(alarm_manager_count(), 2);
+
+    r = request("GET", "/api/alarms", NULL);
+    CHECK_EQ(r->status, 200);
+    CHECK(has(r, "{\"id\":\"wake\",\"day\":-1,\"hour\":7,\"minute\":30,\"second\":0,"));
+    CHECK(has(r, "{\"id\":\"we\\\"ek\",\"day\":6,\"hour\":9,\"minute\":0,\"second\":15,"));
+
+    // Updating an id keeps one entry
+    request("POST", "/api/alarms", "id=wake&day=1&hour=6&minute=45");
+    CHECK_EQ(alarm_manager_count(), 2);
+    CHECK(has(request("GET", "/api/alarms", NULL), "{\"id\":\"wake\",\"day\":1,\"hour\":6,\"minute\":45,"));
+
+    // Bad forms: missing, out of range, empty id, empty and oversized bodies
+    static const char *bad[] = {
+        "id=x&day=1&hour=6",
+        "id=x&day=7&hour=6&minute=0",
+        "id=x&day=1&hour=24&minute=0",
+        "id=&day=1&hour=6&minute=0",
+        "id=0123456789abcdef&day=1&hour=6&minute=0",
+        "",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        r = request("POST", "/api/alarms", bad[i]);
+        CHECK_EQ(r->status, 400);
+        CHECK(has(r, "\"msg\":\"need id, day (-1..6), hour, minute\""));
+    }
+    char big[300];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    memcpy(big, "id=x&day=1&hour=6&minute=0&pad=", 31);
+    CHECK_EQ(request("POST", "/api/alarms", big)->status, 400);
+    CHECK_EQ(alarm_manager_count(), 2);
+
+    // Fill the table
+    char form[64];
+    int added = 0;
+    for (int i = 0; i < 16; i++) {
+        snprintf(form, sizeof(form), "id=a%d&day=-1&hour=5&minute=%d", i, i);
+        r = request("POST", "/api/alarms", form);
+        if (r->status != 200) break;
+        added++;
+    }
+    CHECK(added > 0 && added < 16);
+    CHECK_EQ(r->status, 400);
+    CHECK(has(r, "\"msg\":\"alarm table full\""));
+    CHECK_EQ(alarm_manager_count(), 2 + added);
+
+    r = request("DELETE", "/api/alarms?id=wake", NULL);
+    CHECK_EQ(r->status, 200);
+    CHECK_EQ(alarm_manager_count(), 1 + added);
+    r = request("DELETE", "/api/alarms?id=wake", NULL);
+    CHECK_EQ(r->status, 400);
+    CHECK(has(r, "no such alarm"));
+    r = request("DELETE", "/api/alarms", NULL);
+    CHECK_EQ(r->status, 400);
+    CHECK(has(r, "need ?id="));
+    CHECK_EQ(request("DELETE", "/api/alarms?id=we%22ek", NULL)->status, 200);
+}
+
+static void test_lamp(void) {
+    // The hooks run on the dispatcher, after the 202
+    const sim_http_response_t *r = request("POST", "/api/animation", "mode=fade&r=10&g=20");
+    CHECK_EQ(r->status, 202);
+    CHECK(has(r, "\"msg\":\"fade\""));
+    CHECK_EQ(s_hooked.anim_calls, 1);
+    CHECK_EQ(s_hooked.mode, NEOPIXEL_ANIM_FADE_TO_SOLID);
+    CHECK_EQ(s_hooked.r, 10);
+    CHECK_EQ(s_hooked.g, 20);
+    CHECK_EQ(s_hooked.b, 255);          // default blue
+
+    r = request("POST", "/api/animation", "mode=strobe");
+    CHECK_EQ(r->status, 400);
+    CHECK(has(r, "unknown mode"));
+    CHECK_EQ(request("POST", "/api/animation", NULL)->status, 400);
+    CHECK_EQ(s_hooked.anim_calls, 1);
+
+    CHECK_EQ(request("POST", "/api/brightness", "value=256")->status, 400);
+    CHECK_EQ(request("POST", "/api/brightness", "level=5")->status, 400);
+    CHECK_EQ(s_hooked.brightness_calls, 0);
+    CHECK_EQ(request("POST", "/api/brightness", "value=40")->status, 202);
+    CHECK_EQ(s_hooked.brightness_calls, 1);
+    CHECK_EQ(s_hooked.brightness, 40);
+
+    // Each request gets its own copy of the arguments, even when several queue up
+    sim_http_response_t resp[3];
+    CHECK(sim_http_request("POST", "/api/brightness", "value=1", &resp[0]));
+    CHECK(sim_http_request("POST", "/api/animation", "mode=rainbow", &resp[1]));
+    CHECK(sim_http_request("POST", "/api/brightness", "value=3", &resp[2]));
+    run_ms(10);
+    for (int i = 0; i < 3; i++) CHECK_EQ(resp[i].status, 202);
+    CHECK_EQ(s_hooked.brightness_calls, 3);
+    CHECK_EQ(s_hooked.brightness, 3);
+    CHECK_EQ(s_hooked.anim_calls, 2);
+    CHECK_EQ(s_hooked.mode, NEOPIXEL_ANIM_RAINBOW);
+    CHECK_EQ(s_hooked.elsewhere, 0);
+}
+
+static void test_preview(void) {
+    const int period_ms = 1000 / CONFIG_CONTROL_API_PREVIEW_FPS;
+    neopixel_fill(&s_strip, 0, 0, 0, 0);
+    neopixel_set_pixel(&s_strip, 1, 10, 20, 30, 0);
+
+    static sim_ws_client_t ws;
+    CHECK(sim_ws_open("/ws/frame", &ws));
+    run_ms(period_ms / 2);
+    CHECK(ws.open);
+    CHECK_EQ(ws.frames, 0);             // the first frame waits for the timer
+    run_ms(period_ms);
+    CHECK_EQ(ws.frames, 1);
+    CHECK_EQ(ws.len, 3 + LEDS * 3);
+    const uint8_t head[] = { 3, LEDS, 0,  0, 0, 0,  10, 20, 30 };   // RGB, not wire order
+    CHECK(memcmp(ws.data, head, sizeof(head)) == 0);
+
+    // Unchanged frames are not resent; a change goes out on the next tick
+    run_ms(period_ms * 5);
+    CHECK_EQ(ws.frames, 1);
+    neopixel_set_pixel(&s_strip, 3, 1, 2, 3, 0);
+    run_ms(period_ms);
+    CHECK_EQ(ws.frames, 2);
+    CHECK(ws.data[3 + 9] == 1 && ws.data[3 + 10] == 2 && ws.data[3 + 11] == 3);
+
+    // What the viewer sends is drained and ignored
+    const uint8_t ping[] = { 'h', 'i' };
+    CHECK(sim_ws_send(&ws, ping, sizeof(ping)));
+    run_ms(period_ms);
+    CHECK(ws.open);
+    CHECK_EQ(ws.frames, 2);
+
+    // HTTP requests still get through while a viewer is connected
+    CHECK_EQ(request("GET", "/api/status", NULL)->status, 200);
+
+    // Last viewer gone: the timer stops; a new viewer gets the frame at once
+    sim_ws_close(&ws);
+    run_ms(period_ms * 3);
+    CHECK(!ws.open);
+    static sim_ws_client_t ws2;
+    CHECK(sim_ws_open("/ws/frame", &ws2));
+    run_ms(period_ms + period_ms / 2);
+    CHECK_EQ(ws2.frames, 1);
+    CHECK(memcmp(ws2.data, head, sizeof(head)) == 0);
+    sim_ws_close(&ws2);
+    run_ms(period_ms * 2);
+}
+
+int main(void) {
+    test_form();
+    test_format();
+
+    sim_rtos_init();
+    sim_set_boot_epoch(EPOCH);
+    storage_manager_init_with_backend(storage_backend_mem());
+    time_manager_set_timezone("UTC0");
+    alarm_manager_init();
+    neopixel_init(&s_strip, 5, LEDS, NEOPIXEL_ORDER_GRB);
+    CHECK(control_api_start(&s_strip, &s_hooks));
+    CHECK(control_api_start(&s_strip, &s_hooks));      // again on every GOT_IP
+    run_ms(100);
+
+    test_status();
+    test_alarms();
+    test_lamp();
+    test_preview();
+
+    control_api_stop();
+    CHECK(!sim_http_request("GET", "/api/status", NULL, &s_resp));
+    return TEST_RESULT();
+}
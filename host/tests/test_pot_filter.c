@@ -0,0 +1,172 @@
+/* pot_filter fed with ADC traces sampled the way pot_manager samples them:
+ * the next reading is taken pot_filter_period_ms() after the previous one.
+ * The traces model ESP32 ADC1 readings of a pot: +-24 counts of noise plus
+ * rare full-scale spikes, from a seeded generator so runs are repeatable. */
+#include "pot_filter.h"
+#include "host_test.h"
+#include <stdint.h>
+
+#define ALPHA     80            // pot_manager's defaults
+#define BAND      (4095 * 2 / 100)
+#define FAST_MS   50
+#define SLOW_MS   1000
+
+static uint32_t s_seed;
+
+static int noise(int amplitude) {
+    s_seed = s_seed * 1664525u + 1013904223u;
+    return (int)((s_seed >> 16) % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+static uint16_t adc(int level) {
+    int raw = level + noise(24);
+    if ((s_seed >> 8) % 97 == 0) raw = (s_seed & 0x100) ? 4095 : 0;   // spike
+    return (uint16_t)(raw < 0 ? 0 : raw > 4095 ? 4095 : raw);
+}
+
+typedef struct {
+    int reports;
+    uint16_t last_reported;
+    uint16_t filtered;
+    uint32_t t_ms;
+} replay_t;
+
+/* Sample level(t) until `until_ms`, honouring the filter's adaptive period */
+static void replay(pot_filter_t *f, replay_t *r, int (*level)(uint32_t t_ms), uint32_t until_ms) {
+    while (r->t_ms < until_ms) {
+        if (pot_filter_push(f, adc(level(r->t_ms)), &r->filtered)) {
+            r->reports++;
+            r->last_reported = r->filtered;
+        }
+        r->t_ms += pot_filter_period_ms(f);
+    }
+}
+
+static void test_median_and_iir(void) {
+    pot_filter_t f;
+    uint16_t out = 0;
+    pot_filter_init(&f, ALPHA, BAND, FAST_MS, SLOW_MS);
+    for (int i = 0; i < 5; i++) pot_filter_push(&f, 1000, &out);
+    CHECK_EQ(out, 1000);
+
+    // Single and double spikes never reach the output (median of 5)
+    pot_filter_push(&f, 4095, &out);
+    CHECK_EQ(out, 1000);
+    pot_filter_push(&f, 1000, &out);
+    pot_filter_push(&f, 0, &out);
+    pot_filter_push(&f, 0, &out);
+    CHECK_EQ(out, 1000);
+    for (int i = 0; i < 5; i++) pot_filter_push(&f, 1000, &out);
+
+    // Clean step to 3000: the median passes it on the third sample, then the
+    // IIR closes 20% of the gap per sample
+    pot_filter_push(&f, 3000, &out);
+    CHECK_EQ(out, 1000);
+    pot_filter_push(&f, 3000, &out);
+    CHECK_EQ(out, 1000);
+    pot_filter_push(&f, 3000, &out);
+    CHECK_EQ(out, 1400);
+    pot_filter_push(&f, 3000, &out);
+    CHECK_EQ(out, 1720);
+    uint16_t prev = out;
+    for (int i = 0; i < 60; i++) {
+        pot_filter_push(&f, 3000, &out);
+        CHECK(out >= prev);
+        prev = out;
+    }
+    CHECK_EQ(out, 3000);
+
+    // alpha 0: median only
+    pot_filter_init(&f, 0, BAND, FAST_MS, SLOW_MS);
+    pot_filter_push(&f, 100, &out);
+    pot_filter_push(&f, 200, &out);
+    pot_filter_push(&f, 300, &out);
+    CHECK_EQ(out, 200);
+}
+
+// 49.5%: the filtered value wanders across a whole-percent boundary at rest
+static int rest_on_threshold(uint32_t t) { (void)t; return 2027; }
+
+static void test_hysteresis_at_rest(void) {
+    pot_filter_t f;
+    replay_t r = {0};
+    s_seed = 1;
+    pot_filter_init(&f, ALPHA, BAND, FAST_MS, SLOW_MS);
+    replay(&f, &r, rest_on_threshold, 10 * 60 * 1000);
+    CHECK_EQ(r.reports, 1);                 // the first sample only
+    CHECK(r.last_reported > 2027 - 24 && r.last_reported < 2027 + 24);
+}
+
+// Turned down over 2 s, then rests at the end stop
+static int turn_down(uint32_t t) { return t < 2000 ? 3000 - (int)t * 3000 / 2000 : -10; }
+// Turned up over 2 s, then rests at the top
+static int turn_up(uint32_t t) { return t < 2000 ? 1000 + (int)t * 3200 / 2000 : 4105; }
+
+static void test_end_stops_reachable(void) {
+    pot_filter_t f;
+    replay_t r = {0};
+    s_seed = 2;
+    pot_filter_init(&f, ALPHA, BAND, FAST_MS, SLOW_MS);
+    replay(&f, &r, turn_down, 30 * 1000);
+    CHECK(r.reports > 10);
+    CHECK(r.last_reported <= 4095 / 200);   // noise keeps it a few counts off the rail
+    CHECK_EQ(pot_filter_percent(r.last_reported), 0);
+
+    replay_t u = {0};
+    s_seed = 3;
+    pot_filter_init(&f, ALPHA, BAND, FAST_MS, SLOW_MS);
+    replay(&f, &u, turn_up, 30 * 1000);
+    CHECK(u.last_reported >= 4095 - 4095 / 200);
+    CHECK_EQ(pot_filter_percent(u.last_reported), 100);
+}
+
+static int s_grab_at_ms;
+// Rests at 1500, is moved to 2500 at s_grab_at_ms, rests again
+static int rest_then_move(uint32_t t) {
+    if (t < (uint32_t)s_grab_at_ms) return 1500;
+    if (t < (uint32_t)s_grab_at_ms + 500) return 1500 + (int)(t - s_grab_at_ms) * 2;
+    return 2500;
+}
+
+static void test_adaptive_period(void) {
+    pot_filter_t f;
+    replay_t r = {0};
+    s_seed = 4;
+    s_grab_at_ms = 60 * 1000;
+    pot_filter_init(&f, ALPHA, BAND, FAST_MS, SLOW_MS);
+    CHECK_EQ(pot_filter_period_ms(&f), FAST_MS);
+
+    // At rest the period doubles every 10 quiet samples up to the idle period
+    // (a spike only buys one fast sample to confirm it, not a reset)
+    uint32_t prev = FAST_MS;
+    int confirms = 0;
+    while (r.t_ms < 30 * 1000) {
+        replay(&f, &r, rest_then_move, r.t_ms + 1);
+        CHECK(f.period_ms >= prev);
+        prev = f.period_ms;
+        if (pot_filter_period_ms(&f) != f.period_ms) confirms++;
+    }
+    CHECK(confirms > 0);
+    CHECK_EQ(pot_filter_period_ms(&f), SLOW_MS);
+    // 50+100+200+400+800 ms stages of 10 samples each: idle within ~16 s
+    CHECK_EQ(r.reports, 1);
+
+    // Grabbing the knob snaps back to fast sampling within one idle period
+    replay(&f, &r, rest_then_move, s_grab_at_ms + SLOW_MS + 100);
+    CHECK_EQ(pot_filter_period_ms(&f), FAST_MS);
+    replay(&f, &r, rest_then_move, s_grab_at_ms + 500);
+    CHECK(r.reports > 1);
+
+    // And backs off again once it rests at the new position
+    replay(&f, &r, rest_then_move, s_grab_at_ms + 60 * 1000);
+    CHECK_EQ(pot_filter_period_ms(&f), SLOW_MS);
+    CHECK(r.last_reported > 2500 - BAND && r.last_reported < 2500 + BAND);
+}
+
+int main(void) {
+    test_median_and_iir();
+    test_hysteresis_at_rest();
+    test_end_stops_reachable();
+    test_adaptive_period();
+    return TEST_RESULT();
+}
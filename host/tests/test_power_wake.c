@@ -0,0 +1,54 @@
+/* power_next_wake_us: the earliest deadline wins, rendering means no sleep,
+ * past deadlines clamp to now, and missing sources are ignored. */
+#include "power_wake.h"
+#include "host_test.h"
+#include <string.h>
+
+#define NOW 1000000
+
+static int64_t wake(bool render, int64_t alarm, int64_t pot, power_wake_reason_t *why) {
+    const power_wake_inputs_t in = {
+        .render_active = render, .alarm_wake_us = alarm, .pot_next_sample_us = pot
+    };
+    return power_next_wake_us(&in, NOW, why);
+}
+
+int main(void) {
+    power_wake_reason_t why;
+
+    CHECK_EQ(wake(false, -1, -1, &why), INT64_MAX);
+    CHECK_EQ(why, POWER_WAKE_NONE);
+
+    CHECK_EQ(wake(false, NOW + 5000, -1, &why), NOW + 5000);
+    CHECK_EQ(why, POWER_WAKE_ALARM);
+    CHECK_EQ(wake(false, -1, NOW + 50000, &why), NOW + 50000);
+    CHECK_EQ(why, POWER_WAKE_POT);
+
+    // Earliest of the two, whichever order they come in
+    CHECK_EQ(wake(false, NOW + 5000, NOW + 50000, &why), NOW + 5000);
+    CHECK_EQ(why, POWER_WAKE_ALARM);
+    CHECK_EQ(wake(false, NOW + 60000, NOW + 50000, &why), NOW + 50000);
+    CHECK_EQ(why, POWER_WAKE_POT);
+    CHECK_EQ(wake(false, NOW + 7000, NOW + 7000, &why), NOW + 7000);
+    CHECK_EQ(why, POWER_WAKE_ALARM);        // a tie goes to the alarm
+
+    // Overdue deadlines mean "now", but keep their reason
+    CHECK_EQ(wake(false, NOW - 200, NOW + 50000, &why), NOW);
+    CHECK_EQ(why, POWER_WAKE_ALARM);
+    CHECK_EQ(wake(false, 0, -1, &why), NOW);    // 0 is a deadline, not "none"
+    CHECK_EQ(why, POWER_WAKE_ALARM);
+
+    // Rendering overrides everything
+    CHECK_EQ(wake(true, NOW + 5000, NOW + 50000, &why), NOW);
+    CHECK_EQ(why, POWER_WAKE_RENDER);
+    CHECK_EQ(wake(true, -1, -1, &why), NOW);
+    CHECK_EQ(why, POWER_WAKE_RENDER);
+
+    CHECK_EQ(wake(false, NOW + 1, -1, NULL), NOW + 1);   // reason is optional
+
+    CHECK(strcmp(power_wake_reason_str(POWER_WAKE_NONE), "none") == 0);
+    CHECK(strcmp(power_wake_reason_str(POWER_WAKE_RENDER), "render") == 0);
+    CHECK(strcmp(power_wake_reason_str(POWER_WAKE_ALARM), "alarm") == 0);
+    CHECK(strcmp(power_wake_reason_str(POWER_WAKE_POT), "pot") == 0);
+    return TEST_RESULT();
+}
@@ -0,0 +1,93 @@
+/* time_tz against glibc for US Eastern time in 2026: DST starts Sunday
+ * 8 March at 02:00 EST (07:00 UTC) and ends Sunday 1 November at 02:00 EDT
+ * (06:00 UTC). */
+#include "time_tz.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <time.h>
+
+static time_t utc(int y, int mon, int d, int h, int mi, int s) {
+    struct tm tm = { .tm_year = y - 1900, .tm_mon = mon - 1, .tm_mday = d,
+                     .tm_hour = h, .tm_min = mi, .tm_sec = s };
+    return timegm(&tm);
+}
+
+static void test_transitions(void) {
+    CHECK_EQ(tz_next_transition(utc(2026, 1, 1, 0, 0, 0), 400 * 86400), utc(2026, 3, 8, 7, 0, 0));
+    CHECK_EQ(tz_next_transition(utc(2026, 3, 8, 7, 0, 0), 400 * 86400), utc(2026, 11, 1, 6, 0, 0));
+    CHECK_EQ(tz_utc_offset_at(utc(2026, 3, 8, 6, 59, 59), NULL), -5 * 3600);
+    CHECK_EQ(tz_utc_offset_at(utc(2026, 3, 8, 7, 0, 0), NULL), -4 * 3600);
+}
+
+static void test_spring_forward(void) {
+    // 02:30 does not exist on 8 March: it fires at 03:30 EDT, one gap later
+    const time_t midnight = utc(2026, 3, 8, 5, 0, 0);     // 00:00 EST
+    const time_t fire = utc(2026, 3, 8, 7, 30, 0);        // 03:30 EDT
+    CHECK_EQ(tz_next_local_occurrence(midnight, -1, 2, 30, 0), fire);
+    CHECK_EQ(tz_next_local_occurrence(midnight, 0, 2, 30, 0), fire);   // Sundays only
+    // After it fired, the next one is 02:30 EDT the following day
+    CHECK_EQ(tz_next_local_occurrence(fire, -1, 2, 30, 0), utc(2026, 3, 9, 6, 30, 0));
+    // Times either side of the gap keep their own offset
+    CHECK_EQ(tz_next_local_occurrence(midnight, -1, 1, 59, 59), utc(2026, 3, 8, 6, 59, 59));
+    CHECK_EQ(tz_next_local_occurrence(midnight, -1, 3, 0, 0), utc(2026, 3, 8, 7, 0, 0));
+}
+
+static void test_fall_back(void) {
+    // 01:30 happens twice on 1 November; the alarm fires at the first (EDT) one only
+    const time_t midnight = utc(2026, 11, 1, 4, 0, 0);    // 00:00 EDT
+    const time_t first = utc(2026, 11, 1, 5, 30, 0);      // 01:30 EDT
+    CHECK_EQ(tz_next_local_occurrence(midnight, -1, 1, 30, 0), first);
+    const time_t next = tz_next_local_occurrence(first, -1, 1, 30, 0);
+    CHECK(next != utc(2026, 11, 1, 6, 30, 0));            // not the repeated 01:30 EST
+    CHECK_EQ(next, utc(2026, 11, 2, 6, 30, 0));
+    // Asked from inside the repeated hour, it is already tomorrow's
+    CHECK_EQ(tz_next_local_occurrence(utc(2026, 11, 1, 6, 15, 0), -1, 1, 30, 0), next);
+}
+
+static void test_invalid(void) {
+    CHECK_EQ(tz_next_local_occurrence(0, 7, 0, 0, 0), -1);
+    CHECK_EQ(tz_next_local_occurrence(0, -1, 24, 0, 0), -1);
+    CHECK_EQ(tz_next_local_occurrence(0, -1, 0, 60, 0), -1);
+}
+
+static void check_cached(tz_cache_t *c, time_t t) {
+    struct tm want, got;
+    localtime_r(&t, &want);
+    tz_cache_localtime(c, t, &got);
+    if (got.tm_year != want.tm_year || got.tm_mon != want.tm_mon ||
+        got.tm_mday != want.tm_mday || got.tm_hour != want.tm_hour ||
+        got.tm_min != want.tm_min || got.tm_sec != want.tm_sec ||
+        got.tm_wday != want.tm_wday || got.tm_yday != want.tm_yday ||
+        (got.tm_isdst > 0) != (want.tm_isdst > 0)) {
+        fprintf(stderr, "cache disagrees with localtime_r at %lld\n", (long long)t);
+        s_test_failures++;
+    }
+}
+
+static void test_cache_matches_localtime(void) {
+    tz_cache_t c;
+    tz_cache_invalidate(&c);
+    // Every 17 minutes through the year, so hours, days and both transitions are crossed
+    for (time_t t = utc(2026, 1, 1, 0, 0, 0); t < utc(2027, 1, 1, 0, 0, 0); t += 17 * 60) {
+        check_cached(&c, t);
+    }
+    // Second by second across each transition
+    const time_t edges[] = { utc(2026, 3, 8, 7, 0, 0), utc(2026, 11, 1, 6, 0, 0) };
+    for (int i = 0; i < 2; i++) {
+        for (time_t t = edges[i] - 3; t <= edges[i] + 3; t++) check_cached(&c, t);
+    }
+    // Going backwards (clock stepped back) refreshes the window too
+    check_cached(&c, utc(2026, 6, 1, 12, 0, 0));
+    check_cached(&c, utc(2026, 2, 1, 12, 0, 0));
+}
+
+int main(void) {
+    setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+    tzset();
+    test_transitions();
+    test_spring_forward();
+    test_fall_back();
+    test_invalid();
+    test_cache_matches_localtime();
+    return TEST_RESULT();
+}
@@ -0,0 +1,106 @@
+/* trace_ring: oldest-first reads, overwrite and dropped accounting across
+ * wraparound, clear, and slots a writer has claimed but not yet published. */
+#include "trace_ring.h"
+#include "host_test.h"
+#include <string.h>
+
+#define LEN 8
+
+static trace_slot_t s_slots[LEN];
+static trace_ring_t s_ring;
+
+typedef struct {
+    int n;
+    uint32_t args[4 * LEN];
+    int stop_after;         // 0 = read everything
+} seen_t;
+
+static bool collect(const trace_event_t *ev, void *ctx) {
+    seen_t *s = ctx;
+    s->args[s->n++] = ev->arg;
+    return s->stop_after == 0 || s->n < s->stop_after;
+}
+
+static void push(uint32_t arg) {
+    const trace_event_t ev = { .ts_us = arg, .name = "ev", .arg = arg, .phase = 'i' };
+    trace_ring_push(&s_ring, &ev);
+}
+
+static seen_t read_all(void) {
+    seen_t s = {0};
+    CHECK(trace_ring_read(&s_ring, collect, &s));
+    return s;
+}
+
+/* Events first..last (inclusive) in order */
+static void check_args(const seen_t *s, uint32_t first, uint32_t last) {
+    CHECK_EQ(s->n, last - first + 1);
+    for (int i = 0; i < s->n; i++) CHECK_EQ(s->args[i], first + (uint32_t)i);
+}
+
+int main(void) {
+    memset(s_slots, 0xA5, sizeof(s_slots));
+    trace_ring_init(&s_ring, s_slots, LEN);
+    seen_t s = read_all();
+    CHECK_EQ(s.n, 0);
+    CHECK_EQ(trace_ring_dropped(&s_ring), 0);
+
+    // Partly full, then exactly full: nothing lost
+    for (uint32_t i = 0; i < 5; i++) push(i);
+    s = read_all();
+    check_args(&s, 0, 4);
+    for (uint32_t i = 5; i < LEN; i++) push(i);
+    s = read_all();
+    check_args(&s, 0, LEN - 1);
+    CHECK_EQ(trace_ring_dropped(&s_ring), 0);
+
+    // Wrapped: the newest LEN remain and the rest count as dropped
+    for (uint32_t i = LEN; i < 21; i++) push(i);
+    s = read_all();
+    check_args(&s, 21 - LEN, 20);
+    CHECK_EQ(trace_ring_dropped(&s_ring), 21 - LEN);
+
+    // A visitor can stop the walk
+    s = (seen_t){ .stop_after = 3 };
+    CHECK(!trace_ring_read(&s_ring, collect, &s));
+    check_args(&s, 21 - LEN, 21 - LEN + 2);
+
+    // Clear forgets the events and the drop count; later events count from there
+    trace_ring_clear(&s_ring);
+    s = read_all();
+    CHECK_EQ(s.n, 0);
+    CHECK_EQ(trace_ring_dropped(&s_ring), 0);
+    for (uint32_t i = 100; i < 103; i++) push(i);
+    s = read_all();
+    check_args(&s, 100, 102);
+    CHECK_EQ(trace_ring_dropped(&s_ring), 0);
+    for (uint32_t i = 103; i < 112; i++) push(i);
+    s = read_all();
+    check_args(&s, 112 - LEN, 111);
+    CHECK_EQ(trace_ring_dropped(&s_ring), 12 - LEN);
+
+    // A writer that claimed a slot but has not published it (seq still 0,
+    // as trace_ring_push leaves it mid-write) is skipped, not reported
+    const uint32_t claimed = atomic_fetch_add(&s_ring.head, 1);
+    atomic_store(&s_slots[claimed & (LEN - 1)].seq, 0);
+    push(200);
+    s = read_all();
+    CHECK_EQ(s.n, LEN - 1);
+    CHECK_EQ(s.args[s.n - 1], 200);
+    for (int i = 0; i < s.n - 1; i++) CHECK_EQ(s.args[i], 114 - LEN + (uint32_t)i);
+
+    // A slot that still holds a lapped event (older sequence) is skipped too
+    const uint32_t stale = atomic_load(&s_ring.head) - 3;
+    atomic_store(&s_slots[stale & (LEN - 1)].seq, stale + 1 - LEN);
+    s = read_all();
+    CHECK_EQ(s.n, LEN - 2);
+
+    // Once the writer finishes, its event shows up in place
+    s_slots[claimed & (LEN - 1)].ev = (trace_event_t){ .arg = 199 };
+    atomic_store(&s_slots[claimed & (LEN - 1)].seq, claimed + 1);
+    s = read_all();
+    CHECK_EQ(s.n, LEN - 1);
+    CHECK_EQ(s.args[s.n - 2], 199);
+    CHECK_EQ(s.args[s.n - 1], 200);
+    return TEST_RESULT();
+}
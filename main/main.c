@@ -1,6 +1,7 @@
 
 #include "esp_log.h"
 #include "storage_manager.h"
+#include "storage_settings.h"
 #include "wifi_manager.h"
 #include "time_manager.h"
 #include "neopixel_driver.h"
@@ -8,79 +9,225 @@
 #include "alarm_manager.h"
 #include "button_manager.h"
 #include "pot_manager.h"
+#include "power_manager.h"
+#include "event_dispatcher.h"
+#include "control_api.h"
+#include "telemetry.h"
+#include "benchmark.h"
+#include "trace.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
 
 #define BUTTON_PIN 18
 #define POT_CH ADC1_CHANNEL_6
 #define LED_PIN 15
 #define LED_COUNT 32
+#if CONFIG_NEOPIXEL_STRIP_ORDER_GRB
+#define LED_ORDER NEOPIXEL_ORDER_GRB
+#elif CONFIG_NEOPIXEL_STRIP_ORDER_RGB
+#define LED_ORDER NEOPIXEL_ORDER_RGB
+#elif CONFIG_NEOPIXEL_STRIP_ORDER_BRG
+#define LED_ORDER NEOPIXEL_ORDER_BRG
+#elif CONFIG_NEOPIXEL_STRIP_ORDER_RGBW
+#define LED_ORDER NEOPIXEL_ORDER_RGBW
+#else
+#define LED_ORDER NEOPIXEL_ORDER_GRBW
+#endif
+#if CONFIG_NEOPIXEL_LAYOUT_SERPENTINE
+#define LED_SERPENTINE true
+#else
+#define LED_SERPENTINE false
+#endif
+#define POWER_REPORT_PERIOD_MS (10 * 60 * 1000)
+#define LAMP_TIMER_MS (15 * 60 * 1000)
+#define TIMEZONE "EST5EDT,M3.2.0/2,M11.1.0/2"
+#define WAKE_CLIP "wake_rainbow"    // prerendered 12 s rainbow loop; computed live if not flashed
+
+// Write-behind settings (RAM cache, debounced NVS flush)
+#define SETTING_BRIGHTNESS "brightness"
+#define SETTING_LAMP_ON    "lamp_on"
+#define SETTING_ANIM       "anim"
+#define SETTING_LAYOUT     "led_layout"     // anim_geometry.h blob; overrides the Kconfig layout
 
 static const char *TAG = "MAIN";
 static neopixel_t strip;
+static anim_geometry_t geometry;
 
 int timer_id = -1;
 bool button_on = false;
 uint8_t g_brightness = 255;
 
 bool time_manager_ready = false;
+static bool lamp_restored = false;
+
+static void save_lamp_state(bool on, neopixel_anim_mode_t anim) {
+    button_on = on;
+    storage_settings_set(SETTING_LAMP_ON, on);
+    storage_settings_set(SETTING_ANIM, anim);
+}
 
 static void wake_alarm_handler(void *user_data) {
+    TRACE_BEGIN("wake_alarm", 0);
     ESP_LOGI(TAG, "Wake up alarm triggered → starting wake animation!");
     // neopixel_animations_fade_to(&strip, 255, 100, 0, 0, 2000);
     neopixel_set_brightness_cap(255);
-    neopixel_animations_rainbow_smooth_start(&strip, 12000, false, 255, 255);  // rainbow!
-    button_on = true;
+    if (!neopixel_animations_clip_start(&strip, WAKE_CLIP)) {
+        neopixel_animations_rainbow_smooth_start(&strip, 12000, false, 255, 255);  // rainbow!
+    }
+    save_lamp_state(true, NEOPIXEL_ANIM_RAINBOW_SMOOTH);
+    TRACE_END("wake_alarm", 0);
 }
 
 static void timer_done(void *user) {
+    TRACE_INSTANT("lamp_timer", 0);
     neopixel_animations_fade_to(&strip, 0, 0, 0, 0, 3000);
-    button_on = false;
+    save_lamp_state(false, NEOPIXEL_ANIM_NONE);
+}
+
+static void lamp_on(void) {
+    neopixel_set_brightness_cap(g_brightness);
+    neopixel_animations_fade_to(&strip, 0, 0, 0, 255, 2000);
+    timer_id = alarm_manager_start_timer(LAMP_TIMER_MS, timer_done, NULL);
+    save_lamp_state(true, NEOPIXEL_ANIM_FADE_TO_SOLID);
 }
 
 static void on_button_change(void *user) {
-    button_on = !button_on;
     // Treat any edge as a "press" event
+    TRACE_BEGIN("on_button", button_on);
     alarm_manager_cancel_timer(timer_id);
     ESP_LOGI("MAIN", "Button pressed! level=%d", button_manager_get_level());
     neopixel_animations_stop(&strip);
-    neopixel_set_brightness_cap(g_brightness);
-    if (button_on == true)
-    {
-        neopixel_animations_fade_to(&strip, 0, 0, 0, 255, 2000);
-        timer_id = alarm_manager_start_timer(15 * 60 * 1000, timer_done, NULL);
+    if (!button_on) {
+        lamp_on();
     } else {
+        neopixel_set_brightness_cap(g_brightness);
         neopixel_animations_fade_to(&strip, 0, 0, 0, 0, 3000); // fade to black
+        save_lamp_state(false, NEOPIXEL_ANIM_NONE);
     }
+    TRACE_END("on_button", button_on);
 }
 
 static void on_pot_change(uint16_t raw, uint8_t pct, void *user) {
     // Map 0..100% → 0..255 cap
     g_brightness = (uint8_t)((pct * 240U) / 100U) + 15;
+    TRACE_INSTANT("on_pot", g_brightness);
     ESP_LOGI(TAG, "brightness set to %d", g_brightness);
+    neopixel_set_brightness_cap(g_brightness);   // slews in on the render loop's frames
+    storage_settings_set(SETTING_BRIGHTNESS, g_brightness);  // RAM only; flushed once the knob rests
+}
+
+/* Bring the lamp back to the state it was in before the last reboot */
+static void restore_lamp_state(void) {
+    if (lamp_restored) return;
+    lamp_restored = true;
+    bool was_on = storage_settings_get(SETTING_LAMP_ON, 0) != 0;
+    int32_t anim = storage_settings_get(SETTING_ANIM, NEOPIXEL_ANIM_NONE);
+    ESP_LOGI(TAG, "Restoring lamp: %s (anim %d)", was_on ? "on" : "off", (int)anim);
+    if (!was_on) {
+        neopixel_animations_fade_to(&strip, 0, 0, 0, 0, 3000);
+        button_on = false;
+    } else if (anim == NEOPIXEL_ANIM_RAINBOW_SMOOTH) {
+        wake_alarm_handler(NULL);
+    } else if (anim == NEOPIXEL_ANIM_CLIP) {
+        neopixel_set_brightness_cap(g_brightness);
+        neopixel_animations_start(&strip, NEOPIXEL_ANIM_CLIP, 0, 0, 0);
+        button_on = true;
+    } else {
+        lamp_on();
+    }
+}
+
+/* Layout for the 2D/ring effects: a stored one if valid, else Kconfig */
+static void load_geometry(void) {
+    static uint8_t blob[ANIM_LAYOUT_LEN(LED_COUNT)];
+    anim_layout_t layout = {
+#if CONFIG_NEOPIXEL_LAYOUT_RING
+        .kind = ANIM_LAYOUT_RING,
+        .rotation = (uint16_t)(CONFIG_NEOPIXEL_LAYOUT_RING_ROTATION * 65536 / 360),
+#elif CONFIG_NEOPIXEL_LAYOUT_MATRIX
+        .kind = ANIM_LAYOUT_MATRIX,
+        .width = CONFIG_NEOPIXEL_LAYOUT_MATRIX_WIDTH,
+        .serpentine = LED_SERPENTINE,
+#else
+        .kind = ANIM_LAYOUT_LINE,
+#endif
+    };
+    size_t len = 0;
+    if (storage_manager_get_blob(SETTING_LAYOUT, blob, sizeof(blob), &len) &&
+        !anim_layout_parse(blob, len, LED_COUNT, &layout)) {
+        ESP_LOGW(TAG, "Stored layout does not fit %d LEDs; using the configured one", LED_COUNT);
+    }
+    if (anim_geometry_build(&geometry, &layout, LED_COUNT)) {
+        neopixel_animations_set_geometry(&geometry);
+    } else {
+        ESP_LOGW(TAG, "LED layout %d does not fit %d LEDs; effects treat it as a line",
+                 (int)layout.kind, LED_COUNT);
+    }
+}
+
+/* Control API hooks (dispatcher task, posted by control_api like button events) */
+static void api_start_animation(neopixel_anim_mode_t mode, uint8_t r, uint8_t g, uint8_t b,
+                                void *user) {
+    alarm_manager_cancel_timer(timer_id);
+    neopixel_animations_stop(&strip);
     neopixel_set_brightness_cap(g_brightness);
-    neopixel_show(&strip);            // <- force a resend so cap takes effect now
+    switch (mode) {
+        case NEOPIXEL_ANIM_NONE:
+            neopixel_animations_fade_to(&strip, 0, 0, 0, 0, 3000);
+            save_lamp_state(false, NEOPIXEL_ANIM_NONE);
+            return;
+        case NEOPIXEL_ANIM_FADE_TO_SOLID:
+            neopixel_animations_fade_to(&strip, r, g, b, 0, 2000);
+            break;
+        case NEOPIXEL_ANIM_RAINBOW_SMOOTH:
+            neopixel_animations_rainbow_smooth_start(&strip, 12000, false, 255, 255);
+            break;
+        default:
+            neopixel_animations_start(&strip, mode, r, g, b);
+            break;
+    }
+    save_lamp_state(true, mode);
+}
+
+static void api_set_brightness(uint8_t cap, void *user) {
+    g_brightness = cap;
+    neopixel_set_brightness_cap(cap);
+    storage_settings_set(SETTING_BRIGHTNESS, cap);
 }
 
+static const control_api_hooks_t api_hooks = {
+    .start_animation = api_start_animation,
+    .set_brightness = api_set_brightness,
+};
+
 static void time_synced(void *user) {
+    TRACE_BEGIN("time_synced", time_manager_ready);
     ESP_LOGI(TAG, "Time synced callback");
-    // When time is synced, you might change LED state to solid green, etc.
-    neopixel_animations_fade_to(&strip, 0, 0, 0, 0, 3000);
-    button_on = false;
+    restore_lamp_state();   // first sync ends the boot animation (unless fast start did)
     time_manager_ready = true;
+    alarm_manager_reschedule();   // clock just became valid/stepped
+    TRACE_END("time_synced", 0);
 }
 
 static void wifi_event_handler(wifi_manager_event_t event, void *user_data) {
     switch (event) {
         case WIFI_EVENT_GOT_IP:
             ESP_LOGI(TAG, "WiFi got IP, %s", (time_manager_ready == false) ? "starting SNTP..." : "reconnect success");
+            control_api_start(&strip, &api_hooks);
             if (time_manager_ready == false) {
                 time_manager_init("pool.ntp.org",
-                                "EST5EDT,M3.2.0/2,M11.1.0/2",
+                                TIMEZONE,
                                 time_synced, NULL);
             }
             break;
         case WIFI_EVENT_AP_STARTED:
             ESP_LOGI(TAG, "Captive portal active (SSID: ESP32_Config).");
             break;
+        case WIFI_EVENT_AP_STOPPED:
+            ESP_LOGI(TAG, "Captive portal closed.");
+            break;
         case WIFI_EVENT_DISCONNECTED:
             ESP_LOGI(TAG, "WiFi disconnected!");
             break;
@@ -88,9 +235,39 @@ static void wifi_event_handler(wifi_manager_event_t event, void *user_data) {
     }
 }
 
+static void power_report_job(void *user) {
+    int64_t now = esp_timer_get_time();
+    power_wake_inputs_t in = {
+        .render_active = neopixel_animations_is_active(),
+        .alarm_wake_us = alarm_manager_next_wake_us(),
+        .pot_next_sample_us = now + (int64_t)pot_manager_get_sample_period_ms() * 1000,
+    };
+    power_manager_log_report(&in);
+    event_dispatcher_log_memory();
+}
+
+static void power_report_timer_cb(TimerHandle_t t) {
+    event_dispatcher_post(power_report_job, NULL, DISPATCH_PRIO_LOW, "power_report");
+}
+
 void app_main(void) {
     // Init storage (NVS)
     storage_manager_init();
+#if CONFIG_STORAGE_MANAGER_BENCH_ON_BOOT
+    storage_manager_run_benchmark(20, 4);
+#endif
+    storage_settings_init(0);   // default debounce; also flushes on esp_restart()
+#if CONFIG_BENCHMARK_ON_BOOT
+    benchmark_run_and_log();    // before the render task owns the LED driver
+#endif
+
+    // Automatic light sleep whenever no animation holds the render PM lock
+    if (power_manager_init()) {
+        event_dispatcher_init();
+        TimerHandle_t report = xTimerCreate("pm_report", pdMS_TO_TICKS(POWER_REPORT_PERIOD_MS),
+                                            pdTRUE, NULL, power_report_timer_cb);
+        if (report) xTimerStart(report, 0);
+    }
 
     // Button
     button_manager_init(BUTTON_PIN,
@@ -99,38 +276,60 @@ void app_main(void) {
                     50,     // debounce (ms)
                     on_button_change,
                     NULL);
+    button_manager_enable_wakeup();   // button edges wake the CPU from light sleep
     
     // Potentiometer
     pot_manager_init(POT_CH, 50, on_pot_change, NULL); // 50ms polling, notify on ~2% delta
 
-    g_brightness = pot_manager_get_percent();
+    // Last brightness until the pot task reports its first reading
+    g_brightness = (uint8_t)storage_settings_get(SETTING_BRIGHTNESS, 255);
 
     // LEDs
-    neopixel_init(&strip, LED_PIN, LED_COUNT, NEOPIXEL_ORDER_GRBW);
-    neopixel_fill(&strip, 0, 0, 10, 0);
-    neopixel_show(&strip);
+#if CONFIG_NEOPIXEL_STRIP_APA102
+    neopixel_init_apa102(&strip, LED_PIN, CONFIG_NEOPIXEL_APA102_CLK_GPIO, LED_COUNT, LED_ORDER,
+                         CONFIG_NEOPIXEL_APA102_CLOCK_HZ);
+#else
+    neopixel_init(&strip, LED_PIN, LED_COUNT, LED_ORDER);
+#endif
+    load_geometry();
+    // No neopixel_show() here: the render task sends the first frame at once,
+    // and the RMT interrupt follows it onto its core
     neopixel_animations_start(&strip, NEOPIXEL_ANIM_BREATH, 0, 0, 255); // blue breathing while booting
 
     // WiFi (loads saved creds or starts captive portal)
     wifi_manager_init(wifi_event_handler, NULL);
 
-    // Alarms (persistent)
+    // Alarms are local wall-clock times; set the TZ rule before anything schedules
+    time_manager_set_timezone(TIMEZONE);
+    // Fast start: estimated clock from RTC/NVS until SNTP slews it into place
+    time_quality_t boot_clock = time_manager_restore();
+
+    // Alarms (persistent) - restored from NVS; seed the default schedule on first boot
     alarm_manager_init();
+    alarm_manager_set_default_callback(wake_alarm_handler, NULL);
+    if (boot_clock >= TIME_QUALITY_RTC) restore_lamp_state();   // no need to wait for SNTP
+
+    // Per-task CPU/stack, heap and counters into a ring (log dump / GET /api/telemetry)
+    telemetry_start(0);
+
+    if (alarm_manager_count() == 0) {
+        alarm_time_t weekend_alarm = { .day = 0, .hour = 7, .minute = 30, .second = 0 };
+        alarm_manager_set_alarm("sunday", weekend_alarm, wake_alarm_handler, NULL);
+        weekend_alarm.day = 6;
+        alarm_manager_set_alarm("saturday", weekend_alarm, wake_alarm_handler, NULL);
 
-    alarm_time_t weekend_alarm = { .day = 0, .hour = 7, .minute = 30, .second = 0 };
-    alarm_manager_set_alarm("sunday", weekend_alarm, wake_alarm_handler, NULL);
-    weekend_alarm.day = 6;
-    alarm_manager_set_alarm("saturday", weekend_alarm, wake_alarm_handler, NULL);
-
-    alarm_time_t weekday_alarm = { .day = 1, .hour = 6, .minute = 45, .second = 0 };
-    alarm_manager_set_alarm("monday", weekday_alarm, wake_alarm_handler, NULL);
-    weekday_alarm.day = 2;
-    alarm_manager_set_alarm("tuesday", weekday_alarm, wake_alarm_handler, NULL);
-    weekday_alarm.day = 3;
-    alarm_manager_set_alarm("wednesday", weekday_alarm, wake_alarm_handler, NULL);
-    weekday_alarm.day = 4;
-    alarm_manager_set_alarm("thursday", weekday_alarm, wake_alarm_handler, NULL);
-    weekday_alarm.day = 5;
-    alarm_manager_set_alarm("friday", weekday_alarm, wake_alarm_handler, NULL);
-    ESP_LOGI(TAG, "Alarms set.");
+        alarm_time_t weekday_alarm = { .day = 1, .hour = 6, .minute = 45, .second = 0 };
+        alarm_manager_set_alarm("monday", weekday_alarm, wake_alarm_handler, NULL);
+        weekday_alarm.day = 2;
+        alarm_manager_set_alarm("tuesday", weekday_alarm, wake_alarm_handler, NULL);
+        weekday_alarm.day = 3;
+        alarm_manager_set_alarm("wednesday", weekday_alarm, wake_alarm_handler, NULL);
+        weekday_alarm.day = 4;
+        alarm_manager_set_alarm("thursday", weekday_alarm, wake_alarm_handler, NULL);
+        weekday_alarm.day = 5;
+        alarm_manager_set_alarm("friday", weekday_alarm, wake_alarm_handler, NULL);
+        ESP_LOGI(TAG, "Alarms set.");
+    } else {
+        ESP_LOGI(TAG, "Restored %d alarms from NVS.", alarm_manager_count());
+    }
 }
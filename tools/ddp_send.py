@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""DDP test-pattern sender for the lamp's stream mode.
+
+Sends a moving rainbow at a fixed frame rate and marks every Nth frame as a
+latency probe (DDP QUERY flag). The lamp answers a probe once that frame has
+been transmitted to the LEDs, so the round trip covers network + parse +
+frame copy + LED transmit.
+
+    # against the lamp (start stream mode first, e.g. via the control API)
+    curl -d 'mode=stream' http://<ip>:8080/api/animation
+    tools/ddp_send.py <ip> --leds 32 --fps 60 --seconds 10
+
+    # host-only: a local stand-in receiver answers probes and counts loss
+    tools/ddp_send.py --loopback --leds 32 --fps 60 --seconds 5
+"""
+import argparse
+import colorsys
+import json
+import socket
+import statistics
+import struct
+import threading
+import time
+import urllib.request
+
+DDP_PORT = 4048
+FLAG_VER1 = 0x40
+FLAG_REPLY = 0x04
+FLAG_QUERY = 0x02
+FLAG_PUSH = 0x01
+TYPE_RGB8 = 0x0B
+TYPE_RGBW8 = 0x1B
+MAX_DATA = 1440  # 480 RGB / 360 RGBW pixels per packet
+
+
+def ddp_packets(frame, seq, bpp, query):
+    """Split one frame into DDP packets; PUSH (and QUERY) on the last one."""
+    chunk = MAX_DATA - MAX_DATA % bpp
+    out = []
+    for off in range(0, len(frame), chunk):
+        data = frame[off:off + chunk]
+        last = off + chunk >= len(frame)
+        flags = FLAG_VER1 | (FLAG_PUSH if last else 0) | (FLAG_QUERY if last and query else 0)
+        hdr = struct.pack(">BBBBIH", flags, seq, TYPE_RGBW8 if bpp == 4 else TYPE_RGB8, 1, off, len(data))
+        out.append(hdr + data)
+        seq = seq % 15 + 1
+    return out, seq
+
+
+def rainbow(leds, bpp, t):
+    frame = bytearray()
+    for i in range(leds):
+        r, g, b = colorsys.hsv_to_rgb((t * 0.2 + i / leds) % 1.0, 1.0, 0.5)
+        frame += bytes((int(r * 255), int(g * 255), int(b * 255)))
+        if bpp == 4:
+            frame.append(0)
+    return bytes(frame)
+
+
+class LoopbackReceiver(threading.Thread):
+    """Stand-in for the lamp: parses DDP, tracks sequence gaps, answers probes."""
+
+    def __init__(self, port):
+        super().__init__(daemon=True)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(("127.0.0.1", port))
+        self.sock.settimeout(0.2)
+        self.frames = self.lost = 0
+        self.running = True
+        self.last_seq = 0
+
+    def run(self):
+        while self.running:
+            try:
+                pkt, addr = self.sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            flags, seq = pkt[0], pkt[1] & 0x0F
+            if flags & 0xC0 != FLAG_VER1:
+                continue
+            if self.last_seq and seq:
+                self.lost += max(0, (seq - self.last_seq + 15) % 15 - 1)
+            self.last_seq = seq or self.last_seq
+            if flags & FLAG_PUSH:
+                self.frames += 1
+            if flags & FLAG_QUERY:
+                self.sock.sendto(bytes((FLAG_VER1 | FLAG_REPLY | FLAG_PUSH, seq, pkt[2], pkt[3])) + bytes(6), addr)
+
+
+def fetch_stream_stats(host, api_port):
+    try:
+        with urllib.request.urlopen(f"http://{host}:{api_port}/api/status", timeout=2) as r:
+            return json.load(r).get("stream")
+    except OSError:
+        return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("host", nargs="?", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=DDP_PORT)
+    ap.add_argument("--leds", type=int, default=32)
+    ap.add_argument("--rgbw", action="store_true", help="send 4 bytes per pixel")
+    ap.add_argument("--fps", type=float, default=60)
+    ap.add_argument("--seconds", type=float, default=10)
+    ap.add_argument("--probe-every", type=int, default=10, help="frames between latency probes")
+    ap.add_argument("--api-port", type=int, default=8080, help="control API port for device-side counters")
+    ap.add_argument("--loopback", action="store_true", help="run against a local stand-in receiver")
+    args = ap.parse_args()
+
+    receiver = None
+    if args.loopback:
+        args.host = "127.0.0.1"
+        receiver = LoopbackReceiver(args.port)
+        receiver.start()
+
+    bpp = 4 if args.rgbw else 3
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setblocking(False)
+    before = None if args.loopback else fetch_stream_stats(args.host, args.api_port)
+
+    probes = {}   # seq of the pushed packet -> send time
+    rtts = []
+    seq, frames = 1, 0
+    period = 1.0 / args.fps
+    start = next_t = time.perf_counter()
+    while time.perf_counter() - start < args.seconds:
+        query = frames % args.probe_every == 0
+        pkts, next_seq = ddp_packets(rainbow(args.leds, bpp, next_t - start), seq, bpp, query)
+        for p in pkts:
+            sock.sendto(p, (args.host, args.port))
+        if query:
+            probes[pkts[-1][1]] = time.perf_counter()
+        seq, frames = next_seq, frames + 1
+
+        next_t += period
+        while True:
+            try:
+                reply, _ = sock.recvfrom(64)
+                if reply[0] & FLAG_REPLY and reply[1] in probes:
+                    rtts.append((time.perf_counter() - probes.pop(reply[1])) * 1000)
+            except BlockingIOError:
+                pass
+            if time.perf_counter() >= next_t:
+                break
+            time.sleep(min(0.001, max(0, next_t - time.perf_counter())))
+
+    time.sleep(0.3)  # let the last replies arrive
+    sent_probes = (frames + args.probe_every - 1) // args.probe_every
+    print(f"sent {frames} frames ({args.leds} LEDs, {bpp} B/px) at {frames / args.seconds:.1f} fps")
+    if rtts:
+        rtts.sort()
+        p95 = rtts[min(len(rtts) - 1, int(len(rtts) * 0.95))]
+        print(f"latency (send -> on LEDs -> reply): min {rtts[0]:.2f} ms  avg {statistics.mean(rtts):.2f} ms  "
+              f"p95 {p95:.2f} ms  max {rtts[-1]:.2f} ms")
+    print(f"probes answered {len(rtts)}/{sent_probes}")
+
+    if receiver:
+        receiver.running = False
+        print(f"receiver: {receiver.frames} frames shown, {receiver.lost} packets lost, "
+              f"{frames - receiver.frames} frames dropped")
+    else:
+        after = fetch_stream_stats(args.host, args.api_port)
+        if before and after:
+            shown = after["frames"] - before["frames"]
+            print(f"device: {shown} frames shown, {after['lost'] - before['lost']} packets lost, "
+                  f"{frames - shown} frames dropped")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""Frame-jitter probe: measures the render task's frame pacing while the lamp
+is under Wi-Fi load.
+
+Starts a fixed-rate animation through the control API, floods the lamp with
+UDP (and optionally concurrent HTTP requests) for a while, and reports the
+jitter histogram accumulated during that window from /api/status. Run it once
+with --load none for the idle baseline, then with load; repeat on a build with
+the old task layout (render/dispatcher core -1, priority 5/6 in menuconfig) to
+compare.
+
+    tools/jitter_load.py <ip> --seconds 20 --load udp --mbps 8
+    tools/jitter_load.py <ip> --seconds 20 --load both --http-clients 4
+"""
+import argparse
+import json
+import socket
+import threading
+import time
+import urllib.parse
+import urllib.request
+
+BUCKETS = ["<250us", "<1ms", "<2ms", "<5ms", ">=5ms"]
+DISCARD_PORT = 9     # nothing listens: every datagram still crosses Wi-Fi and lwIP
+
+
+def api(host, port, path, form=None):
+    data = urllib.parse.urlencode(form).encode() if form else None
+    with urllib.request.urlopen(f"http://{host}:{port}{path}", data=data, timeout=3) as r:
+        return json.load(r)
+
+
+def udp_flood(host, port, mbps, seconds, stop):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    payload = bytes(1400)
+    interval = len(payload) * 8 / (mbps * 1e6)
+    sent, next_t = 0, time.perf_counter()
+    end = next_t + seconds
+    while not stop.is_set() and time.perf_counter() < end:
+        sock.sendto(payload, (host, port))
+        sent += 1
+        next_t += interval
+        delay = next_t - time.perf_counter()
+        if delay > 0:
+            time.sleep(delay)
+    return sent
+
+
+def http_client(host, port, stop, counts):
+    while not stop.is_set():
+        try:
+            api(host, port, "/api/status")
+            counts[0] += 1
+        except OSError:
+            counts[1] += 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("host")
+    ap.add_argument("--api-port", type=int, default=8080)
+    ap.add_argument("--seconds", type=float, default=20)
+    ap.add_argument("--mode", default="rainbow_smooth", help="fixed-rate animation to measure")
+    ap.add_argument("--load", choices=["none", "udp", "http", "both"], default="udp")
+    ap.add_argument("--mbps", type=float, default=8, help="UDP flood rate")
+    ap.add_argument("--http-clients", type=int, default=4)
+    args = ap.parse_args()
+
+    api(args.host, args.api_port, "/api/animation", {"mode": args.mode})
+    time.sleep(1.0)   # let the cadence settle
+    before = api(args.host, args.api_port, "/api/status")["render"]
+
+    stop = threading.Event()
+    http_counts = [0, 0]
+    clients = []
+    if args.load in ("http", "both"):
+        for _ in range(args.http_clients):
+            t = threading.Thread(target=http_client, args=(args.host, args.api_port, stop, http_counts), daemon=True)
+            t.start()
+            clients.append(t)
+    sent = 0
+    if args.load in ("udp", "both"):
+        sent = udp_flood(args.host, DISCARD_PORT, args.mbps, args.seconds, stop)
+    else:
+        time.sleep(args.seconds)
+    stop.set()
+    for t in clients:
+        t.join(timeout=5)
+
+    after = api(args.host, args.api_port, "/api/status")["render"]
+    frames = after["frames"] - before["frames"]
+    hist = [a - b for a, b in zip(after["jitter_hist"], before["jitter_hist"])]
+    print(f"load: {args.load}", end="")
+    if sent:
+        print(f", {sent} UDP datagrams ({sent * 1400 * 8 / args.seconds / 1e6:.1f} Mbit/s)", end="")
+    if clients:
+        print(f", {http_counts[0]} HTTP requests ({http_counts[1]} failed)", end="")
+    print()
+    if frames <= 0:
+        print("no paced frames rendered; is a fixed-rate animation running?")
+        return
+    mean = (after["jitter_sum_us"] - before["jitter_sum_us"]) / frames
+    print(f"frames {frames} ({frames / args.seconds:.1f} fps), mean jitter {mean:.0f} us, "
+          f"max since boot {after['jitter_max_us']} us")
+    for name, n in zip(BUCKETS, hist):
+        print(f"  {name:>7} {n:7d}  {100.0 * n / frames:5.1f}%")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""End-to-end latencies from the lamp's event trace (components/trace).
+
+Reads Chrome trace JSON, either fetched from the control API or written by the
+host simulator (color_alarm_sim --events), and reports:
+
+  button -> photon   button ISR edge to the end of the first LED frame that
+                     differs from the one shown before the edge
+  alarm -> photon    alarm due (fired by alarm_tick) to the same
+  sntp -> re-arm     SNTP sync to the alarm scheduler re-arming its timer
+
+"Differs" compares the frame tags the driver records (a hash of the pixels
+and the brightness cap), so an input that changes nothing on the strip has
+no photon latency, and while an animation runs every frame differs: measure
+from a static lamp. The ring only holds a few seconds of frames: clear it,
+trigger, then fetch.
+
+    tools/trace_latency.py <ip> --clear     # forget old events, then trigger
+    tools/trace_latency.py <ip> -o trace.json
+    tools/trace_latency.py --file trace.json
+"""
+import argparse
+import json
+import urllib.request
+
+
+def fetch(host, port, method="GET"):
+    req = urllib.request.Request(f"http://{host}:{port}/api/trace", method=method)
+    with urllib.request.urlopen(req, timeout=10) as r:
+        return r.read()
+
+
+def frames(events):
+    """(tag, begin_ts, end_ts) per shown LED frame, in time order"""
+    out, open_tag = [], None
+    for e in events:
+        if e["name"] != "led_show":
+            continue
+        if e["ph"] == "B":
+            open_tag = (e["args"]["arg"], e["ts"])
+        elif e["ph"] == "E" and open_tag and e["args"]["arg"]:
+            out.append((open_tag[0], open_tag[1], e["ts"]))
+            open_tag = None
+    return out
+
+
+def photon_after(shown, ts):
+    """End time of the first frame after ts that looks different, or None"""
+    before = None
+    for tag, begin, end in shown:
+        if begin < ts:
+            before = tag
+        elif tag != before:
+            return end
+    return None
+
+
+def latencies(events, start, shown=None, until=None):
+    out = []
+    for e in events:
+        if e["name"] != start:
+            continue
+        if shown is not None:
+            t = photon_after(shown, e["ts"])
+        else:
+            t = next((u["ts"] for u in events if u["name"] == until and u["ts"] >= e["ts"]), None)
+        out.append(None if t is None else t - e["ts"])
+    return out
+
+
+def report(label, values):
+    got = [v for v in values if v is not None]
+    if not values:
+        print(f"{label:16} no events")
+        return
+    line = f"{label:16} {len(got)} of {len(values)}"
+    if got:
+        got.sort()
+        line += (f"  min {got[0] / 1000:.1f} ms  median {got[len(got) // 2] / 1000:.1f} ms"
+                 f"  max {got[-1] / 1000:.1f} ms")
+    print(line)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("host", nargs="?")
+    ap.add_argument("--api-port", type=int, default=8080)
+    ap.add_argument("--file", help="read a saved trace instead of fetching one")
+    ap.add_argument("-o", "--output", help="also save the fetched trace")
+    ap.add_argument("--clear", action="store_true", help="clear the lamp's trace and exit")
+    args = ap.parse_args()
+    if not args.file and not args.host:
+        ap.error("need a host or --file")
+
+    if args.clear:
+        fetch(args.host, args.api_port, "DELETE")
+        return
+    if args.file:
+        with open(args.file) as f:
+            trace = json.load(f)
+    else:
+        raw = fetch(args.host, args.api_port)
+        if args.output:
+            with open(args.output, "wb") as f:
+                f.write(raw)
+        trace = json.loads(raw)
+
+    events = sorted((e for e in trace["traceEvents"] if e["ph"] != "M"), key=lambda e: e["ts"])
+    shown = frames(events)
+    dropped = trace.get("otherData", {}).get("dropped", 0)
+    span = (events[-1]["ts"] - events[0]["ts"]) / 1e6 if events else 0
+    print(f"{len(events)} events over {span:.1f} s, {len(shown)} frames, {dropped} dropped")
+    report("button -> photon", latencies(events, "button_edge", shown=shown))
+    report("alarm -> photon", latencies(events, "alarm_due", shown=shown))
+    report("sntp -> re-arm", latencies(events, "sntp_sync", until="alarm_rearm"))
+
+
+if __name__ == "__main__":
+    main()